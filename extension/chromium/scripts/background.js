@@ -110,6 +110,12 @@ chrome.runtime.onConnect.addListener((contentPort) =>
 
             let requestId = msg.i;
             msg.i = packMessageId(senderId, requestId);
+
+            // [Cancel] refers to another request of the same tab.
+            if (typeof msg.t === 'string')
+            {
+                msg.t = packMessageId(senderId, msg.t);
+            }
             console.log(`>> ${JSON.stringify(msg)}`);
 
             if (!nativePort)
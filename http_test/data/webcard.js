@@ -9,6 +9,54 @@
 
     const WEBCARD_HOMEPAGE = 'https://webcard.cardid.org';
 
+    /**************************************************************************/
+    // Binary APDUs (`Uint8Array` or `ArrayBuffer`) are sent in Base64
+    // (key "b" instead of "a"), and their responses are decoded back
+    // into `Uint8Array` objects, without any hex-strings on the way.
+    function isBinaryApdu(apdu)
+    {
+        return (apdu instanceof Uint8Array) || (apdu instanceof ArrayBuffer);
+    }
+
+    function bytesToBase64(apdu)
+    {
+        const bytes = new Uint8Array(apdu);
+        let binary = '';
+
+        // Limited number of arguments for `String.fromCharCode()`.
+        for (let i = 0; i < bytes.length; i += 0x8000)
+        {
+            binary += String.fromCharCode(...bytes.subarray(i, i + 0x8000));
+        }
+
+        return btoa(binary);
+    }
+
+    function base64ToBytes(text)
+    {
+        const binary = atob(text);
+        const bytes = new Uint8Array(binary.length);
+
+        for (let i = 0; i < binary.length; i++)
+        {
+            bytes[i] = binary.charCodeAt(i);
+        }
+
+        return bytes;
+    }
+
+    /**************************************************************************/
+    // Optional handling of APDUs by the Native App (key "h"):
+    // `fixLe` sends an APDU again after "6Cxx" (wrong Le), with the right Le;
+    // `chaining` splits extended APDUs (more than 255 bytes of data)
+    // into short APDUs, linked with the command chaining bit of CLA.
+    function apduHandling(options)
+    {
+        const flags = (options?.fixLe ? 1 : 0) | (options?.chaining ? 2 : 0);
+
+        return (0 !== flags) ? { h: flags } : {};
+    }
+
     /**************************************************************************/
     // `Reader` class.
     function Reader(index, name, atr)
@@ -26,8 +74,32 @@
         self.disconnect = () =>
             navigator.webcard.send(3, { r: self.index });
 
-        self.transceive = (apdu) =>
-            navigator.webcard.send(4, { r: self.index, a: apdu });
+        self.transceive = (apdu, options) =>
+            isBinaryApdu(apdu) ?
+                navigator.webcard.send(4,
+                    { r: self.index, b: bytesToBase64(apdu), ...apduHandling(options) },
+                    base64ToBytes) :
+                navigator.webcard.send(4,
+                    { r: self.index, a: apdu, ...apduHandling(options) });
+
+        self.transceiveEx = (apdu, options) =>
+            isBinaryApdu(apdu) ?
+                navigator.webcard.sendEx(4,
+                    { r: self.index, b: bytesToBase64(apdu), ...apduHandling(options) },
+                    base64ToBytes) :
+                navigator.webcard.sendEx(4,
+                    { r: self.index, a: apdu, ...apduHandling(options) });
+
+        self.transceiveBatch = (apdus, stopOnError, options) =>
+            ((apdus.length > 0) && apdus.every(isBinaryApdu)) ?
+                navigator.webcard.send(6,
+                    { r: self.index, b: apdus.map(bytesToBase64), s: !!stopOnError, ...apduHandling(options) },
+                    (responses) => responses.map(base64ToBytes)) :
+                navigator.webcard.send(6,
+                    { r: self.index, a: apdus, s: !!stopOnError, ...apduHandling(options) });
+
+        self.runScript = (steps, options) =>
+            navigator.webcard.send(7, { r: self.index, a: steps, ...apduHandling(options) });
     }
 
     /**************************************************************************/
@@ -57,8 +129,9 @@
         self.randomUid = () =>
             Date.now().toString(36) + Math.random().toString(36).substring(2, 7);
 
-        // Command-sending wrapper method.
-        self.send = (cmdIdx, otherParams) =>
+        // Command-sending wrapper method
+        // (optional `decode` function converts the response data).
+        self.send = (cmdIdx, otherParams, decode) =>
         {
             if (!self.isReady)
             {
@@ -72,7 +145,7 @@
 
                 self.pendingRequests.set(
                     uid,
-                    { c: cmdIdx, resolve: resolve, reject: reject });
+                    { c: cmdIdx, resolve: resolve, reject: reject, decode: decode });
 
                 try
                 {
@@ -93,8 +166,9 @@
             });
         }
 
-        // Command-sending wrapper method.
-        self.sendEx = (cmdIdx, otherParams) =>
+        // Command-sending wrapper method
+        // (optional `decode` function converts the response data).
+        self.sendEx = (cmdIdx, otherParams, decode) =>
         {
             if (!self.isReady)
             {
@@ -112,7 +186,7 @@
                 {
                     self.pendingRequests.set(
                         uid,
-                        { c: cmdIdx, resolve: resolve, reject: reject });
+                        { c: cmdIdx, resolve: resolve, reject: reject, decode: decode });
 
                     try
                     {
@@ -176,6 +250,10 @@
         self.readers = () =>
             self.send(1);
 
+        // Cancels a pending request (`uid` returned by `sendEx()`).
+        self.cancel = (uid) =>
+            self.send(5, { t: uid });
+
         // Handling content script (Native App) responses.
         self.responseCallback = (msg) =>
         {
@@ -246,7 +324,14 @@
                 return;
             }
 
-            if (msg.incomplete)
+            if (msg.cancelled && msg.incomplete)
+            {
+                // Request cancelled with `cancel()`
+                // (a request that has already taken effect on the card
+                // is answered with its real result instead).
+                request.reject('cancelled');
+            }
+            else if (msg.incomplete)
             {
                 // Response marked as incomplete
                 // (error on the Native App's side).
@@ -277,12 +362,14 @@
                     break;
                 }
 
-                // [Connect] and [Transceive]
-                case 2: case 4:
+                // [Connect], [Transceive], [Transceive Batch] and [Run Script]
+                case 2: case 4: case 6: case 7:
                 {
                     if (msg.d)
                     {
-                        request.resolve(msg.d);
+                        request.resolve(request.decode ?
+                            request.decode(msg.d) :
+                            msg.d);
                     }
                     else
                     {
@@ -292,6 +379,13 @@
                     break;
                 }
 
+                // [Cancel]
+                case 5:
+                {
+                    request.resolve(msg.d === true);
+                    break;
+                }
+
                 // [Get Version]
                 case 10:
                 {
@@ -15,12 +15,155 @@ extern "C" {
 #endif
 
 
+/**************************************************************/
+/* JSON ARENA                                                 */
+/**************************************************************/
+
+/**
+ * Default size (in bytes) of the memory blocks owned by a `JsonArena`
+ * (larger allocations get a dedicated block).
+ */
+#define JSON_ARENA__BLOCK_SIZE  0x00004000
+
+/**
+ * `JsonArenaBlock` type definition.
+ */
+typedef struct JsonArenaBlock JsonArenaBlock;
+
+/**
+ * One contiguous memory region of a `JsonArena`.
+ */
+struct JsonArenaBlock
+{
+  /** Next block (`NULL` for the last block). */
+  JsonArenaBlock *next;
+
+  /** Number of bytes available in `data`. */
+  size_t capacity;
+
+  /** Number of bytes already handed out from `data`. */
+  size_t used;
+
+  /** Memory handed out by the arena. */
+  BYTE data[];
+};
+
+/**
+ * `JsonArena` type definition.
+ */
+typedef struct JsonArena JsonArena;
+
+/**
+ * Bump allocator for short-lived JSON trees (for example, a single JSON
+ * Request with its JSON Response). While an arena is attached to the
+ * current thread, `JsonObject`, `JsonArray`, `JsonPair` and `JsonValue`
+ * memory is taken from the arena. Destructors do not release that memory,
+ * it is reclaimed at once by `JsonArena_reset`.
+ */
+struct JsonArena
+{
+  /** First block (kept between resets). */
+  JsonArenaBlock *first;
+
+  /** Block used for the next allocation. */
+  JsonArenaBlock *current;
+
+  /** The most recent allocation (can be resized in place). */
+  LPVOID last;
+};
+
+/**
+ * @brief `JsonArena` constructor.
+ *
+ * @param[out] arena Reference to an UNINITIALIZED `JsonArena` object.
+ */
+extern VOID
+JsonArena_init(
+  _Out_ JsonArena *arena);
+
+/**
+ * @brief `JsonArena` destructor.
+ *
+ * @param[in,out] arena Reference to a VALID `JsonArena` object.
+ *
+ * @note The arena must not be attached to any thread during this call.
+ */
+extern VOID
+JsonArena_destroy(
+  _Inout_ JsonArena *arena);
+
+/**
+ * @brief Reclaims all the memory handed out by the arena
+ * (the first block is kept for the next JSON tree).
+ *
+ * @param[in,out] arena Reference to a VALID `JsonArena` object.
+ *
+ * @note JSON objects built in the arena must not be used after this call
+ * (destroying them first is allowed, but not required).
+ */
+extern VOID
+JsonArena_reset(
+  _Inout_ JsonArena *arena);
+
+/**
+ * @brief Attaches an arena to the current thread.
+ *
+ * @param[in] arena Reference to a VALID `JsonArena` object,
+ * or `NULL` to go back to the regular heap allocations.
+ * @return The previously attached arena (can be `NULL`).
+ *
+ * @note JSON objects built in an arena shall be destroyed while that arena
+ * is still attached, or not at all (see `JsonArena_reset`).
+ */
+extern JsonArena *
+JsonArena_attach(
+  _In_opt_ JsonArena *arena);
+
+/**
+ * @brief Allocates memory for JSON objects
+ * (from the attached arena, or from the heap).
+ *
+ * @param[in] size Requested number of bytes.
+ * @return Pointer to the allocated memory, or `NULL` on failure.
+ */
+extern LPVOID
+JsonArena_allocate(
+  _In_ const size_t size);
+
+/**
+ * @brief Resizes memory allocated with `JsonArena_allocate`.
+ *
+ * @param[in] memory Previous allocation (can be `NULL`).
+ * @param[in] oldSize Size of the previous allocation.
+ * @param[in] newSize Requested number of bytes.
+ * @return Pointer to the resized memory, or `NULL` on failure
+ * (in which case `memory` is still valid).
+ *
+ * @note Heap memory stays on the heap, even if an arena is attached.
+ */
+extern LPVOID
+JsonArena_reallocate(
+  _In_opt_ LPVOID memory,
+  _In_ const size_t oldSize,
+  _In_ const size_t newSize);
+
+/**
+ * @brief Releases memory allocated with `JsonArena_allocate`
+ * (memory that belongs to the attached arena is left for the reset).
+ *
+ * @param[in] memory Previous allocation (can be `NULL`).
+ */
+extern VOID
+JsonArena_release(
+  _In_opt_ LPVOID memory);
+
+
 /**************************************************************/
 /* JSON BYTE STREAM                                           */
 /**************************************************************/
 
 /**
- * Possible return values for `JsonByteStream_loadFromStandardInput` function.
+ * Possible return values for `JsonInputBuffer` functions.
  */
 
   /** Bytes successfully loaded from STDIN stream. */
@@ -32,6 +175,16 @@ extern "C" {
   /** No more bytes, loading error, memory alocation error. */
   #define JSON_STREAM_STATUS__NO_MORE  2
 
+  /** Message skipped (not a valid UTF-8 text, or too long). */
+  #define JSON_STREAM_STATUS__INVALID  3
+
+/**
+ * How many JSON Objects and JSON Arrays can be nested in one message
+ * (including the message itself), when it is parsed or skipped.
+ * Bounds the recursion of the parser.
+ */
+#define JSON_BYTE_STREAM__MAX_DEPTH  32
+
 /**
  * `JsonByteStream` type definition.
  */
@@ -46,7 +199,7 @@ struct JsonByteStream
   /** Number of bytes present in the stream */
   size_t head_length;
 
-  /** Bytes passed from Standard Input (dynamic allocation) */
+  /** Bytes passed from Standard Input (borrowed from `JsonInputBuffer`) */
   LPBYTE head;
 
   /** Number of incoming bytes */
@@ -54,29 +207,10 @@ struct JsonByteStream
 
   /** Bytes left to process */
   LPBYTE tail;
-};
-
-/**
- * @brief Prepares a `JsonByteStream` object to parse a stringified JSON.
- *
- * Checks if there is any data incoming on Standard Input. If so, attempts
- * to read the STDIN contents and store them for further processing.
- * @param[out] stream Reference to an UNINITIALIZED `JsonByteStream` object.
- * @return `JSON_STREAM_STATUS__VALID` if the stream is allocated and ready,
- * otherwise the object is left uninitialized.
- */
-int
-JsonByteStream_loadFromStandardInput(
-  _Out_ JsonByteStream *stream);
 
-/**
- * @brief `JsonByteStream` destructor.
- *
- * @param[in,out] stream Reference to a VALID `JsonByteStream` object.
- */
-extern VOID
-JsonByteStream_destroy(
-  _Inout_ JsonByteStream *stream);
+  /** Number of JSON Objects and JSON Arrays that are currently open */
+  size_t depth;
+};
 
 /**
  * @brief Peeks next byte without removing it from the stream.
@@ -131,6 +265,28 @@ extern BOOL
 JsonByteStream_skipWhitespace(
   _Inout_ JsonByteStream *stream);
 
+/**
+ * @brief Notes that a JSON Object or a JSON Array was opened
+ * (its opening bracket has just been read).
+ *
+ * @param[in,out] stream Reference to a VALID `JsonByteStream` object.
+ * @return `TRUE` on success, `FALSE` if more than
+ * `JSON_BYTE_STREAM__MAX_DEPTH` containers would be nested.
+ */
+extern BOOL
+JsonByteStream_enter(
+  _Inout_ JsonByteStream *stream);
+
+/**
+ * @brief Notes that a JSON Object or a JSON Array was closed
+ * (its closing bracket has just been read).
+ *
+ * @param[in,out] stream Reference to a VALID `JsonByteStream` object.
+ */
+extern VOID
+JsonByteStream_leave(
+  _Inout_ JsonByteStream *stream);
+
 
 /**************************************************************/
 /* JSON STRING                                                */
@@ -142,6 +298,11 @@ JsonByteStream_skipWhitespace(
  *
  * Given stream should start with quotation mark (whitespace already skipped).
  * "JSON String" should be presented according to the JSON specification.
+ * A string without escape sequences becomes a view into the stream
+ * (see `UTF8String_makeView`), so it is valid only as long as the stream's
+ * memory. Otherwise, the unescaped text is copied.
+ * Multibyte codepoints are not checked here: the stream must already hold
+ * a valid UTF-8 text (see `JsonInputBuffer_nextMessage`).
  * @param[out] result Points to a memory location that will hold
  * a new `UTF8String` object. `result` is always a VALID pointer,
  * while `result[0]` depends on the `allocate` argument.
@@ -162,6 +323,18 @@ JsonString_parse(
   _In_ const BOOL allocate,
   _Inout_ JsonByteStream *stream);
 
+/**
+ * @brief Skips a stringified JSON String, without loading it.
+ *
+ * Given stream should start with quotation mark (whitespace already skipped).
+ * Escape sequences are not checked, and nothing is copied.
+ * @param[in,out] stream Reference to a VALID `JsonByteStream` object.
+ * @return `TRUE` on success, `FALSE` on any parsing error.
+ */
+extern BOOL
+JsonString_skip(
+  _Inout_ JsonByteStream *stream);
+
 /**
  * @brief Saves `UTS8String` object to it's UTF-8
  * (stringified JSON) representation.
@@ -170,7 +343,8 @@ JsonString_parse(
  * is appended to the `UTF8String` object under the `output` argument.
  * @param[in] string Reference to a VALID and CONSTANT `UTF8String` object.
  * @param[in,out] output Reference to a VALID `UTF8String` object.
- * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * OR when the string is not a valid UTF-8 text.
  */
 extern BOOL
 JsonString_toString(
@@ -200,17 +374,110 @@ JsonString_toString(
 typedef struct JsonValue JsonValue;
 
 /**
- * Represents a dynamically-allocated JSON Value (unnamed JSON Object,
- * unnamed JSON Array, unnamed JSON String, unnamed JSON Number,
- * unnamed JSON Boolean).
+ * `JsonNumber` type definition.
+ */
+typedef struct JsonNumber JsonNumber;
+
+/**
+ * JSON Number, stored as an exact 64-bit integer whenever possible.
+ */
+struct JsonNumber
+{
+  /**
+   * Exact value when `isInteger` is set. Otherwise, `real` truncated
+   * towards zero (and clamped to the `int64_t` range).
+   */
+  int64_t integer;
+
+  /** Value converted to (or parsed as) a double-precision number. */
+  DOUBLE real;
+
+  /**
+   * `TRUE` if the number was written without a fraction and an exponent,
+   * and it fits in the `int64_t` range.
+   */
+  BOOL isInteger;
+};
+
+/**
+ * `JsonArray` type definition.
+ */
+typedef struct JsonArray JsonArray;
+
+/**
+ * JSON Array represents an array of ordered JSON Values.
+ */
+struct JsonArray
+{
+  /** Number of valid elements (`JsonValue` structures). */
+  size_t count;
+
+  /** Total number of allocated elements (`JsonValue` structures). */
+  size_t capacity;
+
+  /**
+   * Contiguous (dynamically allocated) memory block of
+   * `JsonValue` structures.
+   */
+  JsonValue *values;
+};
+
+/**
+ * `JsonPair` type definition.
+ */
+typedef struct JsonPair JsonPair;
+
+/**
+ * `JsonObject` type definition.
+ */
+typedef struct JsonObject JsonObject;
+
+/**
+ * JSON Object represents an object which contains
+ * unordered JSON Key-Value pairs.
+ */
+struct JsonObject
+{
+  /** Number of valid elements (`JsonPair` structures). */
+  size_t count;
+
+  /** Total number of allocated elements (`JsonPair` structures). */
+  size_t capacity;
+
+  /**
+   * Contiguous (dynamically allocated) memory block of
+   * `JsonPair` structures.
+   */
+  JsonPair *pairs;
+};
+
+/**
+ * Represents a JSON Value (unnamed JSON Object, unnamed JSON Array,
+ * unnamed JSON String, unnamed JSON Number, unnamed JSON Boolean).
+ *
+ * Numbers and headers of strings, arrays, and objects are stored inline.
+ * Only the string text and the elements of arrays and objects
+ * are allocated separately.
  */
 struct JsonValue
 {
-  /** Type of this value (determines which functions to use). */
+  /** Type of this value (determines which union member is valid). */
   int type;
 
-  /** Pointer to some data block (depends on the type). */
-  void *value;
+  union
+  {
+    /** Valid for `JSON_VALUE_TYPE__NUMBER`. */
+    JsonNumber number;
+
+    /** Valid for `JSON_VALUE_TYPE__STRING`. */
+    UTF8String string;
+
+    /** Valid for `JSON_VALUE_TYPE__ARRAY`. */
+    JsonArray array;
+
+    /** Valid for `JSON_VALUE_TYPE__OBJECT`. */
+    JsonObject object;
+  };
 };
 
 /**
@@ -255,12 +522,12 @@ JsonValue_copy(
 /**
  * @brief Loads JSON Number by parsing it's stringified representation.
  *
- * Validates the string representation of a floating-point number.
- * Then, uses `strtof()` function to convert extracted text to a number.
+ * Validates the string representation of a number while accumulating
+ * its integer digits. Only numbers with a fraction, an exponent,
+ * or too many digits are converted by the `strtod()` function.
  * @param[in,out] value Reference to an UNINITIALIZED `JsonValue` object.
  * @param[in,out] stream Reference to a VALID `JsonByteStream` object.
- * @return `TRUE` on success, `FALSE` on memory allocation failure OR
- * on invalid floating-point number text format.
+ * @return `TRUE` on success, `FALSE` on invalid number text format.
  *
  * @note As for now, the stringified JSON Number cannot exists solely
  * at the end of `JsonByteStream`. The string representation must end on
@@ -274,6 +541,18 @@ JsonValue_parseNumber(
   _Inout_ JsonValue *value,
   _Inout_ JsonByteStream *stream);
 
+/**
+ * @brief Turns `JsonValue` object into an integer JSON Number.
+ *
+ * @param[out] value Reference to a `JsonValue` object that does not
+ * own any memory (initialized, or holding a number or a literal).
+ * @param[in] integer Number to be stored.
+ */
+extern VOID
+JsonValue_setInteger(
+  _Out_ JsonValue *value,
+  _In_ const int64_t integer);
+
 /**
  * @brief Loads `JsonValue` object by parsing it's UTF-8
  * (stringified JSON) representation.
@@ -301,6 +580,19 @@ JsonValue_parse(
   _In_ const BOOL allocate,
   _Inout_ JsonByteStream *stream);
 
+/**
+ * @brief Skips a stringified JSON Value, without loading it.
+ *
+ * Given stream can start with whitespace characters. The structure of nested
+ * JSON Objects and JSON Arrays is checked, but no `JsonValue` is built
+ * (so no memory is allocated, see `JsonString_skip`).
+ * @param[in,out] stream Reference to a VALID `JsonByteStream` object.
+ * @return `TRUE` on success, `FALSE` on any parsing error.
+ */
+extern BOOL
+JsonValue_skip(
+  _Inout_ JsonByteStream *stream);
+
 /**
  * @brief Saves `JsonValue` object to it's UTF-8
  * (stringified JSON) representation.
@@ -321,29 +613,6 @@ JsonValue_toString(
 /* JSON ARRAY                                                 */
 /**************************************************************/
 
-/**
- * `JsonArray` type definition.
- */
-typedef struct JsonArray JsonArray;
-
-/**
- * JSON Array represents an array of ordered JSON Values.
- */
-struct JsonArray
-{
-  /** Number of valid elements (`JsonValue` structures). */
-  size_t count;
-
-  /** Total number of allocated elements (`JsonValue` structures). */
-  size_t capacity;
-
-  /**
-   * Contiguous (dynamically allocated) memory block of
-   * `JsonValue` structures.
-   */
-  JsonValue *values;
-};
-
 /**
  * @brief `JsonArray` constructor.
  *
@@ -398,6 +667,24 @@ JsonArray_append(
   _Inout_ JsonArray *array,
   _In_ const JsonValue *value);
 
+/**
+ * @brief Appends `JsonValue` to `JsonArray` by taking over its contents
+ * (strings, nested objects and arrays are moved, not copied).
+ *
+ * @param[in,out] array Reference to a VALID `JsonArray` object.
+ * @param[in,out] value Reference to a VALID `JsonValue` object.
+ * On success, it is left as an empty (`null`) JSON Value.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * (then `value` is left untouched and still owned by the caller).
+ *
+ * @note Borrowed views (eg. strings pointing into the input buffer)
+ * stay borrowed, so the array must not outlive the borrowed data.
+ */
+extern BOOL
+JsonArray_appendTake(
+  _Inout_ JsonArray *array,
+  _Inout_ JsonValue *value);
+
 /**
  * @brief Loads `JsonArray` object by parsing it's UTF-8
  * (stringified JSON) representation.
@@ -422,6 +709,7 @@ JsonArray_append(
 extern BOOL
 JsonArray_parse(
   _Outptr_result_maybenull_ JsonArray **const result,
+  _In_ const BOOL allocate,
   _Inout_ JsonByteStream *stream);
 
 /**
@@ -444,11 +732,6 @@ JsonArray_toString(
 /* JSON PAIR                                                  */
 /**************************************************************/
 
-/**
- * `JsonPair` type definition.
- */
-typedef struct JsonPair JsonPair;
-
 /**
  * Represents a dynamically-allocated Key-Value Pair
  * (JSON String with a JSON Value).
@@ -548,30 +831,6 @@ JsonPair_toString(
 /* JSON OBJECT                                                */
 /**************************************************************/
 
-/**
- * `JsonObject` type definition.
- */
-typedef struct JsonObject JsonObject;
-
-/**
- * JSON Object represents an object which contains
- * unordered JSON Key-Value pairs.
- */
-struct JsonObject
-{
-  /** Number of valid elements (`JsonPair` structures). */
-  size_t count;
-
-  /** Total number of allocated elements (`JsonPair` structures). */
-  size_t capacity;
-
-  /**
-   * Contiguous (dynamically allocated) memory block of
-   * `JsonPair` structures.
-   */
-  JsonPair *pairs;
-};
-
 /**
  * @brief `JsonObject` constructor.
  *
@@ -626,6 +885,24 @@ JsonObject_appendPair(
   _Inout_ JsonObject *object,
   _In_ const JsonPair *pair);
 
+/**
+ * @brief Appends `JsonPair` to `JsonObject` by taking over its contents
+ * (the key and the value are moved, not copied).
+ *
+ * @param[in,out] object Reference to a VALID `JsonObject` object.
+ * @param[in,out] pair Reference to a VALID `JsonPair` object.
+ * On success, it is left as an empty (initialized) JSON Pair.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * (then `pair` is left untouched and still owned by the caller).
+ *
+ * @note Borrowed views (eg. strings pointing into the input buffer)
+ * stay borrowed, so the object must not outlive the borrowed data.
+ */
+extern BOOL
+JsonObject_appendPairTake(
+  _Inout_ JsonObject *object,
+  _Inout_ JsonPair *pair);
+
 /**
  * @brief Appends a Key-Value pair to `JsonObject` by performing a deep-copy.
  *
@@ -708,6 +985,473 @@ JsonObject_getValue(
   _In_ LPCSTR key);
 
 
+/**************************************************************/
+/* JSON INPUT BUFFER                                          */
+/**************************************************************/
+
+/**
+ * How many bytes are requested from Standard Input at once
+ * (at least this much free space is kept in the buffer).
+ */
+#define JSON_INPUT_BUFFER__CHUNK_SIZE  0x00010000
+
+/**
+ * Longest accepted message (in bytes). Longer messages are dropped
+ * while they arrive, without being stored in the buffer.
+ */
+#define JSON_INPUT_BUFFER__MAX_MESSAGE_SIZE  0x01000000
+
+/**
+ * `JsonInputBuffer` type definition.
+ */
+typedef struct JsonInputBuffer JsonInputBuffer;
+
+/**
+ * Bytes received from the Standard Input, which are split into messages
+ * (each stringified JSON is preceded by its 32-bit length).
+ * An incomplete message stays in the buffer until the rest arrives.
+ */
+struct JsonInputBuffer
+{
+  /** Size of the allocated buffer. */
+  size_t capacity;
+
+  /** Received bytes (the buffer is reused between reads). */
+  LPBYTE bytes;
+
+  /** Offset of the first byte that was not yet split into a message. */
+  size_t start;
+
+  /** Number of bytes (from `start`) that were not yet split. */
+  size_t length;
+
+  /** Number of bytes of a dropped (too long) message,
+   * which have not arrived yet. */
+  size_t discard;
+};
+
+/**
+ * @brief `JsonInputBuffer` constructor.
+ *
+ * @param[out] buffer Reference to an UNINITIALIZED `JsonInputBuffer` object.
+ */
+extern VOID
+JsonInputBuffer_init(
+  _Out_ JsonInputBuffer *buffer);
+
+/**
+ * @brief `JsonInputBuffer` destructor.
+ *
+ * @param[in,out] buffer Reference to a VALID `JsonInputBuffer` object.
+ */
+extern VOID
+JsonInputBuffer_destroy(
+  _Inout_ JsonInputBuffer *buffer);
+
+/**
+ * @brief Appends the bytes that are currently pending on the stream
+ * (up to `JSON_INPUT_BUFFER__CHUNK_SIZE` bytes with a single read).
+ *
+ * Messages returned by `JsonInputBuffer_nextMessage` are invalidated,
+ * because the remaining bytes are moved to the beginning of the buffer.
+ * @param[in,out] buffer Reference to a VALID `JsonInputBuffer` object.
+ * @param[in] stream OS-specific stream descriptor (Standard Input),
+ * which has been reported as ready by `OSSpecific_waitForStream`.
+ * @return `JSON_STREAM_STATUS__VALID` if any bytes were read,
+ * `JSON_STREAM_STATUS__EMPTY` if nothing was pending,
+ * `JSON_STREAM_STATUS__NO_MORE` on stream errors (or when the stream
+ * was closed) and on memory allocation errors.
+ */
+extern int
+JsonInputBuffer_readFromStream(
+  _Inout_ JsonInputBuffer *buffer,
+  _In_ const os_specific_stream_t stream);
+
+/**
+ * @brief Splits the next complete message from the buffer.
+ *
+ * Every message is validated as a whole (see `UTF8_validate`),
+ * so the JSON parser does not need to check multibyte codepoints.
+ * Messages longer than `JSON_INPUT_BUFFER__MAX_MESSAGE_SIZE` are dropped.
+ * @param[in,out] buffer Reference to a VALID `JsonInputBuffer` object.
+ * @param[out] stream Reference to an UNINITIALIZED `JsonByteStream` object,
+ * which will point to the message bytes inside the `buffer`
+ * (valid until the next `JsonInputBuffer_readFromStream` call).
+ * @return `JSON_STREAM_STATUS__VALID` if the stream is ready,
+ * `JSON_STREAM_STATUS__EMPTY` if the message is not complete yet,
+ * `JSON_STREAM_STATUS__NO_MORE` if the message length is invalid,
+ * `JSON_STREAM_STATUS__INVALID` if the message was dropped
+ * (next messages can still be split from the buffer).
+ */
+extern int
+JsonInputBuffer_nextMessage(
+  _Inout_ JsonInputBuffer *buffer,
+  _Out_ JsonByteStream *stream);
+
+/**
+ * @brief Releases the buffer once every received byte has been consumed,
+ * if it has grown larger than the given limit (otherwise the buffer
+ * is kept for the next reads).
+ *
+ * Messages returned by `JsonInputBuffer_nextMessage` are invalidated.
+ * @param[in,out] buffer Reference to a VALID `JsonInputBuffer` object.
+ * @param[in] maxCapacity The largest buffer (in bytes) to be kept.
+ */
+extern VOID
+JsonInputBuffer_trim(
+  _Inout_ JsonInputBuffer *buffer,
+  _In_ const size_t maxCapacity);
+
+
+/**************************************************************/
+/* JSON OUTPUT QUEUE                                          */
+/**************************************************************/
+
+/**
+ * `JsonOutputQueue` type definition.
+ */
+typedef struct JsonOutputQueue JsonOutputQueue;
+
+/**
+ * Messages waiting to be sent to the Standard Output, already framed
+ * (each stringified JSON is preceded by its 32-bit length), stored
+ * one-after-another in a single buffer.
+ */
+struct JsonOutputQueue
+{
+  /** Framed messages (the buffer is reused after every flush). */
+  UTF8String buffer;
+
+  /** Number of queued messages. */
+  size_t count;
+};
+
+/**
+ * @brief `JsonOutputQueue` constructor.
+ *
+ * @param[out] queue Reference to an UNINITIALIZED `JsonOutputQueue` object.
+ */
+extern VOID
+JsonOutputQueue_init(
+  _Out_ JsonOutputQueue *queue);
+
+/**
+ * @brief `JsonOutputQueue` destructor. Queued messages are dropped.
+ *
+ * @param[in,out] queue Reference to a VALID `JsonOutputQueue` object.
+ */
+extern VOID
+JsonOutputQueue_destroy(
+  _Inout_ JsonOutputQueue *queue);
+
+/**
+ * @brief Stringifies a JSON Object directly into the queue,
+ * after a length prefix that is filled in place.
+ *
+ * @param[in,out] queue Reference to a VALID `JsonOutputQueue` object.
+ * @param[in] object Reference to a VALID and CONSTANT `JsonObject` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * (the queue is left as it was before this call).
+ */
+extern BOOL
+JsonOutputQueue_pushObject(
+  _Inout_ JsonOutputQueue *queue,
+  _In_ const JsonObject *object);
+
+/**
+ * @brief Moves all the messages from another queue
+ * to the end of this queue.
+ *
+ * @param[in,out] queue Reference to a VALID `JsonOutputQueue` object.
+ * @param[in,out] source Reference to a VALID `JsonOutputQueue` object,
+ * which is emptied on success.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * (both queues are left as they were before this call).
+ */
+extern BOOL
+JsonOutputQueue_pushQueue(
+  _Inout_ JsonOutputQueue *queue,
+  _Inout_ JsonOutputQueue *source);
+
+/**
+ * @brief Sends all the queued messages to the Standard Output stream,
+ * with a single write operation, then empties the queue.
+ *
+ * @param[in,out] queue Reference to a VALID `JsonOutputQueue` object.
+ * @return `TRUE` on success (or if the queue was empty),
+ * `FALSE` if the stream-writing functions failed.
+ */
+extern BOOL
+JsonOutputQueue_flushToStandardOutput(
+  _Inout_ JsonOutputQueue *queue);
+
+/**
+ * @brief Releases the buffer of an empty queue, if it has grown larger
+ * than the given limit (otherwise the buffer is kept for the next messages).
+ *
+ * @param[in,out] queue Reference to a VALID `JsonOutputQueue` object.
+ * @param[in] maxCapacity The largest buffer (in bytes) to be kept.
+ */
+extern VOID
+JsonOutputQueue_trim(
+  _Inout_ JsonOutputQueue *queue,
+  _In_ const size_t maxCapacity);
+
+
+/**************************************************************/
+/* JSON WRITER                                                */
+/**************************************************************/
+
+/**
+ * How many JSON Objects and JSON Arrays can be nested in one message
+ * (including the message itself).
+ */
+#define JSON_WRITER__MAX_DEPTH  8
+
+/**
+ * `JsonWriterMark` type definition.
+ */
+typedef struct JsonWriterMark JsonWriterMark;
+
+/**
+ * Position in a message, to which a `JsonWriter` can be rolled back.
+ */
+struct JsonWriterMark
+{
+  /** Length of the queue buffer. */
+  size_t length;
+
+  /** Number of open containers. */
+  size_t depth;
+
+  /** Was a comma expected before the next element? */
+  BOOL separate;
+};
+
+/**
+ * `JsonWriter` type definition.
+ */
+typedef struct JsonWriter JsonWriter;
+
+/**
+ * Writes one stringified JSON Object (a message) straight into
+ * a `JsonOutputQueue`, without building any intermediate `JsonObject`.
+ *
+ * Every writing function returns `FALSE` after a memory allocation
+ * failure, and the writer then ignores all the calls (other than
+ * `JsonWriter_rollback`) until the message is finished.
+ */
+struct JsonWriter
+{
+  /** Queue that receives the message. */
+  JsonOutputQueue *queue;
+
+  /** Offset of the message's length prefix in the queue buffer. */
+  size_t frameStart;
+
+  /** Number of open containers (the message itself is the first one). */
+  size_t depth;
+
+  /** Is a comma expected before the next element? */
+  BOOL separate;
+
+  /** Has any of the writing functions failed? */
+  BOOL failed;
+
+  /** Closing brackets for the open containers. */
+  BYTE closers[JSON_WRITER__MAX_DEPTH];
+};
+
+/**
+ * @brief Starts a new message: reserves space for the length prefix
+ * and opens the top-level JSON Object.
+ *
+ * @param[out] writer Reference to an UNINITIALIZED `JsonWriter` object.
+ * @param[in,out] queue Reference to a VALID `JsonOutputQueue` object.
+ * Nothing else can be pushed to this queue until the message is finished
+ * (or discarded).
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_begin(
+  _Out_ JsonWriter *writer,
+  _Inout_ JsonOutputQueue *queue);
+
+/**
+ * @brief Closes all the open containers, fills in the length prefix,
+ * and counts the message as queued.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @return `TRUE` on success, `FALSE` if any writing function has failed
+ * (the incomplete message is then dropped from the queue).
+ */
+extern BOOL
+JsonWriter_finish(
+  _Inout_ JsonWriter *writer);
+
+/**
+ * @brief Drops the message from the queue.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ */
+extern VOID
+JsonWriter_discard(
+  _Inout_ JsonWriter *writer);
+
+/**
+ * @brief Saves the current position in the message.
+ *
+ * @param[in] writer Reference to a VALID and CONSTANT `JsonWriter` object.
+ * @param[out] mark Reference to a `JsonWriterMark` object.
+ */
+extern VOID
+JsonWriter_mark(
+  _In_ const JsonWriter *writer,
+  _Out_ JsonWriterMark *mark);
+
+/**
+ * @brief Removes everything that was written after the given mark
+ * (also clearing any failure that happened in the meantime).
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] mark Reference to a `JsonWriterMark` saved by the same writer.
+ */
+extern VOID
+JsonWriter_rollback(
+  _Inout_ JsonWriter *writer,
+  _In_ const JsonWriterMark *mark);
+
+/**
+ * @brief Writes a key of the current JSON Object.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] key A valid (NULL-terminated) UTF-8 text.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_key(
+  _Inout_ JsonWriter *writer,
+  _In_z_ LPCSTR key);
+
+/**
+ * @brief Writes a JSON String (escaping special characters).
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] string Reference to a VALID and CONSTANT `UTF8String` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_string(
+  _Inout_ JsonWriter *writer,
+  _In_ const UTF8String *string);
+
+/**
+ * @brief Opens a JSON String, which text is then appended by the caller
+ * directly to the queue buffer (without any escaping).
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @return Reference to the queue buffer, or `NULL` on memory allocation
+ * failure. Only characters that do not need escaping (like hex digits)
+ * can be appended, and the string must be closed
+ * with `JsonWriter_closeString`.
+ */
+extern UTF8String *
+JsonWriter_openString(
+  _Inout_ JsonWriter *writer);
+
+/**
+ * @brief Closes a JSON String opened with `JsonWriter_openString`.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_closeString(
+  _Inout_ JsonWriter *writer);
+
+/**
+ * @brief Writes a byte array as a hex-string.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] count Number of bytes.
+ * @param[in] bytes Bytes to be written.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_hex(
+  _Inout_ JsonWriter *writer,
+  _In_ const size_t count,
+  _In_ const BYTE *bytes);
+
+/**
+ * @brief Writes an integer JSON Number.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] integer Number to be written.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_integer(
+  _Inout_ JsonWriter *writer,
+  _In_ const int64_t integer);
+
+/**
+ * @brief Writes a JSON Boolean.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] boolean Value to be written.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_boolean(
+  _Inout_ JsonWriter *writer,
+  _In_ const BOOL boolean);
+
+/**
+ * @brief Writes any `JsonValue` object.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] value Reference to a VALID and CONSTANT `JsonValue` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_value(
+  _Inout_ JsonWriter *writer,
+  _In_ const JsonValue *value);
+
+/**
+ * @brief Opens a nested JSON Object.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * OR when too many containers are nested.
+ */
+extern BOOL
+JsonWriter_beginObject(
+  _Inout_ JsonWriter *writer);
+
+/**
+ * @brief Opens a nested JSON Array.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * OR when too many containers are nested.
+ */
+extern BOOL
+JsonWriter_beginArray(
+  _Inout_ JsonWriter *writer);
+
+/**
+ * @brief Closes the most recently opened JSON Object or JSON Array.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+JsonWriter_end(
+  _Inout_ JsonWriter *writer);
+
+
 /**************************************************************/
 
 #ifdef __cplusplus
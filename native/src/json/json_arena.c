@@ -0,0 +1,251 @@
+/**
+ * @file "native/src/json/json_arena.c"
+ * Simplified handling of the JSON data.
+ */
+
+#include "json/json.h"
+
+/**
+ * Every allocation is aligned to this many bytes
+ * (JSON objects hold only pointers, sizes, and 64-bit numbers).
+ */
+#define JSON_ARENA__ALIGNMENT  8
+
+/**
+ * Arena attached to the current thread (`NULL` means the regular heap).
+ * Reader Workers build their JSON Responses on the heap, while the main
+ * thread can use an arena for every message.
+ */
+static _Thread_local JsonArena *json_attached_arena = NULL;
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonArena` object.
+ * Checks if a pointer belongs to one of the arena's blocks.
+ *
+ * @param[in] arena Reference to a VALID and CONSTANT `JsonArena` object.
+ * @param[in] memory Tested pointer.
+ * @return `TRUE` if `memory` was handed out by the arena.
+ */
+static BOOL
+JsonArena_owns(
+  _In_ const JsonArena *arena,
+  _In_ const VOID *memory)
+{
+  const JsonArenaBlock *block;
+  const BYTE *bytes = memory;
+
+  for (block = arena->first; NULL != block; block = block->next)
+  {
+    if ((bytes >= block->data) && (bytes < &(block->data[block->capacity])))
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonArena` object.
+ * Hands out memory from the current block, appending a new block
+ * when the current one is full.
+ *
+ * @param[in,out] arena Reference to a VALID `JsonArena` object.
+ * @param[in] size Requested number of bytes.
+ * @return Pointer to the allocated memory, or `NULL` on failure.
+ */
+static LPVOID
+JsonArena_bump(
+  _Inout_ JsonArena *arena,
+  _In_ size_t size)
+{
+  JsonArenaBlock *block;
+  size_t capacity;
+
+  size = (size + JSON_ARENA__ALIGNMENT - 1) &
+    ~(JSON_ARENA__ALIGNMENT - 1);
+
+  block = arena->current;
+
+  if ((NULL == block) || ((block->capacity - block->used) < size))
+  {
+    capacity = (size > JSON_ARENA__BLOCK_SIZE) ?
+      size :
+      JSON_ARENA__BLOCK_SIZE;
+
+    block = malloc(sizeof(JsonArenaBlock) + capacity);
+    if (NULL == block) { return NULL; }
+
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+
+    if (NULL == arena->current)
+    {
+      arena->first = block;
+    }
+    else
+    {
+      arena->current->next = block;
+    }
+  }
+
+  arena->current = block;
+  arena->last = &(block->data[block->used]);
+  block->used += size;
+
+  return arena->last;
+}
+
+/**************************************************************/
+
+VOID
+JsonArena_init(
+  _Out_ JsonArena *arena)
+{
+  arena->first   = NULL;
+  arena->current = NULL;
+  arena->last    = NULL;
+}
+
+/**************************************************************/
+
+VOID
+JsonArena_destroy(
+  _Inout_ JsonArena *arena)
+{
+  JsonArenaBlock *block;
+
+  while (NULL != arena->first)
+  {
+    block = arena->first;
+    arena->first = block->next;
+    free(block);
+  }
+
+  arena->current = NULL;
+  arena->last = NULL;
+}
+
+/**************************************************************/
+
+VOID
+JsonArena_reset(
+  _Inout_ JsonArena *arena)
+{
+  JsonArenaBlock *block;
+
+  if (NULL == arena->first) { return; }
+
+  /* Blocks added for an unusually large message are not kept */
+
+  while (NULL != arena->first->next)
+  {
+    block = arena->first->next;
+    arena->first->next = block->next;
+    free(block);
+  }
+
+  arena->first->used = 0;
+  arena->current = arena->first;
+  arena->last = NULL;
+}
+
+/**************************************************************/
+
+JsonArena *
+JsonArena_attach(
+  _In_opt_ JsonArena *arena)
+{
+  JsonArena *previous = json_attached_arena;
+
+  json_attached_arena = arena;
+
+  return previous;
+}
+
+/**************************************************************/
+
+LPVOID
+JsonArena_allocate(
+  _In_ const size_t size)
+{
+  if (NULL == json_attached_arena)
+  {
+    return malloc(size);
+  }
+
+  return JsonArena_bump(json_attached_arena, size);
+}
+
+/**************************************************************/
+
+LPVOID
+JsonArena_reallocate(
+  _In_opt_ LPVOID memory,
+  _In_ const size_t oldSize,
+  _In_ const size_t newSize)
+{
+  JsonArena *arena = json_attached_arena;
+  JsonArenaBlock *block;
+  LPVOID result;
+  size_t size;
+
+  if (NULL == memory)
+  {
+    return JsonArena_allocate(newSize);
+  }
+
+  if ((NULL == arena) || !JsonArena_owns(arena, memory))
+  {
+    return realloc(memory, newSize);
+  }
+
+  /* The most recent allocation can grow in place */
+
+  block = arena->current;
+
+  if (memory == arena->last)
+  {
+    size = (newSize + JSON_ARENA__ALIGNMENT - 1) &
+      ~(JSON_ARENA__ALIGNMENT - 1);
+
+    if ((size_t) (&(block->data[block->capacity]) - (LPBYTE) memory) >= size)
+    {
+      block->used = ((LPBYTE) memory - block->data) + size;
+      return memory;
+    }
+  }
+
+  /* Otherwise, move the data (the old copy is reclaimed on reset) */
+
+  result = JsonArena_bump(arena, newSize);
+  if (NULL == result) { return NULL; }
+
+  memcpy(result, memory, (oldSize < newSize) ? oldSize : newSize);
+
+  return result;
+}
+
+/**************************************************************/
+
+VOID
+JsonArena_release(
+  _In_opt_ LPVOID memory)
+{
+  if (NULL == memory) { return; }
+
+  if ((NULL != json_attached_arena) &&
+    JsonArena_owns(json_attached_arena, memory))
+  {
+    return;
+  }
+
+  free(memory);
+}
+
+/**************************************************************/
@@ -29,7 +29,7 @@ JsonArray_destroy(
       JsonValue_destroy(&(array->values[i]));
     }
 
-    free(array->values);
+    JsonArena_release(array->values);
   }
 }
 
@@ -52,7 +52,7 @@ JsonArray_copy(
   destination->count = 0;
   destination->capacity = capacity;
 
-  destination->values = malloc(byteSize);
+  destination->values = JsonArena_allocate(byteSize);
   if (NULL == destination->values) { return FALSE; }
 
   for (size_t i = 0; i < source->count; i++)
@@ -67,10 +67,16 @@ JsonArray_copy(
 
 /**************************************************************/
 
-BOOL
-JsonArray_append(
-  _Inout_ JsonArray *array,
-  _In_ const JsonValue *value)
+/**
+ * @brief A private method for `JsonArray` object.
+ * Makes sure that one more `JsonValue` fits into the array.
+ *
+ * @param[in,out] array Reference to a VALID `JsonArray` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+static BOOL
+JsonArray_reserve(
+  _Inout_ JsonArray *array)
 {
   size_t newCapacity = (array->count + 1);
 
@@ -79,13 +85,28 @@ JsonArray_append(
     newCapacity = Misc_nextPowerOfTwo(newCapacity - 1);
 
     const size_t newByteSize = sizeof(JsonValue) * newCapacity;
-    JsonValue *newValues = realloc(array->values, newByteSize);
+    JsonValue *newValues = JsonArena_reallocate(
+      array->values,
+      sizeof(JsonValue) * array->capacity,
+      newByteSize);
     if (NULL == newValues) { return FALSE; }
 
     array->values = newValues;
     array->capacity = newCapacity;
   }
 
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+JsonArray_append(
+  _Inout_ JsonArray *array,
+  _In_ const JsonValue *value)
+{
+  if (!JsonArray_reserve(array)) { return FALSE; }
+
   BOOL test_bool = JsonValue_copy(
     &(array->values[array->count]),
     value);
@@ -96,9 +117,28 @@ JsonArray_append(
 
 /**************************************************************/
 
+BOOL
+JsonArray_appendTake(
+  _Inout_ JsonArray *array,
+  _Inout_ JsonValue *value)
+{
+  if (!JsonArray_reserve(array)) { return FALSE; }
+
+  /* Move the value (and everything it owns) without copying */
+
+  array->values[array->count] = value[0];
+  array->count += 1;
+
+  JsonValue_init(value);
+  return TRUE;
+}
+
+/**************************************************************/
+
 BOOL
 JsonArray_parse(
   _Outptr_result_maybenull_ JsonArray **const result,
+  _In_ const BOOL allocate,
   _Inout_ JsonByteStream *stream)
 {
   BOOL test_bool;
@@ -106,8 +146,11 @@ JsonArray_parse(
   JsonValue json_value;
   JsonValue *json_value_ptr = &(json_value);
 
-  result[0] = malloc(sizeof(JsonArray));
-  if (NULL == result[0]) { return FALSE; }
+  if (allocate)
+  {
+    result[0] = JsonArena_allocate(sizeof(JsonArray));
+    if (NULL == result[0]) { return FALSE; }
+  }
   JsonArray_init(result[0]);
 
   /* Array starts with '[' */
@@ -122,7 +165,7 @@ JsonArray_parse(
     return FALSE;
   }
 
-  if (!JsonByteStream_skipWhitespace(stream))
+  if (!JsonByteStream_enter(stream) || !JsonByteStream_skipWhitespace(stream))
   {
     return FALSE;
   }
@@ -132,6 +175,7 @@ JsonArray_parse(
     if (']' == test_byte)  /* Array ends with ']' */
     {
       JsonByteStream_skip(stream, 1);
+      JsonByteStream_leave(stream);
       return TRUE;
     }
 
@@ -166,7 +210,7 @@ JsonArray_parse(
 
     if (test_bool)
     {
-      test_bool = JsonArray_append(result[0], json_value_ptr);
+      test_bool = JsonArray_appendTake(result[0], json_value_ptr);
     }
 
     JsonValue_destroy(json_value_ptr);
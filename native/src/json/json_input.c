@@ -0,0 +1,234 @@
+/**
+ * @file "native/src/json/json_input.c"
+ * Simplified handling of the JSON data.
+ */
+
+#include "json/json.h"
+
+/**************************************************************/
+
+VOID
+JsonInputBuffer_init(
+  _Out_ JsonInputBuffer *buffer)
+{
+  buffer->capacity = 0;
+  buffer->bytes = NULL;
+  buffer->start = 0;
+  buffer->length = 0;
+  buffer->discard = 0;
+}
+
+/**************************************************************/
+
+VOID
+JsonInputBuffer_destroy(
+  _Inout_ JsonInputBuffer *buffer)
+{
+  if (NULL != buffer->bytes)
+  {
+    free(buffer->bytes);
+  }
+}
+
+/**************************************************************/
+
+int
+JsonInputBuffer_readFromStream(
+  _Inout_ JsonInputBuffer *buffer,
+  _In_ const os_specific_stream_t stream)
+{
+  BOOL test_bool;
+  size_t new_capacity;
+  size_t bytes_read;
+  LPBYTE new_bytes;
+
+  /* Move the incomplete message (if any) to the beginning */
+
+  if (0 != buffer->start)
+  {
+    if (0 != buffer->length)
+    {
+      memmove(
+        &(buffer->bytes[0]),
+        &(buffer->bytes[buffer->start]),
+        buffer->length);
+    }
+
+    buffer->start = 0;
+  }
+
+  /* Make room for the next chunk */
+
+  new_capacity = buffer->length + JSON_INPUT_BUFFER__CHUNK_SIZE;
+
+  if (new_capacity > buffer->capacity)
+  {
+    new_capacity = Misc_nextPowerOfTwo(new_capacity - 1);
+
+    new_bytes = realloc(buffer->bytes, sizeof(BYTE) * new_capacity);
+    if (NULL == new_bytes)
+    {
+      #if defined(_DEBUG)
+        OSSpecific_writeDebugMessage(
+          "{JsonInputBuffer::readFromStream} memory allocation failed!");
+      #endif
+
+      return JSON_STREAM_STATUS__NO_MORE;
+    }
+
+    buffer->bytes = new_bytes;
+    buffer->capacity = new_capacity;
+  }
+
+  test_bool = OSSpecific_readAvailableBytesFromStream(
+    stream,
+    &(buffer->bytes[buffer->length]),
+    buffer->capacity - buffer->length,
+    &(bytes_read));
+
+  if (!test_bool)
+  {
+    return JSON_STREAM_STATUS__NO_MORE;
+  }
+
+  #if defined(_DEBUG)
+    OSSpecific_writeDebugMessage(
+      "{JsonInputBuffer} 0x%04X bytes from STDIN, 0x%04X bytes pending",
+      (uint32_t) bytes_read,
+      (uint32_t) (buffer->length + bytes_read));
+  #endif
+
+  buffer->length += bytes_read;
+
+  return (0 != bytes_read) ?
+    JSON_STREAM_STATUS__VALID :
+    JSON_STREAM_STATUS__EMPTY;
+}
+
+/**************************************************************/
+
+int
+JsonInputBuffer_nextMessage(
+  _Inout_ JsonInputBuffer *buffer,
+  _Out_ JsonByteStream *stream)
+{
+  uint32_t json_length;
+  size_t count;
+  LPBYTE frame;
+
+  /* Drop the rest of a message that was too long */
+
+  if (0 != buffer->discard)
+  {
+    count = (buffer->discard < buffer->length) ?
+      buffer->discard :
+      buffer->length;
+
+    buffer->start += count;
+    buffer->length -= count;
+    buffer->discard -= count;
+
+    if (0 != buffer->discard)
+    {
+      return JSON_STREAM_STATUS__EMPTY;
+    }
+  }
+
+  /* Read the first four bytes (INT32) */
+  /* ("native byte order", no need to check for endianness) */
+
+  if (buffer->length < sizeof(uint32_t))
+  {
+    return JSON_STREAM_STATUS__EMPTY;
+  }
+
+  frame = &(buffer->bytes[buffer->start]);
+
+  memcpy(&(json_length), frame, sizeof(uint32_t));
+
+  /* Validate given text length */
+
+  if ((0 == json_length) || (UINT32_MAX == json_length))
+  {
+    #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "{JsonInputBuffer::nextMessage} invalid stream length!");
+    #endif
+
+    return JSON_STREAM_STATUS__NO_MORE;
+  }
+
+  if (json_length > JSON_INPUT_BUFFER__MAX_MESSAGE_SIZE)
+  {
+    #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "{JsonInputBuffer::nextMessage} message too long!");
+    #endif
+
+    /* The message is dropped as it arrives (it is never buffered) */
+
+    buffer->start += sizeof(uint32_t);
+    buffer->length -= sizeof(uint32_t);
+    buffer->discard = json_length;
+
+    return JSON_STREAM_STATUS__INVALID;
+  }
+
+  if (json_length > (buffer->length - sizeof(uint32_t)))
+  {
+    /* Only a part of the message has arrived so far */
+    return JSON_STREAM_STATUS__EMPTY;
+  }
+
+  #if defined(_DEBUG)
+    UTF8String hexdump;
+    UTF8String_init(&(hexdump));
+    UTF8String_pushBytesAsHex(&(hexdump), json_length, &(frame[sizeof(uint32_t)]));
+    OSSpecific_writeDebugMessage("{JsonByteStream} hex-dump: %s", (LPCSTR) hexdump.text);
+    UTF8String_destroy(&(hexdump));
+  #endif
+
+  /* "JsonByteStream" object is now ready to be parsed */
+
+  stream->head = &(frame[sizeof(uint32_t)]);
+  stream->head_length = json_length;
+  stream->tail = stream->head;
+  stream->tail_length = json_length;
+  stream->depth = 0;
+
+  buffer->start += sizeof(uint32_t) + json_length;
+  buffer->length -= sizeof(uint32_t) + json_length;
+
+  /* Validate all multibyte codepoints at once */
+
+  if (!UTF8_validate(stream->head, stream->head_length))
+  {
+    #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "{JsonInputBuffer::nextMessage} not a valid UTF-8 text!");
+    #endif
+
+    return JSON_STREAM_STATUS__INVALID;
+  }
+
+  return JSON_STREAM_STATUS__VALID;
+}
+
+/**************************************************************/
+
+VOID
+JsonInputBuffer_trim(
+  _Inout_ JsonInputBuffer *buffer,
+  _In_ const size_t maxCapacity)
+{
+  if ((0 == buffer->length) && (buffer->capacity > maxCapacity))
+  {
+    free(buffer->bytes);
+
+    buffer->bytes = NULL;
+    buffer->capacity = 0;
+    buffer->start = 0;
+  }
+}
+
+/**************************************************************/
@@ -29,7 +29,7 @@ JsonObject_destroy(
       JsonPair_destroy(&(object->pairs[i]));
     }
 
-    free(object->pairs);
+    JsonArena_release(object->pairs);
   }
 }
 
@@ -52,7 +52,7 @@ JsonObject_copy(
   destination->count = 0;
   destination->capacity = capacity;
 
-  destination->pairs = malloc(byteSize);
+  destination->pairs = JsonArena_allocate(byteSize);
   if (NULL == destination->pairs) { return FALSE; }
 
   for (size_t i = 0; i < source->count; i++)
@@ -67,10 +67,16 @@ JsonObject_copy(
 
 /**************************************************************/
 
-BOOL
-JsonObject_appendPair(
-  _Inout_ JsonObject *object,
-  _In_ const JsonPair *pair)
+/**
+ * @brief A private method for `JsonObject` object.
+ * Makes sure that one more `JsonPair` fits into the object.
+ *
+ * @param[in,out] object Reference to a VALID `JsonObject` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+static BOOL
+JsonObject_reserve(
+  _Inout_ JsonObject *object)
 {
   size_t newCapacity = (object->count + 1);
 
@@ -79,13 +85,28 @@ JsonObject_appendPair(
     newCapacity = Misc_nextPowerOfTwo(newCapacity - 1);
 
     const size_t newByteSize = sizeof(JsonPair) * newCapacity;
-    JsonPair *newPairs = realloc(object->pairs, newByteSize);
+    JsonPair *newPairs = JsonArena_reallocate(
+      object->pairs,
+      sizeof(JsonPair) * object->capacity,
+      newByteSize);
     if (NULL == newPairs) { return FALSE; }
 
     object->pairs = newPairs;
     object->capacity = newCapacity;
   }
 
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+JsonObject_appendPair(
+  _Inout_ JsonObject *object,
+  _In_ const JsonPair *pair)
+{
+  if (!JsonObject_reserve(object)) { return FALSE; }
+
   BOOL test_bool = JsonPair_copy(
     &(object->pairs[object->count]),
     pair);
@@ -96,6 +117,24 @@ JsonObject_appendPair(
 
 /**************************************************************/
 
+BOOL
+JsonObject_appendPairTake(
+  _Inout_ JsonObject *object,
+  _Inout_ JsonPair *pair)
+{
+  if (!JsonObject_reserve(object)) { return FALSE; }
+
+  /* Move the key and the value (and everything they own) without copying */
+
+  object->pairs[object->count] = pair[0];
+  object->count += 1;
+
+  JsonPair_init(pair);
+  return TRUE;
+}
+
+/**************************************************************/
+
 BOOL
 JsonObject_appendKeyValue(
   _Inout_ JsonObject *object,
@@ -126,7 +165,7 @@ JsonObject_parse(
 
   if (allocate)
   {
-    result[0] = malloc(sizeof(JsonObject));
+    result[0] = JsonArena_allocate(sizeof(JsonObject));
     if (NULL == result[0]) { return FALSE; }
   }
   JsonObject_init(result[0]);
@@ -143,7 +182,7 @@ JsonObject_parse(
     return FALSE;
   }
 
-  if (!JsonByteStream_skipWhitespace(stream))
+  if (!JsonByteStream_enter(stream) || !JsonByteStream_skipWhitespace(stream))
   {
     return FALSE;
   }
@@ -153,6 +192,7 @@ JsonObject_parse(
     if ('}' == test_byte)  /* Object ends with '}' */
     {
       JsonByteStream_skip(stream, 1);
+      JsonByteStream_leave(stream);
       return TRUE;
     }
 
@@ -187,7 +227,7 @@ JsonObject_parse(
 
     if (test_bool)
     {
-      test_bool = JsonObject_appendPair(result[0], json_pair_ptr);
+      test_bool = JsonObject_appendPairTake(result[0], json_pair_ptr);
     }
 
     JsonPair_destroy(json_pair_ptr);
@@ -0,0 +1,165 @@
+/**
+ * @file "native/src/json/json_output.c"
+ * Simplified handling of the JSON data.
+ */
+
+#include "json/json.h"
+
+/**************************************************************/
+
+VOID
+JsonOutputQueue_init(
+  _Out_ JsonOutputQueue *queue)
+{
+  UTF8String_init(&(queue->buffer));
+  queue->count = 0;
+}
+
+/**************************************************************/
+
+VOID
+JsonOutputQueue_destroy(
+  _Inout_ JsonOutputQueue *queue)
+{
+  UTF8String_destroy(&(queue->buffer));
+}
+
+/**************************************************************/
+
+BOOL
+JsonOutputQueue_pushObject(
+  _Inout_ JsonOutputQueue *queue,
+  _In_ const JsonObject *object)
+{
+  const size_t frame_start = queue->buffer.length;
+  uint32_t json_length;
+
+  /* Reserve space for the length prefix */
+  /* ("native byte order", no need to check for endianness) */
+
+  if (!UTF8String_pushText(&(queue->buffer), "\0\0\0\0", sizeof(uint32_t)))
+  {
+    return FALSE;
+  }
+
+  if (!JsonObject_toString(object, &(queue->buffer)))
+  {
+    /* Drop the incomplete frame */
+
+    queue->buffer.length = frame_start;
+    queue->buffer.text[frame_start] = '\0';
+
+    return FALSE;
+  }
+
+  json_length = (uint32_t)
+    (queue->buffer.length - frame_start - sizeof(uint32_t));
+
+  memcpy(
+    &(queue->buffer.text[frame_start]),
+    &(json_length),
+    sizeof(uint32_t));
+
+  queue->count += 1;
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+JsonOutputQueue_pushQueue(
+  _Inout_ JsonOutputQueue *queue,
+  _Inout_ JsonOutputQueue *source)
+{
+  if (0 == source->buffer.length)
+  {
+    return TRUE;
+  }
+
+  if (!UTF8String_pushText(
+    &(queue->buffer),
+    (LPCSTR) source->buffer.text,
+    source->buffer.length))
+  {
+    return FALSE;
+  }
+
+  queue->count += source->count;
+
+  /* Keep the allocated buffer for the next messages */
+
+  source->buffer.length = 0;
+  source->buffer.text[0] = '\0';
+  source->count = 0;
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+JsonOutputQueue_flushToStandardOutput(
+  _Inout_ JsonOutputQueue *queue)
+{
+  os_specific_stream_t stdout_stream;
+  BOOL test_bool;
+
+  if (0 == queue->buffer.length)
+  {
+    return TRUE;
+  }
+
+  #if defined(_WIN32)
+  {
+    stdout_stream = GetStdHandle(STD_OUTPUT_HANDLE);
+
+    if (INVALID_HANDLE_VALUE == stdout_stream)
+    {
+      return FALSE;
+    }
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    stdout_stream = STDOUT_FILENO;
+  }
+  #endif
+
+  #if defined(_DEBUG)
+  {
+    OSSpecific_writeDebugMessage(
+      "Flushing %d message(s), %d byte(s)",
+      (int) queue->count,
+      (int) queue->buffer.length);
+  }
+  #endif
+
+  test_bool = OSSpecific_writeBytesToStream(
+    stdout_stream,
+    queue->buffer.text,
+    queue->buffer.length);
+
+  /* Keep the allocated buffer for the next messages */
+
+  queue->buffer.length = 0;
+  queue->buffer.text[0] = '\0';
+  queue->count = 0;
+
+  return test_bool;
+}
+
+/**************************************************************/
+
+VOID
+JsonOutputQueue_trim(
+  _Inout_ JsonOutputQueue *queue,
+  _In_ const size_t maxCapacity)
+{
+  if ((0 == queue->buffer.length) && (queue->buffer.capacity > maxCapacity))
+  {
+    UTF8String_destroy(&(queue->buffer));
+    UTF8String_init(&(queue->buffer));
+  }
+}
+
+/**************************************************************/
@@ -54,7 +54,7 @@ JsonPair_parse(
 
   if (allocate)
   {
-    result[0] = malloc(sizeof(JsonPair));
+    result[0] = JsonArena_allocate(sizeof(JsonPair));
     if (NULL == result[0]) { return FALSE; }
   }
   JsonPair_init(result[0]);
@@ -5,6 +5,237 @@
 
 #include "json/json.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+#elif defined(__aarch64__)
+  #include <arm_neon.h>
+#endif
+
+/**
+ * Finds the first byte (in a given text) that cannot be copied as-is
+ * between the quotes of a JSON String: a quotation mark, a backslash,
+ * or a control character (multibyte codepoints are validated separately,
+ * see `UTF8_validate`). Returns the offset of that byte, or `length`
+ * when the whole text is plain.
+ */
+typedef size_t (*json_string_scanner_t)(
+  _In_ const BYTE *text,
+  _In_ const size_t length);
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonString` object.
+ * Scans the text one byte at a time (generic version).
+ *
+ * @param[in] text Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first special byte, or `length`.
+ */
+static size_t
+JsonString_scanBytes(
+  _In_ const BYTE *text,
+  _In_ const size_t length)
+{
+  size_t i;
+
+  for (i = 0; i < length; i++)
+  {
+    if ((text[i] < ' ') || ('"' == text[i]) || ('\\' == text[i]))
+    {
+      break;
+    }
+  }
+
+  return i;
+}
+
+/**************************************************************/
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief A private method for `JsonString` object.
+ * Scans the text 16 bytes at a time (SSE2 version).
+ *
+ * @param[in] text Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first special byte, or `length`.
+ */
+__attribute__((target("sse2")))
+static size_t
+JsonString_scanSse2(
+  _In_ const BYTE *text,
+  _In_ const size_t length)
+{
+  const __m128i quotes = _mm_set1_epi8('"');
+  const __m128i backslashes = _mm_set1_epi8('\\');
+  const __m128i controls = _mm_set1_epi8(0x1F);
+  __m128i chunk;
+  uint32_t mask;
+  size_t i;
+
+  for (i = 0; (i + 16) <= length; i += 16)
+  {
+    chunk = _mm_loadu_si128((const __m128i *) &(text[i]));
+
+    /* Unsigned "less than space": max(byte, 0x1F) stays at 0x1F */
+
+    mask = (uint32_t) _mm_movemask_epi8(
+      _mm_or_si128(
+        _mm_or_si128(
+          _mm_cmpeq_epi8(chunk, quotes),
+          _mm_cmpeq_epi8(chunk, backslashes)),
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, controls), controls)));
+
+    if (0 != mask)
+    {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + JsonString_scanBytes(&(text[i]), (length - i));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonString` object.
+ * Scans the text 32 bytes at a time (AVX2 version).
+ *
+ * @param[in] text Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first special byte, or `length`.
+ */
+__attribute__((target("avx2")))
+static size_t
+JsonString_scanAvx2(
+  _In_ const BYTE *text,
+  _In_ const size_t length)
+{
+  const __m256i quotes = _mm256_set1_epi8('"');
+  const __m256i backslashes = _mm256_set1_epi8('\\');
+  const __m256i controls = _mm256_set1_epi8(0x1F);
+  __m256i chunk;
+  uint32_t mask;
+  size_t i;
+
+  for (i = 0; (i + 32) <= length; i += 32)
+  {
+    chunk = _mm256_loadu_si256((const __m256i *) &(text[i]));
+
+    mask = (uint32_t) _mm256_movemask_epi8(
+      _mm256_or_si256(
+        _mm256_or_si256(
+          _mm256_cmpeq_epi8(chunk, quotes),
+          _mm256_cmpeq_epi8(chunk, backslashes)),
+        _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, controls), controls)));
+
+    if (0 != mask)
+    {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + JsonString_scanSse2(&(text[i]), (length - i));
+}
+
+#elif defined(__aarch64__)
+
+/**
+ * @brief A private method for `JsonString` object.
+ * Scans the text 16 bytes at a time (NEON version).
+ *
+ * @param[in] text Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first special byte, or `length`.
+ */
+static size_t
+JsonString_scanNeon(
+  _In_ const BYTE *text,
+  _In_ const size_t length)
+{
+  const uint8x16_t quotes = vdupq_n_u8('"');
+  const uint8x16_t backslashes = vdupq_n_u8('\\');
+  const uint8x16_t spaces = vdupq_n_u8(' ');
+  uint8x16_t chunk;
+  size_t i;
+
+  for (i = 0; (i + 16) <= length; i += 16)
+  {
+    chunk = vld1q_u8(&(text[i]));
+
+    chunk = vorrq_u8(
+      vorrq_u8(
+        vceqq_u8(chunk, quotes),
+        vceqq_u8(chunk, backslashes)),
+      vcltq_u8(chunk, spaces));
+
+    if (0 != vmaxvq_u8(chunk))
+    {
+      return i + JsonString_scanBytes(&(text[i]), 16);
+    }
+  }
+
+  return i + JsonString_scanBytes(&(text[i]), (length - i));
+}
+
+#endif
+
+/**************************************************************/
+
+static size_t
+JsonString_selectScanner(
+  _In_ const BYTE *text,
+  _In_ const size_t length);
+
+/**
+ * Scanner used by `JsonString_parse` and `JsonString_toString`.
+ * The first call picks the fastest version supported by the processor.
+ * Both the main thread and Reader Workers may race to replace it,
+ * but they always store the same function.
+ */
+static json_string_scanner_t json_string_scanner = JsonString_selectScanner;
+
+/**
+ * @brief A private method for `JsonString` object.
+ * Selects the scanner (on first use), and then scans the text.
+ *
+ * @param[in] text Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first special byte, or `length`.
+ */
+static size_t
+JsonString_selectScanner(
+  _In_ const BYTE *text,
+  _In_ const size_t length)
+{
+  json_string_scanner_t scanner = JsonString_scanBytes;
+
+  #if defined(__x86_64__) || defined(__i386__)
+  {
+    const uint32_t features = Misc_getCpuFeatures();
+
+    if (MISC_CPU_FEATURE__AVX2 & features)
+    {
+      scanner = JsonString_scanAvx2;
+    }
+    else if (MISC_CPU_FEATURE__SSE2 & features)
+    {
+      scanner = JsonString_scanSse2;
+    }
+  }
+  #elif defined(__aarch64__)
+  {
+    scanner = JsonString_scanNeon;
+  }
+  #endif
+
+  json_string_scanner = scanner;
+
+  return scanner(text, length);
+}
+
 /**************************************************************/
 
 BOOL
@@ -14,11 +245,12 @@ JsonString_parse(
   _Inout_ JsonByteStream *stream)
 {
   BYTE test_byte;
-  BOOL test_bool;
+  BOOL escaped = FALSE;
+  const BYTE *unescaped_text;
 
   if (allocate)
   {
-    result[0] = malloc(sizeof(UTF8String));
+    result[0] = JsonArena_allocate(sizeof(UTF8String));
     if (NULL == result[0]) { return FALSE; }
   }
   UTF8String_init(result[0]);
@@ -35,6 +267,21 @@ JsonString_parse(
     return FALSE;
   }
 
+  /* Bytes between escape sequences are not copied one by one: */
+  /* the string either borrows them from the stream (no escape */
+  /* sequences at all), or they are appended as a single block */
+
+  /* Plain characters are skipped in bulk, stopping only at the bytes */
+  /* that need attention (quotes, escapes and control characters). */
+  /* Multibyte codepoints are plain too: the whole message has been */
+  /* validated when it was read (see `JsonInputBuffer_nextMessage`) */
+
+  unescaped_text = stream->tail;
+
+  JsonByteStream_skip(
+    stream,
+    json_string_scanner(stream->tail, stream->tail_length));
+
   while (JsonByteStream_read(stream, &(test_byte), 1))
   {
     if (test_byte < ' ')
@@ -47,86 +294,86 @@ JsonString_parse(
 
       return FALSE;
     }
-    else if (0x80 & test_byte)
+    else if ('"' == test_byte)
     {
-      /* Multibyte codepoint */
+      /* String ends with '"' */
+
+      if (!escaped)
+      {
+        UTF8String_makeView(
+          result[0],
+          unescaped_text,
+          (&(stream->tail[-1]) - unescaped_text));
 
-      size_t remaining_bytes = stream->tail_length;
+        return TRUE;
+      }
 
-      test_bool = UTF8_validateTransformation(
-        &(stream->tail[-1]),
-        &(remaining_bytes),
-        NULL);
+      return (unescaped_text == &(stream->tail[-1])) ||
+        UTF8String_pushText(
+          result[0],
+          (LPCSTR) unescaped_text,
+          (&(stream->tail[-1]) - unescaped_text));
+    }
+    else if ('\\' == test_byte)
+    {
+      /* Flush the bytes preceding the escape sequence */
 
-      if (!test_bool)
+      if ((unescaped_text != &(stream->tail[-1])) && !UTF8String_pushText(
+        result[0],
+        (LPCSTR) unescaped_text,
+        (&(stream->tail[-1]) - unescaped_text)))
       {
-        #if defined(_DEBUG)
-        OSSpecific_writeDebugMessage(
-          "JsonString::parse(): not a valid UTF-8 representation!");
-        #endif
-
         return FALSE;
       }
 
-      test_bool = UTF8String_pushText(
-        result[0],
-        (LPCSTR) &(stream->tail[-1]),
-        remaining_bytes);
+      escaped = TRUE;
 
-      JsonByteStream_skip(stream, (remaining_bytes - 1));
+      if (!JsonByteStream_read(stream, &(test_byte), 1))
+      {
+        return FALSE;
+      }
 
-      if (!test_bool) { return FALSE; }
-    }
-    else if ('"' == test_byte)
-    {
-      /* String ends with '"' */
-      return TRUE;
-    }
-    else
-    {
-      if ('\\' == test_byte)
+      switch (test_byte)
       {
-        if (!JsonByteStream_read(stream, &(test_byte), 1))
-        {
+        case '"':
+        case '\\':
+        case '/':
+          break;
+        case 'b':
+          test_byte = '\b';
+          break;
+        case 'f':
+          test_byte = '\f';
+          break;
+        case 'n':
+          test_byte = '\n';
+          break;
+        case 'r':
+          test_byte = '\r';
+          break;
+        case 't':
+          test_byte = '\t';
+          break;
+        default:
+          #if defined(_DEBUG)
+          OSSpecific_writeDebugMessage(
+            "JSON stream, parsing failed: unknown escape sequence 0x%02X",
+            test_byte);
+          #endif
           return FALSE;
-        }
-
-        switch (test_byte)
-        {
-          case '"':
-          case '\\':
-          case '/':
-            break;
-          case 'b':
-            test_byte = '\b';
-            break;
-          case 'f':
-            test_byte = '\f';
-            break;
-          case 'n':
-            test_byte = '\n';
-            break;
-          case 'r':
-            test_byte = '\r';
-            break;
-          case 't':
-            test_byte = '\t';
-            break;
-          default:
-            #if defined(_DEBUG)
-            OSSpecific_writeDebugMessage(
-              "JSON stream, parsing failed: unknown escape sequence 0x%02X",
-              test_byte);
-            #endif
-            return FALSE;
-        }
       }
 
       if (!UTF8String_pushByte(result[0], test_byte))
       {
         return FALSE;
       }
+
+      unescaped_text = stream->tail;
     }
+
+    JsonByteStream_skip(
+      stream,
+      json_string_scanner(stream->tail, stream->tail_length));
   }
 
   return FALSE;
@@ -134,6 +381,53 @@ JsonString_parse(
 
 /**************************************************************/
 
+BOOL
+JsonString_skip(
+  _Inout_ JsonByteStream *stream)
+{
+  BYTE test_byte;
+
+  /* String starts with '"' */
+
+  if (!JsonByteStream_read(stream, &(test_byte), 1) || ('"' != test_byte))
+  {
+    return FALSE;
+  }
+
+  while (TRUE)
+  {
+    JsonByteStream_skip(
+      stream,
+      json_string_scanner(stream->tail, stream->tail_length));
+
+    if (!JsonByteStream_read(stream, &(test_byte), 1))
+    {
+      return FALSE;
+    }
+
+    if ('"' == test_byte)
+    {
+      /* String ends with '"' */
+      return TRUE;
+    }
+
+    if ('\\' != test_byte)
+    {
+      /* Control character */
+      return FALSE;
+    }
+
+    /* Escaped character is skipped without being checked */
+
+    if (!JsonByteStream_read(stream, &(test_byte), 1))
+    {
+      return FALSE;
+    }
+  }
+}
+
+/**************************************************************/
+
 BOOL
 JsonString_toString(
   _In_ const UTF8String *string,
@@ -141,6 +435,20 @@ JsonString_toString(
 {
   BYTE test_bytes[2] = { 0x00 };
   BOOL test_bool;
+  size_t plain_length;
+
+  /* Multibyte codepoints are validated all at once, */
+  /* and then copied together with the ASCII characters */
+
+  if (!UTF8_validate(string->text, string->length))
+  {
+    #if defined(_DEBUG)
+    OSSpecific_writeDebugMessage(
+      "JsonString::toString(): not a valid UTF-8 representation!");
+    #endif
+
+    return FALSE;
+  }
 
   if (!UTF8String_pushByte(output, '"'))
   {
@@ -149,6 +457,27 @@ JsonString_toString(
 
   for (size_t i = 0; i < string->length;  i++)
   {
+    /* Plain characters are copied in bulk */
+
+    plain_length = json_string_scanner(
+      &(string->text[i]),
+      (string->length - i));
+
+    if ((0 != plain_length) && !UTF8String_pushText(
+      output,
+      (LPCSTR) &(string->text[i]),
+      plain_length))
+    {
+      return FALSE;
+    }
+
+    i += plain_length;
+
+    if (i == string->length)
+    {
+      break;
+    }
+
     test_bytes[1] = string->text[i];
 
     test_bool = TRUE;
@@ -205,35 +534,7 @@ JsonString_toString(
         return FALSE;
       }
     }
-    else if (0x80 & test_bytes[1])
-    {
-      /* Multibyte codepoint */
-
-      size_t remaining_bytes = (string->length - i);
-
-      test_bool = UTF8_validateTransformation(
-        &(string->text[i]),
-        &(remaining_bytes),
-        NULL);
-
-      if (!test_bool)
-      {
-        #if defined(_DEBUG)
-        OSSpecific_writeDebugMessage(
-          "JsonString::toString(): not a valid UTF-8 representation!");
-        #endif
-
-        return FALSE;
-      }
-
-      test_bool = UTF8String_pushText(
-        output,
-        (LPCSTR) &(string->text[i]),
-        remaining_bytes);
-
-      if (!test_bool) { return FALSE; }
-    }
-    else if (test_bytes[1] < ' ')
+    else
     {
       /* Control character escaped in a long form */
 
@@ -247,15 +548,6 @@ JsonString_toString(
         return FALSE;
       }
     }
-    else
-    {
-      /* Regular ASCII printable character */
-
-      if (!UTF8String_pushByte(output, test_bytes[1]))
-      {
-        return FALSE;
-      }
-    }
   }
 
   return UTF8String_pushByte(output, '"');
@@ -11,8 +11,7 @@ VOID
 JsonValue_init(
   _Out_ JsonValue *value)
 {
-  value->type  = JSON_VALUE_TYPE__NULL;
-  value->value = NULL;
+  value->type = JSON_VALUE_TYPE__NULL;
 }
 
 /**************************************************************/
@@ -21,47 +20,30 @@ VOID
 JsonValue_destroy(
   _Inout_ JsonValue *value)
 {
-  if (NULL != value->value)
+  switch (value->type)
   {
-    switch (value->type)
+    case JSON_VALUE_TYPE__STRING:
     {
-      case JSON_VALUE_TYPE__TRUE:
-      case JSON_VALUE_TYPE__FALSE:
-      case JSON_VALUE_TYPE__NULL:
-      {
-        return;
-      }
-      default:
-      {
-        /* Continue with dynamically allocated types */
-      }
+      UTF8String_destroy(&(value->string));
+      break;
     }
-
-    switch (value->type)
+    case JSON_VALUE_TYPE__OBJECT:
     {
-      case JSON_VALUE_TYPE__STRING:
-      {
-        UTF8String_destroy(value->value);
-        break;
-      }
-      case JSON_VALUE_TYPE__OBJECT:
-      {
-        JsonObject_destroy(value->value);
-        break;
-      }
-      case JSON_VALUE_TYPE__ARRAY:
-      {
-        JsonArray_destroy(value->value);
-        break;
-      }
-      default:
-      {
-        /* `JSON_VALUE_TYPE__NUMBER` is just a pointer to one `FLOAT` */
-      }
+      JsonObject_destroy(&(value->object));
+      break;
+    }
+    case JSON_VALUE_TYPE__ARRAY:
+    {
+      JsonArray_destroy(&(value->array));
+      break;
+    }
+    default:
+    {
+      /* Numbers and literals are stored inline */
     }
-
-    free(value->value);
   }
+
+  value->type = JSON_VALUE_TYPE__NULL;
 }
 
 /**************************************************************/
@@ -71,74 +53,78 @@ JsonValue_copy(
   _Out_ JsonValue *destination,
   _In_ const JsonValue *source)
 {
-  size_t byteSize;
-
   /* Copy the JsonValue type field */
 
   destination->type = source->type;
 
-  /* Check if the type points to a dynamic object */
+  /* Deep-copy the types that own some memory */
 
   switch (source->type)
   {
     case JSON_VALUE_TYPE__STRING:
     {
-      byteSize = sizeof(UTF8String);
-      break;
+      return UTF8String_copy(&(destination->string), &(source->string));
     }
     case JSON_VALUE_TYPE__NUMBER:
     {
-      byteSize = sizeof(FLOAT);
-      break;
+      destination->number = source->number;
+      return TRUE;
     }
     case JSON_VALUE_TYPE__OBJECT:
     {
-      byteSize = sizeof(JsonObject);
-      break;
+      return JsonObject_copy(&(destination->object), &(source->object));
     }
     case JSON_VALUE_TYPE__ARRAY:
     {
-      byteSize = sizeof(JsonArray);
-      break;
+      return JsonArray_copy(&(destination->array), &(source->array));
     }
     default:
     {
-      destination->value = source->value;
       return TRUE;
     }
   }
+}
 
-  /* Allocate memory for an object to be cloned */
+/**************************************************************/
 
-  destination->value = malloc(byteSize);
-  if (NULL == destination->value) { return FALSE; }
+VOID
+JsonValue_setInteger(
+  _Out_ JsonValue *value,
+  _In_ const int64_t integer)
+{
+  value->type = JSON_VALUE_TYPE__NUMBER;
 
-  /* `destination->value` points to an UNINITIALIZED object of given type */
+  value->number.integer = integer;
+  value->number.real = (DOUBLE) integer;
+  value->number.isInteger = TRUE;
+}
 
-  switch (source->type)
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonValue` object.
+ * Skips decimal digits of a JSON Number.
+ *
+ * @param[in] text Pointer to the stringified JSON Number.
+ * @param[in] length Number of available bytes.
+ * @param[in,out] indexRef Reference to the current position in `text`.
+ * @return Number of skipped digits.
+ */
+static size_t
+JsonValue_skipDigits(
+  _In_ const BYTE *text,
+  _In_ const size_t length,
+  _Inout_ size_t *indexRef)
+{
+  const size_t start = indexRef[0];
+
+  while ((indexRef[0] < length) &&
+    ((unsigned int) (text[indexRef[0]] - '0') <= 9))
   {
-    case JSON_VALUE_TYPE__STRING:
-    {
-      return UTF8String_copy(destination->value, source->value);
-    }
-    case JSON_VALUE_TYPE__NUMBER:
-    {
-      ((FLOAT *) destination->value)[0] = ((FLOAT *) source->value)[0];
-      return TRUE;
-    }
-    case JSON_VALUE_TYPE__OBJECT:
-    {
-      return JsonObject_copy(destination->value, source->value);
-    }
-    case JSON_VALUE_TYPE__ARRAY:
-    {
-      return JsonArray_copy(destination->value, source->value);
-    }
-    default:
-    {
-      return FALSE;
-    }
+    indexRef[0] += 1;
   }
+
+  return (indexRef[0] - start);
 }
 
 /**************************************************************/
@@ -149,309 +135,190 @@ JsonValue_parseNumber(
   _Inout_ JsonByteStream *stream)
 {
   char buf[256];
-  char *buf_end = buf;
-  char *buf_end_dummy;
-  FLOAT number;
-
-  /* 'A': expecting a minus ('-') or a digit ('0'-'9') */
-  /* 'B': expecting a digit ('0'-'9') */
-  /* 'C': started with zero, expecting a dot ('.') or stream end */
-  /* 'D': expecting digits, dot ('.'), 'e', 'E' or stream end */
-  /* 'E': started fraction, expecting a digit */
-  /* 'F': fraction, expecting digits, 'e', 'E' or stream end */
-  /* 'G': started exp, expecting digits, '-' or '+' */
-  /* 'H': started exp, expecting expecting a digit */
-  /* 'I': exp, expecing digitsor stream end */
-  /* 'J': parsing success (whitespace, comma or closing brackets) */
-  /* any other state: parsing error (unexpected character) */
-  int parser_state = 'A';
-  BYTE test_byte;
+  char *buf_end;
+  const BYTE *text = stream->tail;
+  const size_t length = stream->tail_length;
+  size_t i = 0;
+  size_t digit_count = 0;
+  unsigned int digit;
+  uint64_t magnitude = 0;
+  BOOL negative;
+  BOOL is_integer = TRUE;
+  DOUBLE real;
+
+  /* Optional minus sign */
+
+  negative = (i < length) && ('-' == text[i]);
+  i += negative;
+
+  /* Integer part: either a single zero, or digits without leading zeros */
+  /* (accumulated right away, as most numbers are small integers) */
+
+  if ((i < length) && ('0' == text[i]))
+  {
+    i++;
+    digit_count = 1;
+  }
+  else
+  {
+    while ((i < length) && ((digit = text[i] - '0') <= 9))
+    {
+      magnitude = (magnitude * 10) + digit;
+      i++;
+      digit_count++;
+    }
+  }
 
-  /* In case of parsing failure, dynamic value stays NULL */
+  if (0 == digit_count)
+  {
+    #if defined(_DEBUG)
+    OSSpecific_writeDebugMessage(
+      "JSON number parsing failed: expected a digit");
+    #endif
 
-  value->value = NULL;
+    return FALSE;
+  }
 
-  while ((parser_state >= 'A') && (parser_state <= 'I'))
+  /* 19 digits always fit in `uint64_t`, longer numbers are left to strtod */
+
+  if (digit_count > 19)
+  {
+    is_integer = FALSE;
+  }
+
+  /* Optional fraction */
+
+  if ((i < length) && ('.' == text[i]))
   {
-    if ('A' != parser_state)
+    is_integer = FALSE;
+    i++;
+
+    if (0 == JsonValue_skipDigits(text, length, &(i)))
     {
-      if (!Misc_pushToLocalBuffer(buf, &(buf_end), sizeof(buf), test_byte))
-      {
-        #if defined(_DEBUG)
-        OSSpecific_writeDebugMessage(
-          "JSON number parsing failed: buffer overflow");
-        #endif
+      #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "JSON number parsing failed: expected a digit");
+      #endif
 
-        return FALSE;
-      }
+      return FALSE;
+    }
+  }
 
-      JsonByteStream_skip(stream, 1);
+  /* Optional exponent */
+
+  if ((i < length) && (('e' == text[i]) || ('E' == text[i])))
+  {
+    is_integer = FALSE;
+    i++;
+
+    if ((i < length) && (('-' == text[i]) || ('+' == text[i])))
+    {
+      i++;
     }
 
-    if (!JsonByteStream_peek(stream, &(test_byte)))
+    if (0 == JsonValue_skipDigits(text, length, &(i)))
     {
+      #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "JSON number parsing failed: expected a digit");
+      #endif
+
       return FALSE;
     }
+  }
+
+  /* Number must end on a whitespace, a comma, or a closing bracket */
 
-    switch (parser_state)
+  if (i >= length)
+  {
+    #if defined(_DEBUG)
+    OSSpecific_writeDebugMessage(
+      "JSON number parsing failed: unexpected end of stream");
+    #endif
+
+    return FALSE;
+  }
+
+  switch (text[i])
+  {
+    case ' ': case '\r': case '\n': case '\t':
+    case ',': case ']': case '}':
     {
-      case 'A':
-      {
-        switch (test_byte)
-        {
-          case '0':
-          {
-            parser_state = 'C';
-            break;
-          }
-          case '1': case '2': case '3': case '4':
-          case '5': case '6': case '7': case '8': case '9':
-          {
-            parser_state = 'D';
-            break;
-          }
-          case '-':
-          {
-            parser_state = 'B';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
-      case 'B':
-      {
-        switch (test_byte)
-        {
-          case '0':
-          {
-            parser_state = 'C';
-            break;
-          }
-          case '1': case '2': case '3': case '4':
-          case '5': case '6': case '7': case '8': case '9':
-          {
-            parser_state = 'D';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
-      case 'C':
-      {
-        switch (test_byte)
-        {
-          case '.':
-          {
-            parser_state = 'E';
-            break;
-          }
-          case ' ': case '\r': case '\n': case '\t':
-          case ',': case ']': case '}':
-          {
-            parser_state = 'J';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
-      case 'D':
-      {
-        switch (test_byte)
-        {
-          case '0': case '1': case '2': case '3': case '4':
-          case '5': case '6': case '7': case '8': case '9':
-          {
-            break;
-          }
-          case '.':
-          {
-            parser_state = 'E';
-            break;
-          }
-          case 'E': case 'e':
-          {
-            parser_state = 'G';
-            break;
-          }
-          case ' ': case '\r': case '\n': case '\t':
-          case ',': case ']': case '}':
-          {
-            parser_state = 'J';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
-      case 'E':
-      {
-        switch (test_byte)
-        {
-          case '0': case '1': case '2': case '3': case '4':
-          case '5': case '6': case '7': case '8': case '9':
-          {
-            parser_state = 'F';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
-      case 'F':
-      {
-        switch (test_byte)
-        {
-          case '0': case '1': case '2': case '3': case '4':
-          case '5': case '6': case '7': case '8': case '9':
-          {
-            break;
-          }
-          case 'E': case 'e':
-          {
-            parser_state = 'G';
-            break;
-          }
-          case ' ': case '\r': case '\n': case '\t':
-          case ',': case ']': case '}':
-          {
-            parser_state = 'J';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
-      case 'G':
-      {
-        switch (test_byte)
-        {
-          case '0': case '1': case '2': case '3': case '4':
-          case '5': case '6': case '7': case '8': case '9':
-          {
-            parser_state = 'I';
-            break;
-          }
-          case '-': case '+':
-          {
-            parser_state = 'H';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
-      case 'H':
-      {
-        switch (test_byte)
-        {
-          case '0': case '1': case '2': case '3': case '4':
-          case '5': case '6': case '7': case '8': case '9':
-          {
-            parser_state = 'I';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
-      case 'I':
-      {
-        switch (test_byte)
-        {
-          case '0': case '1': case '2': case '3': case '4':
-          case '5': case '6': case '7': case '8': case '9':
-          {
-            break;
-          }
-          case ' ': case '\r': case '\n': case '\t':
-          case ',': case ']': case '}':
-          {
-            parser_state = 'J';
-            break;
-          }
-          default:
-          {
-            parser_state = 0;
-          }
-        }
-
-        break;
-      }
+      break;
     }
+    default:
+    {
+      #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "JSON number parsing failed: unexpected character 0x%02X",
+        text[i]);
+      #endif
+
+      return FALSE;
+    }
+  }
+
+  /* Fast path: exact integer within the `int64_t` range */
+
+  if (is_integer && (magnitude <= ((uint64_t) INT64_MAX + negative)))
+  {
+    JsonValue_setInteger(
+      value,
+      negative ?
+        (int64_t) (0 - magnitude) :
+        (int64_t) magnitude);
+
+    JsonByteStream_skip(stream, i);
+    return TRUE;
   }
 
-  /* Parsing completed, check if any errors occurred */
+  /* Otherwise, try to parse a DOUBLE */
 
-  if ('J' != parser_state)
+  if (i >= sizeof(buf))
   {
     #if defined(_DEBUG)
     OSSpecific_writeDebugMessage(
-      "JSON number parsing failed: unexpected character 0x%02X",
-      test_byte);
+      "JSON number parsing failed: buffer overflow");
     #endif
 
     return FALSE;
   }
 
-  /* Otherwise, try to parse a FLOAT */
-
-  buf_end[0] = 0;
+  memcpy(buf, text, i);
+  buf[i] = 0;
 
   errno = 0;
-  number = strtof(buf, &(buf_end_dummy));
-  if ((0 != errno) || (buf_end_dummy != buf_end))
+  real = strtod(buf, &(buf_end));
+  if ((0 != errno) || (buf_end != &(buf[i])))
   {
     #if defined(_DEBUG)
     OSSpecific_writeDebugMessage(
-      "{strtof} failed: errno=0x%08X",
+      "{strtod} failed: errno=0x%08X",
       errno);
     #endif
 
     return FALSE;
   }
 
-  value->value = malloc(sizeof(FLOAT));
-  if (NULL == value->value)
+  value->number.real = real;
+  value->number.isInteger = FALSE;
+
+  /* Truncated value, for the callers expecting integers */
+
+  if (real >= 9223372036854775808.0)
   {
-    return FALSE;
+    value->number.integer = INT64_MAX;
+  }
+  else if (real <= -9223372036854775808.0)
+  {
+    value->number.integer = INT64_MIN;
+  }
+  else
+  {
+    value->number.integer = (int64_t) real;
   }
 
-  ((FLOAT *) value->value)[0] = number;
+  JsonByteStream_skip(stream, i);
   return TRUE;
 }
 
@@ -464,10 +331,13 @@ JsonValue_parse(
   _Inout_ JsonByteStream *stream)
 {
   BYTE test_bytes[2][4];
+  UTF8String *string_pointer;
+  JsonObject *object_pointer;
+  JsonArray *array_pointer;
 
   if (allocate)
   {
-    result[0] = malloc(sizeof(JsonValue));
+    result[0] = JsonArena_allocate(sizeof(JsonValue));
     if (NULL == result[0]) { return FALSE; }
   }
   JsonValue_init(result[0]);
@@ -488,8 +358,9 @@ JsonValue_parse(
     {
       /* string value */
       result[0]->type = JSON_VALUE_TYPE__STRING;
+      string_pointer = &(result[0]->string);
 
-      if (!JsonString_parse((UTF8String **) &(result[0]->value), TRUE, stream))
+      if (!JsonString_parse(&(string_pointer), FALSE, stream))
       {
         return FALSE;
       }
@@ -514,8 +385,9 @@ JsonValue_parse(
     {
       /* object value */
       result[0]->type = JSON_VALUE_TYPE__OBJECT;
+      object_pointer = &(result[0]->object);
 
-      if (!JsonObject_parse((JsonObject **) &(result[0]->value), TRUE, stream))
+      if (!JsonObject_parse(&(object_pointer), FALSE, stream))
       {
         return FALSE;
       }
@@ -526,8 +398,9 @@ JsonValue_parse(
     {
       /* array value */
       result[0]->type = JSON_VALUE_TYPE__ARRAY;
+      array_pointer = &(result[0]->array);
 
-      if (!JsonArray_parse((JsonArray **) &(result[0]->value), stream))
+      if (!JsonArray_parse(&(array_pointer), FALSE, stream))
       {
         return FALSE;
       }
@@ -539,6 +412,10 @@ JsonValue_parse(
       /* true value */
       result[0]->type = JSON_VALUE_TYPE__TRUE;
 
+      /* Skip the already peeked first letter */
+
+      JsonByteStream_skip(stream, 1);
+
       if (!JsonByteStream_read(stream, test_bytes[0], 3))
       {
         return FALSE;
@@ -565,6 +442,10 @@ JsonValue_parse(
       /* false value */
       result[0]->type = JSON_VALUE_TYPE__FALSE;
 
+      /* Skip the already peeked first letter */
+
+      JsonByteStream_skip(stream, 1);
+
       if (!JsonByteStream_read(stream, test_bytes[0], 4))
       {
         return FALSE;
@@ -592,6 +473,10 @@ JsonValue_parse(
       /* null value */
       result[0]->type = JSON_VALUE_TYPE__NULL;
 
+      /* Skip the already peeked first letter */
+
+      JsonByteStream_skip(stream, 1);
+
       if (!JsonByteStream_read(stream, test_bytes[0], 3))
       {
         return FALSE;
@@ -651,33 +536,225 @@ JsonValue_parse(
 
 /**************************************************************/
 
+BOOL
+JsonValue_skip(
+  _Inout_ JsonByteStream *stream)
+{
+  BYTE test_byte;
+  BYTE closing_byte;
+  JsonValue json_value;
+  JsonValue *json_value_ptr = &(json_value);
+  size_t count = 0;
+
+  if (!JsonByteStream_skipWhitespace(stream))
+  {
+    return FALSE;
+  }
+
+  if (!JsonByteStream_peek(stream, &(test_byte)))
+  {
+    return FALSE;
+  }
+
+  switch (test_byte)
+  {
+    case '"':
+    {
+      return JsonString_skip(stream);
+    }
+    case '{':
+    {
+      closing_byte = '}';
+      break;
+    }
+    case '[':
+    {
+      closing_byte = ']';
+      break;
+    }
+    default:
+    {
+      /* Numbers and literals do not allocate any memory */
+
+      return JsonValue_parse(&(json_value_ptr), FALSE, stream);
+    }
+  }
+
+  /* Elements of an object or an array are skipped one by one */
+
+  JsonByteStream_skip(stream, 1);
+
+  if (!JsonByteStream_enter(stream) || !JsonByteStream_skipWhitespace(stream))
+  {
+    return FALSE;
+  }
+
+  while (JsonByteStream_peek(stream, &(test_byte)))
+  {
+    if (closing_byte == test_byte)
+    {
+      JsonByteStream_skip(stream, 1);
+      JsonByteStream_leave(stream);
+      return TRUE;
+    }
+
+    if (0 != count)
+    {
+      if (',' != test_byte)
+      {
+        return FALSE;
+      }
+
+      JsonByteStream_skip(stream, 1);
+
+      if (!JsonByteStream_skipWhitespace(stream))
+      {
+        return FALSE;
+      }
+    }
+
+    /* Object members start with a key and a colon */
+
+    if ('}' == closing_byte)
+    {
+      if (!JsonString_skip(stream) ||
+        !JsonByteStream_skipWhitespace(stream) ||
+        !JsonByteStream_read(stream, &(test_byte), 1) ||
+        (':' != test_byte))
+      {
+        return FALSE;
+      }
+    }
+
+    if (!JsonValue_skip(stream) || !JsonByteStream_skipWhitespace(stream))
+    {
+      return FALSE;
+    }
+
+    count++;
+  }
+
+  return FALSE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonValue` object.
+ * Writes decimal digits of an integer backwards, two digits at a time.
+ *
+ * @param[out] bufferEnd Pointer just past the end of a text buffer
+ * (at least 20 characters long).
+ * @param[in] integer Number to be formatted.
+ * @return Pointer to the first character of the formatted number.
+ * The text is NOT NULL-terminated.
+ */
+static LPSTR
+JsonValue_formatInteger(
+  _Out_ LPSTR bufferEnd,
+  _In_ const int64_t integer)
+{
+  static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+  uint64_t magnitude = (integer < 0) ?
+    (0 - (uint64_t) integer) :
+    (uint64_t) integer;
+  size_t pair_index;
+  LPSTR text = bufferEnd;
+
+  while (magnitude >= 100)
+  {
+    pair_index = (size_t) (magnitude % 100) * 2;
+    magnitude /= 100;
+
+    text -= 2;
+    text[0] = digit_pairs[pair_index];
+    text[1] = digit_pairs[pair_index + 1];
+  }
+
+  if (magnitude >= 10)
+  {
+    pair_index = (size_t) magnitude * 2;
+
+    text -= 2;
+    text[0] = digit_pairs[pair_index];
+    text[1] = digit_pairs[pair_index + 1];
+  }
+  else
+  {
+    text -= 1;
+    text[0] = (char) ('0' + magnitude);
+  }
+
+  if (integer < 0)
+  {
+    text -= 1;
+    text[0] = '-';
+  }
+
+  return text;
+}
+
+/**************************************************************/
+
 BOOL
 JsonValue_toString(
   _In_ const JsonValue *value,
   _Inout_ UTF8String *output)
 {
-  char number_buffer[64];
-  FLOAT value_number;
+  char number_buffer[32];
+  LPSTR number_text;
 
   switch (value->type)
   {
     case JSON_VALUE_TYPE__STRING:
     {
-      return JsonString_toString(value->value, output);
+      return JsonString_toString(&(value->string), output);
     }
     case JSON_VALUE_TYPE__NUMBER:
     {
-      value_number = ((FLOAT *) value->value)[0];
-      snprintf(number_buffer, 64, "%.f", value_number);
+      if (value->number.isInteger)
+      {
+        number_text = JsonValue_formatInteger(
+          &(number_buffer[sizeof(number_buffer)]),
+          value->number.integer);
+
+        return UTF8String_pushText(
+          output,
+          number_text,
+          &(number_buffer[sizeof(number_buffer)]) - number_text);
+      }
+
+      /* Shortest of the two precisions that reads back exactly */
+
+      snprintf(number_buffer, sizeof(number_buffer), "%.15g",
+        value->number.real);
+
+      if (strtod(number_buffer, NULL) != value->number.real)
+      {
+        snprintf(number_buffer, sizeof(number_buffer), "%.17g",
+          value->number.real);
+      }
+
       return UTF8String_pushText(output, number_buffer, 0);
     }
     case JSON_VALUE_TYPE__OBJECT:
     {
-      return JsonObject_toString(value->value, output);
+      return JsonObject_toString(&(value->object), output);
     }
     case JSON_VALUE_TYPE__ARRAY:
     {
-      return JsonArray_toString(value->value, output);
+      return JsonArray_toString(&(value->array), output);
     }
     case JSON_VALUE_TYPE__TRUE:
     {
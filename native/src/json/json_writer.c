@@ -0,0 +1,411 @@
+/**
+ * @file "native/src/json/json_writer.c"
+ * Simplified handling of the JSON data.
+ */
+
+#include "json/json.h"
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonWriter` object.
+ * Remembers a failed write.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] result Result of the write operation.
+ * @return `result`.
+ */
+static BOOL
+JsonWriter_check(
+  _Inout_ JsonWriter *writer,
+  _In_ const BOOL result)
+{
+  if (!result)
+  {
+    writer->failed = TRUE;
+  }
+
+  return result;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonWriter` object.
+ * Truncates the queue buffer.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] length New length of the queue buffer.
+ */
+static VOID
+JsonWriter_truncate(
+  _Inout_ JsonWriter *writer,
+  _In_ const size_t length)
+{
+  UTF8String *buffer = &(writer->queue->buffer);
+
+  if (length < buffer->length)
+  {
+    buffer->length = length;
+    buffer->text[length] = '\0';
+  }
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonWriter` object.
+ * Prepares for the next element (a key, or a value),
+ * putting a comma after the previous one.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @return `TRUE` if the element can be written, `FALSE` if the writer
+ * has already failed or on memory allocation failure.
+ */
+static BOOL
+JsonWriter_prepare(
+  _Inout_ JsonWriter *writer)
+{
+  if (writer->failed || (0 == writer->depth))
+  {
+    return FALSE;
+  }
+
+  if (writer->separate)
+  {
+    writer->separate = FALSE;
+
+    return JsonWriter_check(
+      writer,
+      UTF8String_pushByte(&(writer->queue->buffer), ','));
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `JsonWriter` object.
+ * Opens a nested container.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @param[in] opener Opening bracket.
+ * @param[in] closer Matching closing bracket.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * OR when too many containers are nested.
+ */
+static BOOL
+JsonWriter_open(
+  _Inout_ JsonWriter *writer,
+  _In_ const BYTE opener,
+  _In_ const BYTE closer)
+{
+  if (!JsonWriter_prepare(writer)) { return FALSE; }
+
+  if (JSON_WRITER__MAX_DEPTH == writer->depth)
+  {
+    return JsonWriter_check(writer, FALSE);
+  }
+
+  if (!JsonWriter_check(
+    writer,
+    UTF8String_pushByte(&(writer->queue->buffer), opener)))
+  {
+    return FALSE;
+  }
+
+  writer->closers[writer->depth] = closer;
+  writer->depth += 1;
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_begin(
+  _Out_ JsonWriter *writer,
+  _Inout_ JsonOutputQueue *queue)
+{
+  writer->queue = queue;
+  writer->frameStart = queue->buffer.length;
+  writer->depth = 0;
+  writer->separate = FALSE;
+  writer->failed = FALSE;
+
+  /* Reserve space for the length prefix */
+  /* ("native byte order", no need to check for endianness) */
+
+  if (!UTF8String_pushText(&(queue->buffer), "\0\0\0\0{", 5))
+  {
+    /* `depth` stays at zero, so every element is refused */
+
+    JsonWriter_truncate(writer, writer->frameStart);
+    writer->failed = TRUE;
+    return FALSE;
+  }
+
+  writer->closers[0] = '}';
+  writer->depth = 1;
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_finish(
+  _Inout_ JsonWriter *writer)
+{
+  UTF8String *buffer = &(writer->queue->buffer);
+  uint32_t json_length;
+
+  /* Close the nested containers (and the message itself) */
+
+  while ((!writer->failed) && (writer->depth > 1))
+  {
+    JsonWriter_end(writer);
+  }
+
+  if ((!writer->failed) && (0 != writer->depth))
+  {
+    JsonWriter_check(
+      writer,
+      UTF8String_pushByte(buffer, writer->closers[0]));
+  }
+
+  if (writer->failed || (0 == writer->depth))
+  {
+    JsonWriter_discard(writer);
+    return FALSE;
+  }
+
+  writer->depth = 0;
+
+  json_length = (uint32_t)
+    (buffer->length - writer->frameStart - sizeof(uint32_t));
+
+  memcpy(
+    &(buffer->text[writer->frameStart]),
+    &(json_length),
+    sizeof(uint32_t));
+
+  writer->queue->count += 1;
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+VOID
+JsonWriter_discard(
+  _Inout_ JsonWriter *writer)
+{
+  JsonWriter_truncate(writer, writer->frameStart);
+
+  writer->depth = 0;
+}
+
+/**************************************************************/
+
+VOID
+JsonWriter_mark(
+  _In_ const JsonWriter *writer,
+  _Out_ JsonWriterMark *mark)
+{
+  mark->length = writer->queue->buffer.length;
+  mark->depth = writer->depth;
+  mark->separate = writer->separate;
+}
+
+/**************************************************************/
+
+VOID
+JsonWriter_rollback(
+  _Inout_ JsonWriter *writer,
+  _In_ const JsonWriterMark *mark)
+{
+  JsonWriter_truncate(writer, mark->length);
+
+  writer->depth = mark->depth;
+  writer->separate = mark->separate;
+  writer->failed = FALSE;
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_key(
+  _Inout_ JsonWriter *writer,
+  _In_z_ LPCSTR key)
+{
+  UTF8String utf8_key;
+
+  if (!JsonWriter_prepare(writer)) { return FALSE; }
+
+  UTF8String_makeTemporary(&(utf8_key), key);
+
+  return JsonWriter_check(
+    writer,
+    JsonString_toString(&(utf8_key), &(writer->queue->buffer)) &&
+    UTF8String_pushByte(&(writer->queue->buffer), ':'));
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_string(
+  _Inout_ JsonWriter *writer,
+  _In_ const UTF8String *string)
+{
+  if (!JsonWriter_prepare(writer)) { return FALSE; }
+
+  writer->separate = TRUE;
+
+  return JsonWriter_check(
+    writer,
+    JsonString_toString(string, &(writer->queue->buffer)));
+}
+
+/**************************************************************/
+
+UTF8String *
+JsonWriter_openString(
+  _Inout_ JsonWriter *writer)
+{
+  if (!JsonWriter_prepare(writer)) { return NULL; }
+
+  if (!JsonWriter_check(
+    writer,
+    UTF8String_pushByte(&(writer->queue->buffer), '"')))
+  {
+    return NULL;
+  }
+
+  return &(writer->queue->buffer);
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_closeString(
+  _Inout_ JsonWriter *writer)
+{
+  if (writer->failed || (0 == writer->depth)) { return FALSE; }
+
+  writer->separate = TRUE;
+
+  return JsonWriter_check(
+    writer,
+    UTF8String_pushByte(&(writer->queue->buffer), '"'));
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_hex(
+  _Inout_ JsonWriter *writer,
+  _In_ const size_t count,
+  _In_ const BYTE *bytes)
+{
+  UTF8String *buffer = JsonWriter_openString(writer);
+
+  if (NULL == buffer) { return FALSE; }
+
+  if (!JsonWriter_check(
+    writer,
+    UTF8String_pushBytesAsHex(buffer, count, bytes)))
+  {
+    return FALSE;
+  }
+
+  return JsonWriter_closeString(writer);
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_integer(
+  _Inout_ JsonWriter *writer,
+  _In_ const int64_t integer)
+{
+  JsonValue json_value;
+
+  JsonValue_setInteger(&(json_value), integer);
+
+  return JsonWriter_value(writer, &(json_value));
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_boolean(
+  _Inout_ JsonWriter *writer,
+  _In_ const BOOL boolean)
+{
+  JsonValue json_value;
+
+  json_value.type = boolean ?
+    JSON_VALUE_TYPE__TRUE :
+    JSON_VALUE_TYPE__FALSE;
+
+  return JsonWriter_value(writer, &(json_value));
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_value(
+  _Inout_ JsonWriter *writer,
+  _In_ const JsonValue *value)
+{
+  if (!JsonWriter_prepare(writer)) { return FALSE; }
+
+  writer->separate = TRUE;
+
+  return JsonWriter_check(
+    writer,
+    JsonValue_toString(value, &(writer->queue->buffer)));
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_beginObject(
+  _Inout_ JsonWriter *writer)
+{
+  return JsonWriter_open(writer, '{', '}');
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_beginArray(
+  _Inout_ JsonWriter *writer)
+{
+  return JsonWriter_open(writer, '[', ']');
+}
+
+/**************************************************************/
+
+BOOL
+JsonWriter_end(
+  _Inout_ JsonWriter *writer)
+{
+  if (writer->failed || (writer->depth <= 1))
+  {
+    return JsonWriter_check(writer, FALSE);
+  }
+
+  writer->depth -= 1;
+  writer->separate = TRUE;
+
+  return JsonWriter_check(
+    writer,
+    UTF8String_pushByte(
+      &(writer->queue->buffer),
+      writer->closers[writer->depth]));
+}
+
+/**************************************************************/
@@ -5,6 +5,10 @@
 
 #include "misc/misc.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+  #include <cpuid.h>
+#endif
+
 /**************************************************************/
 
 size_t
@@ -51,6 +55,66 @@ Misc_nextPowerOfTwo(
 
 /**************************************************************/
 
+uint32_t
+Misc_getCpuFeatures(void)
+{
+  uint32_t features = 0;
+
+  #if defined(__x86_64__) || defined(__i386__)
+  {
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0_low, xcr0_high;
+
+    if (!__get_cpuid(1, &(eax), &(ebx), &(ecx), &(edx)))
+    {
+      return 0;
+    }
+
+    if (bit_SSE2 & edx)
+    {
+      features |= MISC_CPU_FEATURE__SSE2;
+    }
+
+    if (bit_SSSE3 & ecx)
+    {
+      features |= MISC_CPU_FEATURE__SSSE3;
+    }
+
+    /* AVX2 needs the Operating System to save the YMM registers */
+    /* on context switch ("XGETBV" is allowed only with "OSXSAVE") */
+
+    if ((0 == (bit_OSXSAVE & ecx)) || (0 == (bit_AVX & ecx)))
+    {
+      return features;
+    }
+
+    __asm__ volatile (
+      "xgetbv" : "=a" (xcr0_low), "=d" (xcr0_high) : "c" (0));
+
+    if (0x06 != (0x06 & xcr0_low))  /* XMM and YMM state */
+    {
+      return features;
+    }
+
+    if (__get_cpuid_count(7, 0, &(eax), &(ebx), &(ecx), &(edx)) &&
+      (bit_AVX2 & ebx))
+    {
+      features |= MISC_CPU_FEATURE__AVX2;
+    }
+  }
+  #elif defined(__aarch64__)
+  {
+    /* Advanced SIMD is a mandatory part of ARMv8-A */
+
+    features |= MISC_CPU_FEATURE__NEON;
+  }
+  #endif
+
+  return features;
+}
+
+/**************************************************************/
+
 BOOL
 Misc_pushToLocalBuffer(
   _In_ const LPCSTR bufferStart,
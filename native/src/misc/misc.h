@@ -17,6 +17,27 @@
 /* MISCELLANEOUS                                              */
 /**************************************************************/
 
+/**
+ * Processor supports the SSE2 instruction set (x86 and x86-64).
+ */
+#define MISC_CPU_FEATURE__SSE2  0x01
+
+/**
+ * Processor supports the AVX2 instruction set (x86 and x86-64),
+ * and the Operating System preserves the 256-bit registers.
+ */
+#define MISC_CPU_FEATURE__AVX2  0x02
+
+/**
+ * Processor supports the NEON (Advanced SIMD) instruction set (ARM64).
+ */
+#define MISC_CPU_FEATURE__NEON  0x04
+
+/**
+ * Processor supports the SSSE3 instruction set (x86 and x86-64).
+ */
+#define MISC_CPU_FEATURE__SSSE3  0x08
+
 /**
  * @brief Get the number of elements in a multi-string list.
  *
@@ -42,6 +63,15 @@ extern size_t
 Misc_nextPowerOfTwo(
   _In_ size_t number);
 
+/**
+ * @brief Detect vector instruction sets available at runtime.
+ *
+ * @return Combination of `MISC_CPU_FEATURE__*` flags
+ * (zero when only the generic code can be used).
+ */
+extern uint32_t
+Misc_getCpuFeatures(void);
+
 /**
  * @brief Push an ASCII character into a local text buffer.
  *
@@ -230,6 +230,245 @@ OSSpecific_peekStream(
 
 /**************************************************************/
 
+#if defined(_WIN32)
+
+  /**
+   * Anonymous pipes cannot be waited on (such handles are always signaled).
+   * A helper thread issues zero-byte reads, which block until some data
+   * arrives, and then signals the `streamReady` event. The thread parks
+   * until the waiting side asks for another round (`streamRearm` event).
+   *
+   * I/O on a synchronous handle is serialized, so a pending zero-byte
+   * read would also block `PeekNamedPipe` and `ReadFile` of the main
+   * thread. The helper thread must therefore be parked whenever the
+   * waiting function returns (see `OSSpecific_parkStreamWatcher`).
+   */
+
+  static HANDLE OSSpecific_streamReady = NULL;
+  static HANDLE OSSpecific_streamRearm = NULL;
+  static HANDLE OSSpecific_streamThread = NULL;
+
+  static DWORD WINAPI
+  OSSpecific_streamWatcher(
+    _In_ LPVOID param)
+  {
+    BYTE dummy;
+    DWORD test_dword;
+
+    while (TRUE)
+    {
+      if (!ReadFile((HANDLE) param, &(dummy), 0, &(test_dword), NULL) &&
+        (ERROR_OPERATION_ABORTED != GetLastError()))
+      {
+        /* Broken pipe: let the waiting side find out by peeking */
+        SetEvent(OSSpecific_streamReady);
+        return 0;
+      }
+
+      SetEvent(OSSpecific_streamReady);
+      WaitForSingleObject(OSSpecific_streamRearm, INFINITE);
+    }
+  }
+
+  /**
+   * Cancels the pending zero-byte read (if any) and waits until
+   * the helper thread parks itself (or quits on a broken pipe).
+   * The read might not have been issued yet when `CancelSynchronousIo`
+   * is called, so the cancellation is repeated until it takes effect.
+   */
+  static VOID
+  OSSpecific_parkStreamWatcher(void)
+  {
+    HANDLE handles[2] = {OSSpecific_streamReady, OSSpecific_streamThread};
+
+    do
+    {
+      CancelSynchronousIo(OSSpecific_streamThread);
+    }
+    while (WAIT_TIMEOUT == WaitForMultipleObjects(2, handles, FALSE, 1));
+  }
+
+#endif
+
+/**************************************************************/
+
+int
+OSSpecific_waitForStream(
+  _In_ const os_specific_stream_t stream,
+  _In_opt_ os_specific_event_t *event,
+  _In_ const uint32_t timeout)
+{
+  #if defined(_WIN32)
+  {
+    uint32_t pipe_length;
+    uint64_t deadline = OSSpecific_getMonotonicTime() + timeout;
+    uint64_t now;
+    DWORD wait_result;
+    HANDLE handles[2];
+    BOOL event_signaled = FALSE;
+
+    while (TRUE)
+    {
+      /* Consume the event (auto-reset) before peeking, */
+      /* so that no signal is lost between the two checks */
+
+      if ((NULL != event) &&
+        (WAIT_OBJECT_0 == WaitForSingleObject(event[0], 0)))
+      {
+        event_signaled = TRUE;
+      }
+
+      if (!OSSpecific_peekStream(stream, &(pipe_length)))
+      {
+        return OS_SPECIFIC_WAIT__FAILED;
+      }
+
+      if (pipe_length > 0)
+      {
+        return OS_SPECIFIC_WAIT__STREAM;
+      }
+
+      if (event_signaled)
+      {
+        return OS_SPECIFIC_WAIT__EVENT;
+      }
+
+      now = OSSpecific_getMonotonicTime();
+
+      if (now >= deadline)
+      {
+        return OS_SPECIFIC_WAIT__TIMEOUT;
+      }
+
+      if (NULL == OSSpecific_streamReady)
+      {
+        OSSpecific_streamReady = CreateEvent(NULL, FALSE, FALSE, NULL);
+        OSSpecific_streamRearm = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+        if ((NULL == OSSpecific_streamReady) ||
+          (NULL == OSSpecific_streamRearm))
+        {
+          return OS_SPECIFIC_WAIT__FAILED;
+        }
+
+        /* The handle is kept open for `CancelSynchronousIo` */
+
+        OSSpecific_streamThread = CreateThread(
+          NULL,
+          0,
+          OSSpecific_streamWatcher,
+          (LPVOID) stream,
+          0,
+          NULL);
+
+        if (NULL == OSSpecific_streamThread)
+        {
+          return OS_SPECIFIC_WAIT__FAILED;
+        }
+      }
+      else
+      {
+        SetEvent(OSSpecific_streamRearm);
+      }
+
+      handles[0] = OSSpecific_streamReady;
+      handles[1] = (NULL != event) ? event[0] : NULL;
+
+      wait_result = WaitForMultipleObjects(
+        (NULL != event) ? 2 : 1,
+        handles,
+        FALSE,
+        (OS_SPECIFIC_INFINITE == timeout) ?
+          INFINITE :
+          (DWORD) (deadline - now));
+
+      if (WAIT_OBJECT_0 != wait_result)
+      {
+        /* Woken by the event or by the timeout: the zero-byte read */
+        /* is still pending and would block the next peek */
+
+        OSSpecific_parkStreamWatcher();
+
+        if ((WAIT_OBJECT_0 + 1) == wait_result)
+        {
+          event_signaled = TRUE;
+        }
+      }
+    }
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    int32_t result;
+    BYTE drain[64];
+
+    struct pollfd fds[2] =
+    {
+      {
+        .fd = stream,
+        .events = POLLIN
+      },
+      {
+        .fd = (NULL != event) ? event->readEnd : (-1),
+        .events = POLLIN
+      }
+    };
+
+    result = poll(
+      fds,
+      (NULL != event) ? 2 : 1,
+      (OS_SPECIFIC_INFINITE == timeout) ? (-1) : (int) timeout);
+
+    if ((-1) == result)
+    {
+      if (EINTR == errno)
+      {
+        /* Interrupted by a signal - let the caller recalculate timeout */
+        return OS_SPECIFIC_WAIT__TIMEOUT;
+      }
+
+      #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "{poll} failed: errno=0x%08X",
+        errno);
+      #endif
+
+      return OS_SPECIFIC_WAIT__FAILED;
+    }
+    else if (0 == result)
+    {
+      return OS_SPECIFIC_WAIT__TIMEOUT;
+    }
+
+    if ((NULL != event) && (POLLIN & fds[1].revents))
+    {
+      /* Reset the event: empty the non-blocking pipe */
+
+      while (read(event->readEnd, drain, sizeof(drain)) > 0) {}
+    }
+
+    /* Pending bytes go first (even if macOS reports `POLLHUP` too): */
+    /* reading a closed pipe returns zero bytes, which ends the loop */
+
+    if (POLLIN & fds[0].revents)
+    {
+      return OS_SPECIFIC_WAIT__STREAM;
+    }
+    else if (0 != fds[0].revents)
+    {
+      return OS_SPECIFIC_WAIT__FAILED;
+    }
+
+    return OS_SPECIFIC_WAIT__EVENT;
+  }
+  #else
+  {
+    return OS_SPECIFIC_WAIT__FAILED;
+  }
+  #endif
+}
+
+/**************************************************************/
+
 BOOL
 OSSpecific_readBytesFromStream(
   _In_ const os_specific_stream_t stream,
@@ -292,6 +531,95 @@ OSSpecific_readBytesFromStream(
 
 /**************************************************************/
 
+BOOL
+OSSpecific_readAvailableBytesFromStream(
+  _In_ const os_specific_stream_t stream,
+  _Out_ void *output,
+  _In_ const size_t size,
+  _Out_ size_t *bytesRead)
+{
+  bytesRead[0] = 0;
+
+  #if defined(_WIN32)
+  {
+    BOOL test_bool;
+    DWORD test_dword;
+    uint32_t pipe_length;
+
+    /* Never ask for more than is already in the pipe, */
+    /* otherwise `ReadFile` would wait for the missing bytes */
+
+    if (!OSSpecific_peekStream(stream, &(pipe_length)))
+    {
+      return FALSE;
+    }
+
+    if (0 == pipe_length)
+    {
+      return TRUE;
+    }
+
+    test_bool = ReadFile(
+      stream,
+      output,
+      (pipe_length < size) ? pipe_length : (DWORD) size,
+      &(test_dword),
+      NULL);
+
+    if (!test_bool)
+    {
+      #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "{ReadFile} failed: 0x%08X",
+        GetLastError());
+      #endif
+
+      return FALSE;
+    }
+
+    bytesRead[0] = test_dword;
+
+    return TRUE;
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    /* A pipe returns whatever is pending (up to `size`) */
+
+    ssize_t result = read(stream, output, size);
+
+    if (((-1) == result) && (EINTR == errno))
+    {
+      /* Interrupted by a signal before anything was read */
+      return TRUE;
+    }
+
+    if (result <= 0)
+    {
+      /* Zero means that the writing end of the pipe was closed */
+
+      #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "{read} failed: result=%d errno=0x%08X",
+        (int) result,
+        errno);
+      #endif
+
+      return FALSE;
+    }
+
+    bytesRead[0] = (size_t) result;
+
+    return TRUE;
+  }
+  #else
+  {
+    return FALSE;
+  }
+  #endif
+}
+
+/**************************************************************/
+
 BOOL
 OSSpecific_writeBytesToStream(
   _In_ const os_specific_stream_t stream,
@@ -376,6 +704,433 @@ OSSpecific_writeBytesToStream(
 
 /**************************************************************/
 
+/**
+ * Both `CreateThread` and `pthread_create` expect a routine with
+ * a platform-specific signature, so a small heap-allocated block
+ * carries the portable routine and its parameter to the new thread.
+ */
+typedef struct
+{
+  os_specific_thread_routine_t routine;
+  LPVOID param;
+}
+OSSpecific_threadStart;
+
+#if defined(_WIN32)
+
+  static DWORD WINAPI
+  OSSpecific_threadEntry(
+    _In_ LPVOID param)
+  {
+    OSSpecific_threadStart start = ((OSSpecific_threadStart *) param)[0];
+
+    free(param);
+    start.routine(start.param);
+
+    return 0;
+  }
+
+#elif defined(__linux__) || defined(__APPLE__)
+
+  static void *
+  OSSpecific_threadEntry(
+    _In_ void *param)
+  {
+    OSSpecific_threadStart start = ((OSSpecific_threadStart *) param)[0];
+
+    free(param);
+    start.routine(start.param);
+
+    return NULL;
+  }
+
+#endif
+
+BOOL
+OSSpecific_createThread(
+  _Out_ os_specific_thread_t *threadRef,
+  _In_ os_specific_thread_routine_t routine,
+  _In_opt_ LPVOID param)
+{
+  OSSpecific_threadStart *start = malloc(sizeof(OSSpecific_threadStart));
+  if (NULL == start) { return FALSE; }
+
+  start->routine = routine;
+  start->param = param;
+
+  #if defined(_WIN32)
+  {
+    threadRef[0] = CreateThread(
+      NULL,
+      0,
+      OSSpecific_threadEntry,
+      (LPVOID) start,
+      0,
+      NULL);
+
+    if (NULL != threadRef[0]) { return TRUE; }
+
+    #if defined(_DEBUG)
+    OSSpecific_writeDebugMessage(
+      "{CreateThread} failed: 0x%08X",
+      GetLastError());
+    #endif
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    int result = pthread_create(
+      threadRef,
+      NULL,
+      OSSpecific_threadEntry,
+      (void *) start);
+
+    if (0 == result) { return TRUE; }
+
+    #if defined(_DEBUG)
+    OSSpecific_writeDebugMessage(
+      "{pthread_create} failed: errno=0x%08X",
+      result);
+    #endif
+  }
+  #endif
+
+  free(start);
+  return FALSE;
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_joinThread(
+  _In_ os_specific_thread_t thread)
+{
+  #if defined(_WIN32)
+  {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    pthread_join(thread, NULL);
+  }
+  #endif
+}
+
+/**************************************************************/
+
+BOOL
+OSSpecific_initMutex(
+  _Out_ os_specific_mutex_t *mutex)
+{
+  #if defined(_WIN32)
+  {
+    InitializeCriticalSection(mutex);
+    return TRUE;
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    return (0 == pthread_mutex_init(mutex, NULL));
+  }
+  #else
+  {
+    return FALSE;
+  }
+  #endif
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_destroyMutex(
+  _Inout_ os_specific_mutex_t *mutex)
+{
+  #if defined(_WIN32)
+  {
+    DeleteCriticalSection(mutex);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    pthread_mutex_destroy(mutex);
+  }
+  #endif
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_lockMutex(
+  _Inout_ os_specific_mutex_t *mutex)
+{
+  #if defined(_WIN32)
+  {
+    EnterCriticalSection(mutex);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    pthread_mutex_lock(mutex);
+  }
+  #endif
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_unlockMutex(
+  _Inout_ os_specific_mutex_t *mutex)
+{
+  #if defined(_WIN32)
+  {
+    LeaveCriticalSection(mutex);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    pthread_mutex_unlock(mutex);
+  }
+  #endif
+}
+
+/**************************************************************/
+
+BOOL
+OSSpecific_initCondition(
+  _Out_ os_specific_condition_t *condition)
+{
+  #if defined(_WIN32)
+  {
+    InitializeConditionVariable(condition);
+    return TRUE;
+  }
+  #elif defined(__linux__)
+  {
+    /* Timed waits are measured with the same clock */
+    /* as `OSSpecific_getMonotonicTime` */
+
+    pthread_condattr_t attributes;
+    BOOL test_bool;
+
+    if (0 != pthread_condattr_init(&(attributes))) { return FALSE; }
+
+    test_bool =
+      (0 == pthread_condattr_setclock(&(attributes), CLOCK_MONOTONIC)) &&
+      (0 == pthread_cond_init(condition, &(attributes)));
+
+    pthread_condattr_destroy(&(attributes));
+
+    return test_bool;
+  }
+  #elif defined(__APPLE__)
+  {
+    /* Timed waits use the relative variant (see below) */
+
+    return (0 == pthread_cond_init(condition, NULL));
+  }
+  #else
+  {
+    return FALSE;
+  }
+  #endif
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_destroyCondition(
+  _Inout_ os_specific_condition_t *condition)
+{
+  #if defined(_WIN32)
+  {
+    /* Windows condition variables need no cleanup */
+    (void) condition;
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    pthread_cond_destroy(condition);
+  }
+  #endif
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_wakeCondition(
+  _Inout_ os_specific_condition_t *condition)
+{
+  #if defined(_WIN32)
+  {
+    WakeAllConditionVariable(condition);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    pthread_cond_broadcast(condition);
+  }
+  #endif
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_waitForCondition(
+  _Inout_ os_specific_condition_t *condition,
+  _Inout_ os_specific_mutex_t *mutex,
+  _In_ const uint32_t timeout)
+{
+  #if defined(_WIN32)
+  {
+    SleepConditionVariableCS(
+      condition,
+      mutex,
+      (OS_SPECIFIC_INFINITE == timeout) ? INFINITE : (DWORD) timeout);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    struct timespec deadline;
+
+    if (OS_SPECIFIC_INFINITE == timeout)
+    {
+      pthread_cond_wait(condition, mutex);
+      return;
+    }
+
+    #if defined(__linux__)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &(deadline));
+
+      deadline.tv_sec += (timeout / 1000);
+      deadline.tv_nsec += (long) (timeout % 1000) * 1000000;
+
+      if (deadline.tv_nsec >= 1000000000)
+      {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+      }
+
+      pthread_cond_timedwait(condition, mutex, &(deadline));
+    }
+    #else
+    {
+      deadline.tv_sec = (timeout / 1000);
+      deadline.tv_nsec = (long) (timeout % 1000) * 1000000;
+
+      pthread_cond_timedwait_relative_np(condition, mutex, &(deadline));
+    }
+    #endif
+  }
+  #endif
+}
+
+/**************************************************************/
+
+BOOL
+OSSpecific_initEvent(
+  _Out_ os_specific_event_t *event)
+{
+  #if defined(_WIN32)
+  {
+    event[0] = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+    return (NULL != event[0]);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    int fds[2];
+
+    if (0 != pipe(fds))
+    {
+      #if defined(_DEBUG)
+      OSSpecific_writeDebugMessage(
+        "{pipe} failed: errno=0x%08X",
+        errno);
+      #endif
+
+      return FALSE;
+    }
+
+    /* Neither end may ever block: a full pipe is still "signaled" */
+
+    fcntl(fds[0], F_SETFL, O_NONBLOCK | fcntl(fds[0], F_GETFL));
+    fcntl(fds[1], F_SETFL, O_NONBLOCK | fcntl(fds[1], F_GETFL));
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+    event->readEnd = fds[0];
+    event->writeEnd = fds[1];
+
+    return TRUE;
+  }
+  #else
+  {
+    return FALSE;
+  }
+  #endif
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_destroyEvent(
+  _Inout_ os_specific_event_t *event)
+{
+  #if defined(_WIN32)
+  {
+    CloseHandle(event[0]);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    close(event->readEnd);
+    close(event->writeEnd);
+  }
+  #endif
+}
+
+/**************************************************************/
+
+VOID
+OSSpecific_signalEvent(
+  _Inout_ os_specific_event_t *event)
+{
+  #if defined(_WIN32)
+  {
+    SetEvent(event[0]);
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    const BYTE signal = 1;
+
+    if (write(event->writeEnd, &(signal), 1) < 0)
+    {
+      /* `EAGAIN`: the pipe is full, so the event is already signaled */
+    }
+  }
+  #endif
+}
+
+/**************************************************************/
+
+uint64_t
+OSSpecific_getMonotonicTime(void)
+{
+  #if defined(_WIN32)
+  {
+    return (uint64_t) GetTickCount64();
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &(now));
+
+    return ((uint64_t) now.tv_sec * 1000) +
+      ((uint64_t) now.tv_nsec / 1000000);
+  }
+  #else
+  {
+    return 0;
+  }
+  #endif
+}
+
+/**************************************************************/
+
 #if defined(_DEBUG)
 
   VOID
@@ -41,6 +41,9 @@
   #include <poll.h>
   #include <unistd.h>
 
+  /** POSIX Threads */
+  #include <pthread.h>
+
   /**
    * C library for strings, includes:
    *  `strlen()`, `memcpy()`.
@@ -60,12 +63,6 @@
 /** Timing */
 #include <time.h>
 
-#if defined(__APPLE__)
-  #define FIXED_CLOCKS_PER_SEC  (CLOCKS_PER_SEC / 100)
-#else
-  #define FIXED_CLOCKS_PER_SEC  CLOCKS_PER_SEC
-#endif
-
 /** Fixed-width integer type definitions */
 #include <stdint.h>
 
@@ -91,11 +88,40 @@
 #if defined(_WIN32)
   typedef HANDLE os_specific_stream_t;
 
+  typedef HANDLE os_specific_thread_t;
+  typedef CRITICAL_SECTION os_specific_mutex_t;
+  typedef CONDITION_VARIABLE os_specific_condition_t;
+
+  /** Auto-reset event object. */
+  typedef HANDLE os_specific_event_t;
+
 #elif defined(__linux__) || defined(__APPLE__)
   typedef int os_specific_stream_t;
 
+  typedef pthread_t os_specific_thread_t;
+  typedef pthread_mutex_t os_specific_mutex_t;
+  typedef pthread_cond_t os_specific_condition_t;
+
+  /** Non-blocking "self-pipe", which can be polled together with streams. */
+  typedef struct
+  {
+    int readEnd;
+    int writeEnd;
+  }
+  os_specific_event_t;
+
 #endif
 
+/**
+ * Thread entry point: receives the `param` passed to `OSSpecific_createThread`.
+ */
+typedef VOID (*os_specific_thread_routine_t)(_In_opt_ LPVOID param);
+
+/**
+ * Timeout value that means "wait without a time limit".
+ */
+#define OS_SPECIFIC_INFINITE  UINT32_MAX
+
 
 /**************************************************************/
 /* CUSTOM WIDE CHARS (exactly 16-bit wide)                    */
@@ -143,6 +169,43 @@ OSSpecific_peekStream(
   _In_ const os_specific_stream_t stream,
   _Out_ uint32_t *streamSizeRef);
 
+/**
+ * Possible return values for `OSSpecific_waitForStream` function.
+ */
+
+  /** Nothing happened before the timeout has elapsed. */
+  #define OS_SPECIFIC_WAIT__TIMEOUT  0
+
+  /** Some bytes are available for reading. */
+  #define OS_SPECIFIC_WAIT__STREAM   1
+
+  /** Pipe-access error, or the writing end of the pipe was closed. */
+  #define OS_SPECIFIC_WAIT__FAILED   2
+
+  /** The event was signaled (and the stream has nothing to read). */
+  #define OS_SPECIFIC_WAIT__EVENT    3
+
+/**
+ * @brief Suspends the calling thread until some bytes are available
+ * in a given stream, until the event is signaled, or until the timeout
+ * elapses.
+ *
+ * @param[in] stream OS-specific stream descriptor, open for reading.
+ * @param[in] event Optional reference to a VALID event object,
+ * which gets reset (consumed) when it wakes up the caller.
+ * This parameter can be `NULL`.
+ * @param[in] timeout Maximum waiting time, in milliseconds.
+ * @return `OS_SPECIFIC_WAIT__STREAM` when the stream can be read
+ * without blocking, `OS_SPECIFIC_WAIT__EVENT` when only the event
+ * was signaled, `OS_SPECIFIC_WAIT__TIMEOUT` when nothing arrived
+ * in time, `OS_SPECIFIC_WAIT__FAILED` on pipe-access errors.
+ */
+extern int
+OSSpecific_waitForStream(
+  _In_ const os_specific_stream_t stream,
+  _In_opt_ os_specific_event_t *event,
+  _In_ const uint32_t timeout);
+
 /**
  * @brief Reads bytes from a stream.
  *
@@ -157,6 +220,27 @@ OSSpecific_readBytesFromStream(
   _Out_ void *output,
   _In_ const size_t size);
 
+/**
+ * @brief Reads as many bytes as are currently available in a stream
+ * (but no more than `size`), without waiting for the rest.
+ *
+ * @param[in] stream OS-specific stream descriptor, open for reading.
+ * @param[out] output Memory location for at most `size` bytes.
+ * @param[in] size Capacity of the `output` buffer.
+ * @param[out] bytesRead Number of bytes actually stored in `output`
+ * (can be zero when nothing is pending).
+ * @return `TRUE` on success, `FALSE` on any stream error,
+ * or when the writing end of the stream was closed.
+ * @note On Unix systems this call blocks if the stream is empty, so it
+ * should follow `OSSpecific_waitForStream` reporting the stream as ready.
+ */
+extern BOOL
+OSSpecific_readAvailableBytesFromStream(
+  _In_ const os_specific_stream_t stream,
+  _Out_ void *output,
+  _In_ const size_t size,
+  _Out_ size_t *bytesRead);
+
 /**
  * @brief Writes bytes to a stream.
  *
@@ -172,6 +256,165 @@ OSSpecific_writeBytesToStream(
   _In_ const size_t size);
 
 
+/**************************************************************/
+/* THREADS AND SYNCHRONIZATION                                */
+/**************************************************************/
+
+/**
+ * @brief Starts a new thread.
+ *
+ * @param[out] threadRef Pointer to a location that receives
+ * the thread handle (which must be passed to `OSSpecific_joinThread`).
+ * @param[in] routine Function to be executed by the new thread.
+ * @param[in] param Custom parameter passed to the `routine`.
+ * @return `TRUE` on success, `FALSE` if the thread could not be created.
+ */
+extern BOOL
+OSSpecific_createThread(
+  _Out_ os_specific_thread_t *threadRef,
+  _In_ os_specific_thread_routine_t routine,
+  _In_opt_ LPVOID param);
+
+/**
+ * @brief Waits until the given thread returns, then releases its handle.
+ *
+ * @param[in] thread Thread handle received from `OSSpecific_createThread`.
+ */
+extern VOID
+OSSpecific_joinThread(
+  _In_ os_specific_thread_t thread);
+
+/**
+ * @brief Mutex constructor.
+ *
+ * @param[out] mutex Reference to an UNINITIALIZED mutex object.
+ * @return `TRUE` on success, `FALSE` on system errors.
+ */
+extern BOOL
+OSSpecific_initMutex(
+  _Out_ os_specific_mutex_t *mutex);
+
+/**
+ * @brief Mutex destructor.
+ *
+ * @param[in,out] mutex Reference to a VALID (and unlocked) mutex object.
+ */
+extern VOID
+OSSpecific_destroyMutex(
+  _Inout_ os_specific_mutex_t *mutex);
+
+/**
+ * @brief Acquires the mutex (waits until it becomes available).
+ *
+ * @param[in,out] mutex Reference to a VALID mutex object.
+ */
+extern VOID
+OSSpecific_lockMutex(
+  _Inout_ os_specific_mutex_t *mutex);
+
+/**
+ * @brief Releases the mutex acquired by the calling thread.
+ *
+ * @param[in,out] mutex Reference to a VALID mutex object.
+ */
+extern VOID
+OSSpecific_unlockMutex(
+  _Inout_ os_specific_mutex_t *mutex);
+
+/**
+ * @brief Condition variable constructor.
+ *
+ * @param[out] condition Reference to an UNINITIALIZED condition object.
+ * @return `TRUE` on success, `FALSE` on system errors.
+ */
+extern BOOL
+OSSpecific_initCondition(
+  _Out_ os_specific_condition_t *condition);
+
+/**
+ * @brief Condition variable destructor.
+ *
+ * @param[in,out] condition Reference to a VALID condition object,
+ * that no thread is waiting on.
+ */
+extern VOID
+OSSpecific_destroyCondition(
+  _Inout_ os_specific_condition_t *condition);
+
+/**
+ * @brief Wakes up all the threads waiting on a condition variable.
+ *
+ * @param[in,out] condition Reference to a VALID condition object.
+ */
+extern VOID
+OSSpecific_wakeCondition(
+  _Inout_ os_specific_condition_t *condition);
+
+/**
+ * @brief Atomically releases the mutex and waits on a condition variable,
+ * then re-acquires the mutex before returning.
+ *
+ * @param[in,out] condition Reference to a VALID condition object.
+ * @param[in,out] mutex Reference to a VALID mutex object,
+ * locked by the calling thread.
+ * @param[in] timeout Maximum waiting time, in milliseconds
+ * (or `OS_SPECIFIC_INFINITE`).
+ *
+ * @note Spurious wake-ups are possible, so the caller should always
+ * re-check the guarded state.
+ */
+extern VOID
+OSSpecific_waitForCondition(
+  _Inout_ os_specific_condition_t *condition,
+  _Inout_ os_specific_mutex_t *mutex,
+  _In_ const uint32_t timeout);
+
+/**
+ * @brief Event constructor. The event starts in non-signaled state.
+ *
+ * An event wakes up `OSSpecific_waitForStream` from other threads.
+ * @param[out] event Reference to an UNINITIALIZED event object.
+ * @return `TRUE` on success, `FALSE` on system errors.
+ */
+extern BOOL
+OSSpecific_initEvent(
+  _Out_ os_specific_event_t *event);
+
+/**
+ * @brief Event destructor.
+ *
+ * @param[in,out] event Reference to a VALID event object.
+ */
+extern VOID
+OSSpecific_destroyEvent(
+  _Inout_ os_specific_event_t *event);
+
+/**
+ * @brief Sets the event to signaled state (can be called from any thread).
+ *
+ * @param[in,out] event Reference to a VALID event object.
+ */
+extern VOID
+OSSpecific_signalEvent(
+  _Inout_ os_specific_event_t *event);
+
+
+/**************************************************************/
+/* TIMING                                                     */
+/**************************************************************/
+
+/**
+ * @brief Reads a monotonic clock.
+ *
+ * Unlike `clock()`, which measures the CPU time used by the process,
+ * this is the real (wall) time, that never jumps backwards.
+ * @return Number of milliseconds elapsed since some unspecified
+ * starting point.
+ */
+extern uint64_t
+OSSpecific_getMonotonicTime(void);
+
+
 /**************************************************************/
 /* DEBUG DEFINITIONS AND DECLARATIONS                         */
 /**************************************************************/
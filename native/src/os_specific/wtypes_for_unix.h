@@ -61,6 +61,7 @@ typedef DWORD PCSC_DWORD;
   typedef void     VOID;
   typedef uint8_t  BYTE;
   typedef float    FLOAT;
+  typedef double   DOUBLE;
 
   /** Pointer-types required by the WinSCard */
   typedef       VOID  *LPVOID;
@@ -102,6 +103,7 @@ typedef DWORD PCSC_DWORD;
   typedef LPCSTR LPCTSTR;
   #define _tcscmp  strcmp
   #define _tcslen  strlen
+  #define _T(x)    x
 
   /** Ignore "SAL" (Microsoft "Source Code Annotation") */
   #define _In_
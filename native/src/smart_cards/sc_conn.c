@@ -14,6 +14,178 @@ SCardConnection_init(
   connection->handle         = 0;
   connection->activeProtocol = 0;
   connection->ignoreCounter  = 0;
+  connection->input          = NULL;
+  connection->inputCapacity  = 0;
+  connection->output         = NULL;
+
+  UTF8String_init(&(connection->hex));
+}
+
+/**************************************************************/
+
+VOID
+SCardConnection_destroy(
+  _Inout_ SCardConnection *connection)
+{
+  if (NULL != connection->input)
+  {
+    free(connection->input);
+  }
+
+  if (NULL != connection->output)
+  {
+    free(connection->output);
+  }
+
+  UTF8String_destroy(&(connection->hex));
+
+  connection->input = NULL;
+  connection->inputCapacity = 0;
+  connection->output = NULL;
+
+  UTF8String_init(&(connection->hex));
+}
+
+/**************************************************************/
+
+BOOL
+SCardConnection_assertOutput(
+  _Inout_ SCardConnection *connection)
+{
+  if (NULL == connection->output)
+  {
+    connection->output = malloc(sizeof(BYTE) * MAX_APDU_SIZE);
+  }
+
+  return (NULL != connection->output);
+}
+
+/**************************************************************/
+
+VOID
+SCardConnection_trimBuffers(
+  _Inout_ SCardConnection *connection)
+{
+  /* The `output` buffer has a fixed size (`MAX_APDU_SIZE`) */
+
+  if (connection->inputCapacity > WEBCARD_BUFFER__MAX_RETAINED_SIZE)
+  {
+    free(connection->input);
+
+    connection->input = NULL;
+    connection->inputCapacity = 0;
+  }
+
+  if (connection->hex.capacity > WEBCARD_BUFFER__MAX_RETAINED_SIZE)
+  {
+    UTF8String_destroy(&(connection->hex));
+    UTF8String_init(&(connection->hex));
+  }
+}
+
+/**************************************************************/
+
+BOOL
+SCardConnection_decodeApdu(
+  _Inout_ SCardConnection *connection,
+  _In_ const UTF8String *apdu,
+  _In_ const uint32_t encoding,
+  _Out_ size_t *inputLengthRef)
+{
+  size_t length;
+  size_t buffer_size;
+  size_t new_capacity;
+  size_t error_offset;
+  size_t i;
+  BOOL test_bool;
+  LPBYTE new_input;
+
+  inputLengthRef[0] = 0;
+
+  /* Length of the decoded APDU (padding characters of Base64 */
+  /* are not counted, so that the limit is exact) */
+
+  if (SCARD_APDU_ENCODING__BASE64 == encoding)
+  {
+    buffer_size = 3 * (apdu->length / 4);
+    length = buffer_size;
+
+    for (i = 0; (i < 2) && (i < apdu->length) &&
+      ('=' == apdu->text[apdu->length - 1 - i]); i++)
+    {
+      length -= 1;
+    }
+  }
+  else
+  {
+    buffer_size = apdu->length / 2;
+    length = buffer_size;
+  }
+
+  /* Page-provided strings can be as long as a whole message, */
+  /* so oversized APDUs are rejected before the buffer is enlarged */
+
+  if (length > MAX_APDU_SIZE)
+  {
+    #if defined(_DEBUG)
+    {
+      OSSpecific_writeDebugMessage(
+        "{SCardConnection::decodeApdu} failed: " \
+        "APDU longer than %u bytes!",
+        (uint32_t) MAX_APDU_SIZE);
+    }
+    #endif
+
+    return FALSE;
+  }
+
+  /* The buffer only grows, so that the following APDUs */
+  /* can be decoded without any allocation */
+  /* (the Base64 decoder may use the space of the padding) */
+
+  if (buffer_size > connection->inputCapacity)
+  {
+    new_capacity = Misc_nextPowerOfTwo(buffer_size);
+
+    new_input = realloc(connection->input, sizeof(BYTE) * new_capacity);
+    if (NULL == new_input) { return FALSE; }
+
+    connection->input = new_input;
+    connection->inputCapacity = new_capacity;
+  }
+
+  if (SCARD_APDU_ENCODING__BASE64 == encoding)
+  {
+    test_bool = UTF8String_decodeBase64(
+      apdu,
+      connection->input,
+      &(length),
+      &(error_offset));
+  }
+  else
+  {
+    test_bool = UTF8String_decodeHex(
+      apdu,
+      connection->input,
+      &(error_offset));
+  }
+
+  if (!test_bool)
+  {
+    #if defined(_DEBUG)
+    {
+      OSSpecific_writeDebugMessage(
+        "{SCardConnection::decodeApdu} failed: " \
+        "invalid APDU character at offset %u!",
+        (uint32_t) error_offset);
+    }
+    #endif
+
+    return FALSE;
+  }
+
+  inputLengthRef[0] = length;
+  return TRUE;
 }
 
 /**************************************************************/
@@ -117,17 +289,261 @@ SCardConnection_transceiveSingle(
 
 /**************************************************************/
 
+/**
+ * @brief A private method for `SCardConnection` object.
+ * Sends an extended APDU (`CLA INS P1 P2 00 Lc1 Lc2 data [Le1 Le2]`)
+ * with more than 255 bytes of data as a chain of short APDUs
+ * (ISO/IEC 7816-4 command chaining: every block but the last one
+ * has bit 5 of CLA set). Other APDUs are sent unchanged.
+ *
+ * @param[in] connection Reference to a VALID and CONSTANT
+ * `SCardConnection` object.
+ * @param[in] input Data to be written to the card.
+ * @param[in] inputLength The length of `input` buffer, in bytes.
+ * @param[out] output Data returned from the card (the response
+ * to the last block, or to the first block that was not accepted
+ * with `9000`).
+ * @param[in,out] outputLengthRef Supplies the length, in bytes,
+ * of the `output` buffer, and receives the actual number of bytes
+ * received from the smart card.
+ * @return `TRUE` on success, `FALSE` if any Smart Card error has occurred.
+ */
+static BOOL
+SCardConnection_transceiveChained(
+  _In_ const SCardConnection *connection,
+  _In_ const BYTE *input,
+  _In_ const PCSC_DWORD inputLength,
+  _Out_ LPBYTE output,
+  _Inout_ PCSC_DWORD *outputLengthRef)
+{
+  const PCSC_DWORD output_length = outputLengthRef[0];
+  BYTE block[MAX_SHORT_APDU_SIZE];
+  size_t data_length = 0;
+  size_t le_length = 0;
+  size_t expected_length;
+  size_t block_length;
+  size_t offset;
+  size_t length;
+  BOOL last;
+
+  if ((inputLength > 7) && (0x00 == input[4]))
+  {
+    data_length = ((size_t) input[5] << 8) | input[6];
+    le_length = inputLength - 7 - data_length;
+  }
+
+  /* Only the extended APDUs that do not fit a short APDU are split */
+
+  if ((data_length <= 255) ||
+    ((7 + data_length) > inputLength) ||
+    ((0 != le_length) && (2 != le_length)))
+  {
+    return SCardConnection_transceiveSingle(
+      connection,
+      input,
+      inputLength,
+      output,
+      outputLengthRef);
+  }
+
+  for (offset = 0; offset < data_length; offset += block_length)
+  {
+    block_length = data_length - offset;
+
+    if (block_length > 255)
+    {
+      block_length = 255;
+    }
+
+    last = ((offset + block_length) == data_length);
+
+    block[0] = last ? input[0] : (input[0] | 0x10);
+    block[1] = input[1];
+    block[2] = input[2];
+    block[3] = input[3];
+    block[4] = (BYTE) block_length;
+
+    memcpy(&(block[5]), &(input[7 + offset]), block_length);
+
+    length = 5 + block_length;
+
+    /* The last block takes the expected length (short Le, where */
+    /* `00` means 256 bytes, and longer responses follow with "61xx") */
+
+    if (last && (0 != le_length))
+    {
+      expected_length = ((size_t) input[inputLength - 2] << 8) |
+        input[inputLength - 1];
+
+      block[length] = (expected_length < 256) ?
+        (BYTE) expected_length :
+        0x00;
+
+      length += 1;
+    }
+
+    outputLengthRef[0] = output_length;
+
+    if (!SCardConnection_transceiveSingle(
+      connection,
+      block,
+      (PCSC_DWORD) length,
+      output,
+      outputLengthRef))
+    {
+      return FALSE;
+    }
+
+    /* Every block but the last one should be accepted with "9000" */
+
+    if ((!last) &&
+      ((outputLengthRef[0] < 2) ||
+      (0x90 != output[outputLengthRef[0] - 2]) ||
+      (0x00 != output[outputLengthRef[0] - 1])))
+    {
+      break;
+    }
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `SCardConnection` object.
+ * Sends a short APDU again, with the expected length (Le) given
+ * by the "6Cxx" Status Word. Extended APDUs are not sent again.
+ *
+ * @param[in] connection Reference to a VALID and CONSTANT
+ * `SCardConnection` object.
+ * @param[in] input The APDU that was answered with "6Cxx".
+ * @param[in] inputLength The length of `input` buffer, in bytes.
+ * @param[in,out] output On input: the "6Cxx" response. On output:
+ * data returned from the card (unchanged for an extended APDU).
+ * @param[in] outputLength The length of `output` buffer, in bytes.
+ * @param[in,out] outputLengthRef Receives the actual number of bytes
+ * received from the smart card.
+ * @return `TRUE` on success, `FALSE` if any Smart Card error has occurred.
+ */
+static BOOL
+SCardConnection_reissueWithLe(
+  _In_ const SCardConnection *connection,
+  _In_ const BYTE *input,
+  _In_ const PCSC_DWORD inputLength,
+  _Inout_ LPBYTE output,
+  _In_ const PCSC_DWORD outputLength,
+  _Inout_ PCSC_DWORD *outputLengthRef)
+{
+  BYTE apdu[MAX_SHORT_APDU_SIZE];
+  size_t length;
+
+  /* Short APDU without Le: `CLA INS P1 P2 [Lc data]` */
+  /* (any existing Le is replaced) */
+
+  if ((4 == inputLength) || (5 == inputLength))
+  {
+    length = 4;
+  }
+  else if ((inputLength < 6) || (0x00 == input[4]))
+  {
+    return TRUE;
+  }
+  else if ((5 + input[4]) == inputLength)
+  {
+    length = inputLength;
+  }
+  else if ((6 + input[4]) == inputLength)
+  {
+    length = inputLength - 1;
+  }
+  else
+  {
+    return TRUE;
+  }
+
+  memcpy(apdu, input, length);
+
+  apdu[length] = output[1];
+
+  outputLengthRef[0] = outputLength;
+
+  return SCardConnection_transceiveSingle(
+    connection,
+    apdu,
+    (PCSC_DWORD) (length + 1),
+    output,
+    outputLengthRef);
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `SCardConnection` object.
+ * Appends a part of the response in the selected encoding. In Base64,
+ * only complete groups (3 bytes each) are encoded, unless this is
+ * the last part of the response.
+ *
+ * @param[in,out] stringResult Reference to a VALID `UTF8String` object.
+ * @param[in] encoding One of the `SCARD_APDU_ENCODING__*` values.
+ * @param[in] bytes Response bytes.
+ * @param[in] length The length of `bytes` buffer.
+ * @param[in] last `TRUE` for the last part of the response.
+ * @return The number of bytes that were NOT encoded yet (from the end
+ * of `bytes` buffer), or `(size_t) (-1)` on memory allocation failure.
+ */
+static size_t
+SCardConnection_pushResponse(
+  _Inout_ UTF8String *stringResult,
+  _In_ const uint32_t encoding,
+  _In_ const BYTE *bytes,
+  _In_ const size_t length,
+  _In_ const BOOL last)
+{
+  size_t remainder = 0;
+  BOOL test_bool;
+
+  if (SCARD_APDU_ENCODING__BASE64 == encoding)
+  {
+    if (!last)
+    {
+      remainder = length % 3;
+    }
+
+    test_bool = UTF8String_pushBytesAsBase64(
+      stringResult,
+      length - remainder,
+      bytes);
+  }
+  else
+  {
+    test_bool = UTF8String_pushBytesAsHex(
+      stringResult,
+      length,
+      bytes);
+  }
+
+  return test_bool ? remainder : ((size_t) (-1));
+}
+
+/**************************************************************/
+
 BOOL
 SCardConnection_transceiveMultiple(
   _In_ const SCardConnection *connection,
-  _Inout_ UTF8String *hexStringResult,
+  _Inout_ UTF8String *stringResult,
+  _In_ const uint32_t encoding,
+  _In_ const uint32_t handling,
   _In_ const BYTE *input,
   _In_ const PCSC_DWORD inputLength,
   _Out_ LPBYTE output,
-  _In_ const PCSC_DWORD outputLength)
+  _In_ const PCSC_DWORD outputLength,
+  _Out_opt_ uint16_t *statusWordRef)
 {
   BOOL test_bool;
   PCSC_DWORD bytesReceived;
+  size_t pending = 0;
+  size_t length;
 
   /*
    * [0] CLA: 0x00
@@ -139,54 +555,106 @@ SCardConnection_transceiveMultiple(
    */
   BYTE getResponseApdu[5] = {0x00, 0xC0, 0x00, 0x00};
 
+  if (NULL != statusWordRef)
+  {
+    statusWordRef[0] = 0;
+  }
+
   /* Begin transmission */
 
   bytesReceived = outputLength;
 
-  test_bool = SCardConnection_transceiveSingle(
-    connection,
-    input,
-    inputLength,
-    output,
-    &(bytesReceived));
+  if (SCARD_APDU_HANDLING__COMMAND_CHAINING & handling)
+  {
+    test_bool = SCardConnection_transceiveChained(
+      connection,
+      input,
+      inputLength,
+      output,
+      &(bytesReceived));
+  }
+  else
+  {
+    test_bool = SCardConnection_transceiveSingle(
+      connection,
+      input,
+      inputLength,
+      output,
+      &(bytesReceived));
+  }
 
   if (!test_bool) { return FALSE; }
 
-  /* Check if "Status Word 1" is "Response bytes still available" */
+  /* Check if the Status Word is "Wrong length" (only once) */
 
-  while ((bytesReceived >= 2) && (0x61 == output[bytesReceived - 2]))
+  if ((SCARD_APDU_HANDLING__REISSUE_WRONG_LE & handling) &&
+    (2 == bytesReceived) &&
+    (0x6C == output[0]))
   {
-    test_bool = UTF8String_pushBytesAsHex(
-      hexStringResult,
-      bytesReceived - 2,
-      output);
+    test_bool = SCardConnection_reissueWithLe(
+      connection,
+      input,
+      inputLength,
+      output,
+      outputLength,
+      &(bytesReceived));
 
     if (!test_bool) { return FALSE; }
+  }
 
+  /* Check if "Status Word 1" is "Response bytes still available" */
+
+  while ((bytesReceived >= 2) && (0x61 == output[pending + bytesReceived - 2]))
+  {
     /* Move "Status Word 2" into "GET RESPONSE" APDU */
 
-    getResponseApdu[4] = output[bytesReceived - 1];
+    getResponseApdu[4] = output[pending + bytesReceived - 1];
+
+    /* Bytes that do not fill a Base64 group are kept at the beginning */
+    /* of the buffer, and the next part of the response follows them */
+
+    length = pending + bytesReceived - 2;
+
+    pending = SCardConnection_pushResponse(
+      stringResult,
+      encoding,
+      output,
+      length,
+      FALSE);
+
+    if (((size_t) (-1)) == pending) { return FALSE; }
+
+    memmove(output, &(output[length - pending]), pending);
 
     /* Continue transmission */
 
-    bytesReceived = outputLength;
+    bytesReceived = outputLength - (PCSC_DWORD) pending;
 
     test_bool = SCardConnection_transceiveSingle(
       connection,
       getResponseApdu,
       5,
-      output,
+      &(output[pending]),
       &(bytesReceived));
 
     if (!test_bool) { return FALSE; }
   }
 
+  if ((NULL != statusWordRef) && (bytesReceived >= 2))
+  {
+    statusWordRef[0] = (uint16_t) (
+      (output[pending + bytesReceived - 2] << 8) |
+      output[pending + bytesReceived - 1]);
+  }
+
   /* The last or the only block */
 
-  return UTF8String_pushBytesAsHex(
-    hexStringResult,
-    bytesReceived,
-    output);
+  return ((size_t) (-1)) != SCardConnection_pushResponse(
+    stringResult,
+    encoding,
+    output,
+    pending + bytesReceived,
+    TRUE);
 }
 
 /**************************************************************/
@@ -13,7 +13,7 @@ SCardReaderDB_init(
 {
   database->count = 0;
   database->states = NULL;
-  database->connections = NULL;
+  database->workers = NULL;
 }
 
 /**************************************************************/
@@ -37,88 +37,105 @@ SCardReaderDB_destroy(
     free(database->states);
   }
 
-  if (NULL != database->connections)
+  if (NULL != database->workers)
   {
     for (i = 0; i < database->count; i++)
     {
-      SCardConnection_close(&(database->connections[i]));
+      if (NULL != database->workers[i])
+      {
+        SCardWorker_destroy(database->workers[i]);
+        free(database->workers[i]);
+      }
     }
 
-    free(database->connections);
+    free(database->workers);
   }
 }
 
 /**************************************************************/
 
 BOOL
-SCardReaderDB_load(
-  _Out_ SCardReaderDB *database,
-  _In_ LPCTSTR readerNames)
+SCardReaderDB_appendReader(
+  _Inout_ SCardReaderDB *database,
+  _In_ LPCTSTR readerName)
 {
   size_t byteSize;
   size_t nameLength;
 
-  LPCTSTR nextReader;
   SCARD_READERSTATE *readerStateRef;
-  SCardConnection *testConnection;
+  SCardWorker **testWorkers;
 
-  /* Initialize outgoing `SCardReaderDB` structure */
+  /* Expand the "Smart Card Reader State" list */
 
-  SCardReaderDB_init(database);
+  byteSize = sizeof(SCARD_READERSTATE) * (1 + database->count);
+  readerStateRef = realloc(database->states, byteSize);
+  if (NULL == readerStateRef) { return FALSE; }
 
-  /* Iterate through every Smart Card Reader */
+  database->states = readerStateRef;
+  readerStateRef = &(database->states[database->count]);
 
-  nextReader = readerNames;
+  /* Initialize "Smart Card Reader State" structure for current reader */
 
-  while (nextReader[0])
-  {
-    /* Expand the "Smart Card Reader State" list */
+  readerStateRef->szReader = NULL;
+  readerStateRef->dwCurrentState = SCARD_STATE_UNAWARE;
+  readerStateRef->cbAtr = 0;
+
+  /* Expand the "Smart Card Reader Worker" list */
 
-    byteSize = sizeof(SCARD_READERSTATE) * (1 + database->count);
-    readerStateRef = realloc(database->states, byteSize);
-    if (NULL == readerStateRef) { return FALSE; }
+  byteSize = sizeof(SCardWorker *) * (1 + database->count);
+  testWorkers = realloc(database->workers, byteSize);
+  if (NULL == testWorkers) { return FALSE; }
 
-    database->states = readerStateRef;
-    readerStateRef = &(database->states[database->count]);
+  database->workers = testWorkers;
 
-    /* Initialize "Smart Card Reader State" structure for current reader */
+  /* Reader Worker is started on the first request */
 
-    readerStateRef->szReader = NULL;
-    readerStateRef->dwCurrentState = SCARD_STATE_UNAWARE;
-    readerStateRef->cbAtr = 0;
+  database->workers[database->count] = NULL;
 
-    /* Expand the "Smart Card Connection" list */
+  /* Both lists have "+1" valid (initialized) structure */
 
-    byteSize = sizeof(SCardConnection) * (1 + database->count);
-    testConnection = realloc(database->connections, byteSize);
-    if (NULL == testConnection) { return FALSE; }
+  database->count += 1;
 
-    database->connections = testConnection;
-    testConnection = &(database->connections[database->count]);
+  /* Clone Smart Card Reader name */
 
-    /* Initialize "Smart Card Connection" structure for current reader */
+  nameLength = _tcslen(readerName);
 
-    SCardConnection_init(testConnection);
+  byteSize = sizeof(TCHAR) * (1 + nameLength);
+  readerStateRef->szReader = malloc(byteSize);
+  if (NULL == readerStateRef->szReader) { return FALSE; }
 
-    /* Both lists have "+1" valid (initialized) structure */
+  memcpy((void *) readerStateRef->szReader, readerName, byteSize);
 
-    database->count += 1;
+  return TRUE;
+}
 
-    /* Get Smart Card Reader name's length */
+/**************************************************************/
 
-    nameLength = _tcslen(nextReader);
+BOOL
+SCardReaderDB_load(
+  _Out_ SCardReaderDB *database,
+  _In_ LPCTSTR readerNames)
+{
+  LPCTSTR nextReader;
 
-    /* Clone Smart Card Reader name */
+  /* Initialize outgoing `SCardReaderDB` structure */
 
-    byteSize = sizeof(TCHAR) * (1 + nameLength);
-    readerStateRef->szReader = malloc(byteSize);
-    if (NULL == readerStateRef->szReader) { return FALSE; }
+  SCardReaderDB_init(database);
 
-    memcpy((void *) readerStateRef->szReader, nextReader, byteSize);
+  /* Iterate through every Smart Card Reader */
+
+  nextReader = readerNames;
+
+  while (nextReader[0])
+  {
+    if (!SCardReaderDB_appendReader(database, nextReader))
+    {
+      return FALSE;
+    }
 
     /* Move to the next entry in a multi-string list */
 
-    nextReader = &(nextReader[1 + nameLength]);
+    nextReader = &(nextReader[1 + _tcslen(nextReader)]);
   }
 
   return TRUE;
@@ -126,6 +143,57 @@ SCardReaderDB_load(
 
 /**************************************************************/
 
+BOOL
+SCardReaderDB_copyReaders(
+  _Out_ SCardReaderDB *database,
+  _In_ const SCardReaderDB *source)
+{
+  int i;
+
+  SCardReaderDB_init(database);
+
+  for (i = 0; i < source->count; i++)
+  {
+    if (!SCardReaderDB_appendReader(database, source->states[i].szReader))
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+SCardWorker *
+SCardReaderDB_getWorker(
+  _Inout_ SCardReaderDB *database,
+  _In_ const size_t readerIndex,
+  _In_ SCardWorkerResults *results)
+{
+  SCardWorker *worker = database->workers[readerIndex];
+
+  if (NULL != worker)
+  {
+    return worker;
+  }
+
+  worker = malloc(sizeof(SCardWorker));
+  if (NULL == worker) { return NULL; }
+
+  if (!SCardWorker_init(worker, database->states[readerIndex].szReader, results))
+  {
+    free(worker);
+    return NULL;
+  }
+
+  database->workers[readerIndex] = worker;
+
+  return worker;
+}
+
+/**************************************************************/
+
 BOOL
 SCardReaderDB_hasReaderNamed(
   _In_ const SCardReaderDB *database,
@@ -146,10 +214,59 @@ SCardReaderDB_hasReaderNamed(
 
 /**************************************************************/
 
+/**
+ * @brief Moves the Reader Workers of the readers that are still present
+ * to the new Database. Workers of removed readers are retired
+ * (they finish in the background, without stalling the main loop).
+ *
+ * @param[in,out] database Reference to a VALID `SCardReaderDB` object,
+ * which is left without any Reader Workers.
+ * @param[in,out] successor Reference to a VALID `SCardReaderDB` object
+ * that replaces `database`, or `NULL` if no readers are left.
+ */
+static VOID
+SCardReaderDB_handOverWorkers(
+  _Inout_ SCardReaderDB *database,
+  _In_opt_ SCardReaderDB *successor)
+{
+  int i;
+  int j;
+  SCardWorker *worker;
+
+  if (NULL == database->workers) { return; }
+
+  for (i = 0; i < database->count; i++)
+  {
+    worker = database->workers[i];
+    if (NULL == worker) { continue; }
+
+    database->workers[i] = NULL;
+
+    for (j = 0; (NULL != successor) && (j < successor->count); j++)
+    {
+      if ((NULL == successor->workers[j]) &&
+        (0 == _tcscmp(successor->states[j].szReader, worker->readerName)))
+      {
+        successor->workers[j] = worker;
+        worker = NULL;
+        break;
+      }
+    }
+
+    if (NULL != worker)
+    {
+      SCardWorker_retire(worker);
+    }
+  }
+}
+
+/**************************************************************/
+
 int
 SCardReaderDB_fetch(
   _Inout_ SCardReaderDB *database,
-  _Out_ JsonArray *jsonReaderNames,
+  _Out_opt_ JsonArray *jsonAddedNames,
+  _Out_opt_ JsonArray *jsonRemovedNames,
   _In_ const SCARDCONTEXT context,
   _In_ const BOOL firstFetch)
 {
@@ -161,11 +278,17 @@ SCardReaderDB_fetch(
 
   int i;
   LPTSTR readerNames;
+  LPCTSTR nextReader;
   SCardReaderDB testDatabase;
 
-  if (NULL != jsonReaderNames)
+  if (NULL != jsonAddedNames)
+  {
+    JsonArray_init(jsonAddedNames);
+  }
+
+  if (NULL != jsonRemovedNames)
   {
-    JsonArray_init(jsonReaderNames);
+    JsonArray_init(jsonRemovedNames);
   }
 
   /* Get total length of the multi-string list */
@@ -219,15 +342,16 @@ SCardReaderDB_fetch(
     if (0 != database->count)
     {
       /* Some readers were connected before */
-      if (NULL != jsonReaderNames)
+      if (NULL != jsonRemovedNames)
       {
         for (i = 0; i < database->count; i++)
         {
           WebCard_pushReaderNameToJsonArray(
             &(database->states[i]),
-            jsonReaderNames);
+            jsonRemovedNames);
         }
       }
+      SCardReaderDB_handOverWorkers(database, NULL);
       SCardReaderDB_destroy(database);
       SCardReaderDB_init(database);
 
@@ -278,7 +402,20 @@ SCardReaderDB_fetch(
     }
     else
     {
+      /* Same number of readers: was any reader replaced by another */
+      /* (unplugged and plugged in within one PnP Notification)? */
+
       testBool = FALSE;
+      fetchResult = WEBCARD_FETCH_READERS__OTHER_READERS;
+
+      nextReader = readerNames;
+
+      while ((!testBool) && nextReader[0])
+      {
+        testBool = !SCardReaderDB_hasReaderNamed(database, nextReader);
+
+        nextReader = &(nextReader[1 + _tcslen(nextReader)]);
+      }
     }
   }
 
@@ -303,50 +440,51 @@ SCardReaderDB_fetch(
     return WEBCARD_FETCH_READERS__FAIL;
   }
 
-  if (NULL != jsonReaderNames)
-  {
-    /* Find differences in two databases */
+  /* Find differences in two databases */
+  /* (readers can be plugged in and out at the same time) */
 
-    if (WEBCARD_FETCH_READERS__MORE_READERS == fetchResult)
+  if (NULL != jsonAddedNames)
+  {
+    /* Look for the names in NEW database */
+    /* that are not found in the OLD database */
+    for (i = 0; i < testDatabase.count; i++)
     {
-      /* Look for the names in OLD (SMALLER) database */
-      /* that are not found in the NEW (LARGER) database */
-      for (i = 0; i < testDatabase.count; i++)
-      {
-        testBool = SCardReaderDB_hasReaderNamed(
-          database,
-          testDatabase.states[i].szReader);
+      testBool = SCardReaderDB_hasReaderNamed(
+        database,
+        testDatabase.states[i].szReader);
 
-        if (!testBool)
-        {
-          WebCard_pushReaderNameToJsonArray(
-            &(testDatabase.states[i]),
-            jsonReaderNames);
-        }
+      if (!testBool)
+      {
+        WebCard_pushReaderNameToJsonArray(
+          &(testDatabase.states[i]),
+          jsonAddedNames);
       }
     }
-    else
+  }
+
+  if (NULL != jsonRemovedNames)
+  {
+    /* Look for the names in OLD database */
+    /* that are not found in the NEW database */
+    for (i = 0; i < database->count; i++)
     {
-      /* Look for the names in NEW (SMALLER) database */
-      /* that are not found in the OLD (LARGER) database */
-      for (i = 0; i < database->count; i++)
-      {
-        testBool = SCardReaderDB_hasReaderNamed(
-          &(testDatabase),
-          database->states[i].szReader);
+      testBool = SCardReaderDB_hasReaderNamed(
+        &(testDatabase),
+        database->states[i].szReader);
 
-        if (!testBool)
-        {
-          WebCard_pushReaderNameToJsonArray(
-            &(database->states[i]),
-            jsonReaderNames);
-        }
+      if (!testBool)
+      {
+        WebCard_pushReaderNameToJsonArray(
+          &(database->states[i]),
+          jsonRemovedNames);
       }
     }
   }
 
   /* Destroy previous Smart Card Readers array */
+  /* (keeping the Reader Workers of the remaining readers) */
 
+  SCardReaderDB_handOverWorkers(database, &(testDatabase));
   SCardReaderDB_destroy(database);
 
   /* Replace outgoing array with the local array */
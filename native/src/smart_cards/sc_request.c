@@ -0,0 +1,337 @@
+/**
+ * @file "native/src/smart_cards/sc_request.c"
+ * Decoding of the WebCard Requests (input commands).
+ */
+
+#include "smart_cards/smart_cards.h"
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `WebCardRequest` object.
+ * Maps a JSON key onto one of the `WEBCARD_REQUEST_KEY__*` flags.
+ *
+ * @param[in] key Reference to a VALID and CONSTANT `UTF8String` object.
+ * @return One of the `WEBCARD_REQUEST_KEY__*` flags,
+ * or zero for an unknown key.
+ */
+static uint32_t
+WebCardRequest_lookupKey(
+  _In_ const UTF8String *key)
+{
+  if (1 != key->length) { return 0; }
+
+  switch (key->text[0])
+  {
+    case 'i': return WEBCARD_REQUEST_KEY__ID;
+    case 'c': return WEBCARD_REQUEST_KEY__COMMAND;
+    case 'r': return WEBCARD_REQUEST_KEY__READER;
+    case 'p': return WEBCARD_REQUEST_KEY__SHARE_MODE;
+    case 'a': return WEBCARD_REQUEST_KEY__DATA;
+    case 'b': return WEBCARD_REQUEST_KEY__BASE64_DATA;
+    case 's': return WEBCARD_REQUEST_KEY__STOP_ON_ERROR;
+    case 't': return WEBCARD_REQUEST_KEY__TARGET;
+    case 'h': return WEBCARD_REQUEST_KEY__HANDLING;
+    default:  return 0;
+  }
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `WebCardRequest` object.
+ * Moves a parsed JSON value into the typed field selected by the key.
+ *
+ * @param[in,out] request Reference to a VALID `WebCardRequest` object.
+ * @param[in] key One of the `WEBCARD_REQUEST_KEY__*` flags.
+ * @param[in,out] value Reference to a VALID `JsonValue` object. If the value
+ * is taken over, `value` is left initialized (empty).
+ * @return `TRUE` if the value has the type expected for the key.
+ */
+static BOOL
+WebCardRequest_storeValue(
+  _Inout_ WebCardRequest *request,
+  _In_ const uint32_t key,
+  _Inout_ JsonValue *value)
+{
+  switch (key)
+  {
+    case WEBCARD_REQUEST_KEY__ID:
+    case WEBCARD_REQUEST_KEY__TARGET:
+    {
+      if (JSON_VALUE_TYPE__STRING != value->type) { return FALSE; }
+
+      if (WEBCARD_REQUEST_KEY__ID == key)
+      {
+        request->id = value->string;
+      }
+      else
+      {
+        request->target = value->string;
+      }
+
+      break;
+    }
+
+    case WEBCARD_REQUEST_KEY__COMMAND:
+    case WEBCARD_REQUEST_KEY__READER:
+    case WEBCARD_REQUEST_KEY__SHARE_MODE:
+    case WEBCARD_REQUEST_KEY__HANDLING:
+    {
+      if (JSON_VALUE_TYPE__NUMBER != value->type) { return FALSE; }
+
+      /* Only non-negative integers, without a fraction nor an exponent */
+      /* (no silent truncation, nor a wrap-around to unsigned types) */
+
+      if ((!value->number.isInteger) || (value->number.integer < 0) ||
+        ((uint64_t) value->number.integer > SIZE_MAX))
+      {
+        return FALSE;
+      }
+
+      if ((WEBCARD_REQUEST_KEY__SHARE_MODE == key) ||
+        (WEBCARD_REQUEST_KEY__HANDLING == key))
+      {
+        if (value->number.integer > UINT32_MAX) { return FALSE; }
+      }
+
+      if (WEBCARD_REQUEST_KEY__COMMAND == key)
+      {
+        request->command = (size_t) value->number.integer;
+      }
+      else if (WEBCARD_REQUEST_KEY__READER == key)
+      {
+        request->reader = (size_t) value->number.integer;
+      }
+      else if (WEBCARD_REQUEST_KEY__SHARE_MODE == key)
+      {
+        request->shareMode = (PCSC_DWORD) value->number.integer;
+      }
+      else
+      {
+        request->handling = (uint32_t) value->number.integer;
+      }
+
+      return TRUE;
+    }
+
+    case WEBCARD_REQUEST_KEY__STOP_ON_ERROR:
+    {
+      if ((JSON_VALUE_TYPE__TRUE != value->type) &&
+        (JSON_VALUE_TYPE__FALSE != value->type))
+      {
+        return FALSE;
+      }
+
+      request->stopOnError = (JSON_VALUE_TYPE__TRUE == value->type);
+
+      return TRUE;
+    }
+
+    case WEBCARD_REQUEST_KEY__DATA:
+    case WEBCARD_REQUEST_KEY__BASE64_DATA:
+    {
+      if ((JSON_VALUE_TYPE__STRING != value->type) &&
+        (JSON_VALUE_TYPE__ARRAY != value->type))
+      {
+        return FALSE;
+      }
+
+      request->data = value[0];
+
+      break;
+    }
+
+    default:
+    {
+      return FALSE;
+    }
+  }
+
+  /* The field owns the memory now */
+
+  JsonValue_init(value);
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+VOID
+WebCardRequest_init(
+  _Out_ WebCardRequest *request)
+{
+  request->keys        = 0;
+  request->invalidKeys = 0;
+  request->command     = 0;
+  request->reader      = 0;
+  request->shareMode   = SCARD_SHARE_SHARED;
+  request->stopOnError = FALSE;
+  request->handling    = 0;
+
+  UTF8String_init(&(request->id));
+  UTF8String_init(&(request->target));
+  JsonValue_init(&(request->data));
+}
+
+/**************************************************************/
+
+VOID
+WebCardRequest_destroy(
+  _Inout_ WebCardRequest *request)
+{
+  UTF8String_destroy(&(request->id));
+  UTF8String_destroy(&(request->target));
+  JsonValue_destroy(&(request->data));
+
+  WebCardRequest_init(request);
+}
+
+/**************************************************************/
+
+BOOL
+WebCardRequest_copy(
+  _Out_ WebCardRequest *destination,
+  _In_ const WebCardRequest *source)
+{
+  WebCardRequest_init(destination);
+
+  destination->keys        = source->keys;
+  destination->invalidKeys = source->invalidKeys;
+  destination->command     = source->command;
+  destination->reader      = source->reader;
+  destination->shareMode   = source->shareMode;
+  destination->stopOnError = source->stopOnError;
+  destination->handling    = source->handling;
+
+  /* The source can hold views into the input buffer */
+
+  return UTF8String_copy(&(destination->id), &(source->id)) &&
+    UTF8String_copy(&(destination->target), &(source->target)) &&
+    JsonValue_copy(&(destination->data), &(source->data));
+}
+
+/**************************************************************/
+
+BOOL
+WebCardRequest_parse(
+  _Out_ WebCardRequest *request,
+  _Inout_ JsonByteStream *stream)
+{
+  BOOL test_bool;
+  BYTE test_byte;
+  UTF8String utf8_key;
+  UTF8String *utf8_key_ptr = &(utf8_key);
+  JsonValue json_value;
+  JsonValue *json_value_ptr = &(json_value);
+  uint32_t key;
+  size_t count = 0;
+
+  WebCardRequest_init(request);
+
+  /* Request starts with '{' */
+
+  if (!JsonByteStream_read(stream, &(test_byte), 1) || ('{' != test_byte))
+  {
+    #if defined(_DEBUG)
+    OSSpecific_writeDebugMessage(
+      "WebCard request, parsing failed: expected an opening curly bracket");
+    #endif
+
+    return FALSE;
+  }
+
+  if (!JsonByteStream_enter(stream) || !JsonByteStream_skipWhitespace(stream))
+  {
+    return FALSE;
+  }
+
+  while (JsonByteStream_peek(stream, &(test_byte)))
+  {
+    if ('}' == test_byte)  /* Request ends with '}' */
+    {
+      JsonByteStream_skip(stream, 1);
+      JsonByteStream_leave(stream);
+      return TRUE;
+    }
+
+    if (0 != count)
+    {
+      if (',' != test_byte)
+      {
+        #if defined(_DEBUG)
+        OSSpecific_writeDebugMessage(
+          "WebCard request, parsing failed: expected a comma");
+        #endif
+
+        return FALSE;
+      }
+
+      JsonByteStream_skip(stream, 1);
+
+      if (!JsonByteStream_skipWhitespace(stream))
+      {
+        return FALSE;
+      }
+    }
+
+    /* Key (usually a view into the stream) and a colon */
+
+    if (!JsonString_parse(&(utf8_key_ptr), FALSE, stream))
+    {
+      UTF8String_destroy(&(utf8_key));
+      return FALSE;
+    }
+
+    key = WebCardRequest_lookupKey(&(utf8_key));
+
+    UTF8String_destroy(&(utf8_key));
+
+    if (!JsonByteStream_skipWhitespace(stream) ||
+      !JsonByteStream_read(stream, &(test_byte), 1) ||
+      (':' != test_byte))
+    {
+      return FALSE;
+    }
+
+    /* Unknown (or repeated) keys are not loaded at all. */
+    /* APDUs are given either as hex-strings or in Base64, */
+    /* and only the first of those two keys is used. */
+
+    if ((0 == key) || (0 != (key & (request->keys | request->invalidKeys))) ||
+      ((0 != (WEBCARD_REQUEST_KEY__ANY_DATA & key)) &&
+      (0 != (WEBCARD_REQUEST_KEY__ANY_DATA & request->keys))))
+    {
+      test_bool = JsonValue_skip(stream);
+    }
+    else
+    {
+      test_bool = JsonValue_parse(&(json_value_ptr), FALSE, stream);
+
+      if (test_bool)
+      {
+        if (WebCardRequest_storeValue(request, key, &(json_value)))
+        {
+          request->keys |= key;
+        }
+        else
+        {
+          request->invalidKeys |= key;
+        }
+      }
+
+      JsonValue_destroy(&(json_value));
+    }
+
+    if (!test_bool || !JsonByteStream_skipWhitespace(stream))
+    {
+      return FALSE;
+    }
+
+    count++;
+  }
+
+  return FALSE;
+}
+
+/**************************************************************/
@@ -0,0 +1,730 @@
+/**
+ * @file "native/src/smart_cards/sc_script.c"
+ * Communication with Smart Card Readers (physical or virtual peripherals).
+ */
+
+#include "smart_cards/smart_cards.h"
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `SCardScript` object.
+ * Looks for a variable with the given name.
+ *
+ * @param[in] script Reference to a VALID and CONSTANT `SCardScript` object.
+ * @param[in] name Variable name (not necessarily NULL-terminated).
+ * @param[in] nameLength Length of the variable name.
+ * @return Pointer to the found variable, or `NULL` if there is no such name.
+ */
+static SCardScriptVariable *
+SCardScript_findVariable(
+  _In_ const SCardScript *script,
+  _In_ LPCSTR name,
+  _In_ const size_t nameLength)
+{
+  size_t i;
+  const SCardScriptVariable *variable;
+
+  for (i = 0; i < script->count; i++)
+  {
+    variable = &(script->variables[i]);
+
+    if ((nameLength == variable->name.length) &&
+      (0 == memcmp(variable->name.text, name, nameLength)))
+    {
+      return (SCardScriptVariable *) variable;
+    }
+  }
+
+  return NULL;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `SCardScript` object.
+ * Converts one hexadecimal digit to its value.
+ *
+ * @param[in] digit ASCII character.
+ * @return Value from 0 to 15, or -1 if `digit` is not a hexadecimal digit.
+ */
+static int
+SCardScript_hexDigitValue(
+  _In_ const BYTE digit)
+{
+  if ((digit >= '0') && (digit <= '9'))
+  {
+    return (digit - '0');
+  }
+  else if ((digit >= 'A') && (digit <= 'F'))
+  {
+    return (digit - 'A' + 0x0A);
+  }
+  else if ((digit >= 'a') && (digit <= 'f'))
+  {
+    return (digit - 'a' + 0x0A);
+  }
+
+  return (-1);
+}
+
+/**************************************************************/
+
+VOID
+SCardScript_init(
+  _Out_ SCardScript *script)
+{
+  script->count = 0;
+}
+
+/**************************************************************/
+
+VOID
+SCardScript_destroy(
+  _Inout_ SCardScript *script)
+{
+  size_t i;
+
+  for (i = 0; i < script->count; i++)
+  {
+    UTF8String_destroy(&(script->variables[i].name));
+    UTF8String_destroy(&(script->variables[i].value));
+  }
+
+  script->count = 0;
+}
+
+/**************************************************************/
+
+BOOL
+SCardScript_setVariable(
+  _Inout_ SCardScript *script,
+  _In_z_ LPCSTR name,
+  _In_ LPCSTR value,
+  _In_ size_t valueLength,
+  _In_ const BOOL append)
+{
+  SCardScriptVariable *variable;
+
+  variable = SCardScript_findVariable(script, name, strlen(name));
+
+  if (NULL == variable)
+  {
+    if (script->count >= SCARD_SCRIPT__MAX_VARIABLES)
+    {
+      #if defined(_DEBUG)
+      {
+        OSSpecific_writeDebugMessage(
+          "{SCardScript::setVariable} failed: " \
+          "too many variables!"
+        );
+      }
+      #endif
+
+      return FALSE;
+    }
+
+    variable = &(script->variables[script->count]);
+
+    UTF8String_init(&(variable->name));
+    UTF8String_init(&(variable->value));
+
+    if (!UTF8String_pushText(&(variable->name), name, 0))
+    {
+      UTF8String_destroy(&(variable->name));
+      return FALSE;
+    }
+
+    script->count++;
+  }
+  else if ((!append) && (NULL != variable->value.text))
+  {
+    variable->value.length = 0;
+    variable->value.text[0] = '\0';
+  }
+
+  /* Empty value (`UTF8String_pushText` would treat */
+  /* zero length as a NULL-terminated text) */
+
+  if (0 == valueLength) { return TRUE; }
+
+  return UTF8String_pushText(
+    &(variable->value),
+    value,
+    valueLength);
+}
+
+/**************************************************************/
+
+BOOL
+SCardScript_expand(
+  _In_ const SCardScript *script,
+  _In_ const UTF8String *pattern,
+  _Inout_ UTF8String *output)
+{
+  size_t i;
+  size_t j;
+  const SCardScriptVariable *variable;
+
+  i = 0;
+
+  while (i < pattern->length)
+  {
+    /* Copy everything up to the next opening curly brace */
+
+    j = i;
+
+    while ((j < pattern->length) && ('{' != pattern->text[j]))
+    {
+      j++;
+    }
+
+    if ((j > i) && !UTF8String_pushText(
+      output,
+      (LPCSTR) &(pattern->text[i]),
+      (j - i)))
+    {
+      return FALSE;
+    }
+
+    if (j >= pattern->length) { break; }
+
+    /* Insert the value of "{name}" */
+
+    i = j + 1;
+
+    while ((j < pattern->length) && ('}' != pattern->text[j]))
+    {
+      j++;
+    }
+
+    if (j >= pattern->length)
+    {
+      return FALSE;
+    }
+
+    variable = SCardScript_findVariable(
+      script,
+      (LPCSTR) &(pattern->text[i]),
+      (j - i));
+
+    if (NULL == variable)
+    {
+      #if defined(_DEBUG)
+      {
+        OSSpecific_writeDebugMessage(
+          "{SCardScript::expand} failed: " \
+          "unknown variable!"
+        );
+      }
+      #endif
+
+      return FALSE;
+    }
+
+    if ((variable->value.length > 0) && !UTF8String_pushText(
+      output,
+      (LPCSTR) variable->value.text,
+      variable->value.length))
+    {
+      return FALSE;
+    }
+
+    i = j + 1;
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+SCardScript_advanceVariable(
+  _Inout_ SCardScript *script,
+  _In_z_ LPCSTR name,
+  _In_ size_t amount)
+{
+  SCardScriptVariable *variable;
+  size_t i;
+  int digit;
+
+  variable = SCardScript_findVariable(script, name, strlen(name));
+
+  if ((NULL == variable) || (0 == variable->value.length))
+  {
+    return FALSE;
+  }
+
+  /* Add the amount digit by digit, starting from the least significant */
+
+  i = variable->value.length;
+
+  while ((amount > 0) && (i > 0))
+  {
+    i--;
+
+    digit = SCardScript_hexDigitValue(variable->value.text[i]);
+
+    if (digit < 0) { return FALSE; }
+
+    amount += (size_t) digit;
+
+    variable->value.text[i] = "0123456789ABCDEF"[amount & 0x0F];
+
+    amount >>= 4;
+  }
+
+  /* Carry left over: the result does not fit in the variable */
+
+  return (0 == amount);
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `SCardScript` object.
+ * Compares a Status Word with a pattern.
+ *
+ * @param[in] pattern Reference to a VALID and CONSTANT `UTF8String` object
+ * that holds 4 hex digits (`X` matches any digit).
+ * @param[in] statusWord 4 hex digits.
+ * @return `TRUE` if the pattern matches the Status Word.
+ */
+static BOOL
+SCardScript_matchStatusWord(
+  _In_ const UTF8String *pattern,
+  _In_ const BYTE *statusWord)
+{
+  size_t i;
+
+  if (4 != pattern->length) { return FALSE; }
+
+  for (i = 0; i < 4; i++)
+  {
+    if (('X' == pattern->text[i]) || ('x' == pattern->text[i]))
+    {
+      continue;
+    }
+
+    if (SCardScript_hexDigitValue(pattern->text[i]) !=
+      SCardScript_hexDigitValue(statusWord[i]))
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `SCardScript` object.
+ * Sets the variables listed under the "s" key of a step.
+ *
+ * @param[in,out] script Reference to a VALID `SCardScript` object.
+ * @param[in] step Reference to a VALID and CONSTANT `JsonObject` object.
+ * @return `TRUE` on success, `FALSE` on invalid step
+ * OR on memory allocation error.
+ */
+static BOOL
+SCardScript_runAssignments(
+  _Inout_ SCardScript *script,
+  _In_ const JsonObject *step)
+{
+  BOOL test_bool;
+  JsonValue json_value;
+  const JsonObject *assignments;
+  const JsonPair *pair;
+  UTF8String utf8_value;
+  size_t i;
+
+  if (!JsonObject_getValue(step, &(json_value), "s"))
+  {
+    return TRUE;
+  }
+
+  if (JSON_VALUE_TYPE__OBJECT != json_value.type)
+  {
+    return FALSE;
+  }
+
+  assignments = &(json_value.object);
+
+  for (i = 0; i < assignments->count; i++)
+  {
+    pair = &(assignments->pairs[i]);
+
+    if ((0 == pair->key.length) ||
+      (JSON_VALUE_TYPE__STRING != pair->value.type))
+    {
+      return FALSE;
+    }
+
+    /* Values can refer to other variables */
+
+    UTF8String_init(&(utf8_value));
+
+    test_bool = SCardScript_expand(
+      script,
+      &(pair->value.string),
+      &(utf8_value));
+
+    if (test_bool)
+    {
+      test_bool = SCardScript_setVariable(
+        script,
+        (LPCSTR) pair->key.text,
+        (LPCSTR) utf8_value.text,
+        utf8_value.length,
+        FALSE);
+    }
+
+    UTF8String_destroy(&(utf8_value));
+
+    if (!test_bool) { return FALSE; }
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `SCardScript` object.
+ * Transmits the APDU from the "a" key of a step, then updates
+ * the "sw" variable and the variables named by the "v" and "o" keys.
+ *
+ * @param[in,out] script Reference to a VALID `SCardScript` object.
+ * @param[in] step Reference to a VALID and CONSTANT `JsonObject` object.
+ * @param[in,out] connection Reference to a VALID `SCardConnection` object
+ * (with the `output` buffer already allocated).
+ * @param[in] handling Combination of `SCARD_APDU_HANDLING__*` flags.
+ * @param[out] transmitted Set to `TRUE` if the step had an APDU.
+ * @return `TRUE` on success, `FALSE` on invalid step
+ * OR on memory allocation error OR on any internal Smart Card error.
+ */
+static BOOL
+SCardScript_runApdu(
+  _Inout_ SCardScript *script,
+  _In_ const JsonObject *step,
+  _Inout_ SCardConnection *connection,
+  _In_ const uint32_t handling,
+  _Out_ BOOL *transmitted)
+{
+  BOOL test_bool;
+  JsonValue json_value;
+  UTF8String *utf8_hex = &(connection->hex);
+  size_t input_bytes_length;
+  size_t data_length;
+  LPCSTR name;
+
+  transmitted[0] = FALSE;
+
+  if (!JsonObject_getValue(step, &(json_value), "a"))
+  {
+    return TRUE;
+  }
+
+  if (JSON_VALUE_TYPE__STRING != json_value.type)
+  {
+    return FALSE;
+  }
+
+  /* Prepare input byte buffer */
+  /* (the APDU is expanded in the connection's reusable hex-string) */
+
+  utf8_hex->length = 0;
+
+  test_bool = SCardScript_expand(
+    script,
+    &(json_value.string),
+    utf8_hex);
+
+  if (test_bool)
+  {
+    test_bool = SCardConnection_decodeApdu(
+      connection,
+      utf8_hex,
+      SCARD_APDU_ENCODING__HEX,
+      &(input_bytes_length));
+
+    if (test_bool && (0 == input_bytes_length))
+    {
+      test_bool = FALSE;
+    }
+  }
+
+  if (!test_bool) { return FALSE; }
+
+  /* Transmit and receive (the same hex-string holds the response) */
+
+  transmitted[0] = TRUE;
+
+  utf8_hex->length = 0;
+
+  test_bool = SCardConnection_transceiveMultiple(
+    connection,
+    utf8_hex,
+    SCARD_APDU_ENCODING__HEX,
+    handling,
+    connection->input,
+    input_bytes_length,
+    connection->output,
+    MAX_APDU_SIZE,
+    NULL);
+
+  /* Every response should end with a Status Word */
+
+  if (test_bool && (utf8_hex->length < 4))
+  {
+    test_bool = FALSE;
+  }
+
+  if (test_bool)
+  {
+    data_length = utf8_hex->length - 4;
+
+    test_bool = SCardScript_setVariable(
+      script,
+      "sw",
+      (LPCSTR) &(utf8_hex->text[data_length]),
+      4,
+      FALSE);
+  }
+
+  /* Try to find the "v" key (variable for the response data) */
+
+  if (test_bool && JsonObject_getValue(step, &(json_value), "v"))
+  {
+    name = (JSON_VALUE_TYPE__STRING == json_value.type) ?
+      (LPCSTR) json_value.string.text :
+      NULL;
+
+    if ((NULL == name) || ('\0' == name['+' == name[0]]))
+    {
+      test_bool = FALSE;
+    }
+    else
+    {
+      test_bool = SCardScript_setVariable(
+        script,
+        ('+' == name[0]) ? &(name[1]) : name,
+        (LPCSTR) utf8_hex->text,
+        data_length,
+        ('+' == name[0]));
+    }
+  }
+
+  /* Try to find the "o" key (offset to advance by the data length) */
+
+  if (test_bool && JsonObject_getValue(step, &(json_value), "o"))
+  {
+    if ((JSON_VALUE_TYPE__STRING != json_value.type) ||
+      (0 == json_value.string.length))
+    {
+      test_bool = FALSE;
+    }
+    else
+    {
+      test_bool = SCardScript_advanceVariable(
+        script,
+        (LPCSTR) json_value.string.text,
+        data_length / 2);
+    }
+  }
+
+  return test_bool;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for `SCardScript` object.
+ * Selects the next step, using the "j" key of the current step.
+ *
+ * @param[in] script Reference to a VALID and CONSTANT `SCardScript` object.
+ * @param[in] step Reference to a VALID and CONSTANT `JsonObject` object.
+ * @param[in] transmitted `TRUE` if the current step had an APDU.
+ * @param[in] stepCount Number of script steps.
+ * @param[in,out] stepIndex On input: index of the current step.
+ * On output: index of the next step (`stepCount` ends the script).
+ * @return `TRUE` on success, `FALSE` on invalid step.
+ */
+static BOOL
+SCardScript_runJump(
+  _In_ const SCardScript *script,
+  _In_ const JsonObject *step,
+  _In_ const BOOL transmitted,
+  _In_ const size_t stepCount,
+  _Inout_ size_t *stepIndex)
+{
+  JsonValue json_value;
+  const JsonObject *jumps;
+  const JsonPair *pair;
+  const SCardScriptVariable *status_word;
+  int64_t target;
+  size_t i;
+
+  status_word = SCardScript_findVariable(script, "sw", 2);
+
+  if ((NULL != status_word) && (4 == status_word->value.length) &&
+    JsonObject_getValue(step, &(json_value), "j"))
+  {
+    if (JSON_VALUE_TYPE__OBJECT != json_value.type)
+    {
+      return FALSE;
+    }
+
+    jumps = &(json_value.object);
+
+    /* The first matching pattern wins */
+
+    for (i = 0; i < jumps->count; i++)
+    {
+      pair = &(jumps->pairs[i]);
+
+      if (JSON_VALUE_TYPE__NUMBER != pair->value.type)
+      {
+        return FALSE;
+      }
+
+      if (SCardScript_matchStatusWord(&(pair->key), status_word->value.text))
+      {
+        target = pair->value.number.integer;
+
+        stepIndex[0] = ((target < 0) || (target >= (int64_t) stepCount)) ?
+          stepCount :
+          (size_t) target;
+
+        return TRUE;
+      }
+    }
+  }
+
+  /* No matching jump: an unexpected Status Word ends the script */
+
+  if (transmitted && ((NULL == status_word) ||
+    !UTF8String_matches(&(status_word->value), "9000")))
+  {
+    stepIndex[0] = stepCount;
+    return TRUE;
+  }
+
+  stepIndex[0] += 1;
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+SCardScript_run(
+  _Inout_ SCardScript *script,
+  _In_ const JsonArray *steps,
+  _In_ const uint32_t handling,
+  _Inout_ SCardWorker *worker)
+{
+  BOOL test_bool;
+  BOOL transmitted;
+  const JsonObject *step;
+  size_t step_index;
+  size_t step_counter;
+
+  if (!SCardConnection_assertOutput(&(worker->connection)))
+  {
+    return FALSE;
+  }
+
+  test_bool = TRUE;
+  step_index = 0;
+  step_counter = 0;
+
+  while (test_bool && (step_index < steps->count))
+  {
+    /* Jumps can make loops: limit the total number of steps */
+
+    if (step_counter >= SCARD_SCRIPT__MAX_STEPS)
+    {
+      #if defined(_DEBUG)
+      {
+        OSSpecific_writeDebugMessage(
+          "{SCardScript::run} failed: " \
+          "too many steps!"
+        );
+      }
+      #endif
+
+      test_bool = FALSE;
+      break;
+    }
+
+    step_counter++;
+
+    /* Stop between steps if the request was cancelled */
+
+    if (SCardWorker_isCancelled(worker))
+    {
+      break;
+    }
+
+    if (JSON_VALUE_TYPE__OBJECT != steps->values[step_index].type)
+    {
+      test_bool = FALSE;
+      break;
+    }
+
+    step = &(steps->values[step_index].object);
+
+    test_bool = SCardScript_runAssignments(script, step);
+
+    if (test_bool)
+    {
+      test_bool = SCardScript_runApdu(
+        script,
+        step,
+        &(worker->connection),
+        handling,
+        &(transmitted));
+    }
+
+    if (test_bool)
+    {
+      test_bool = SCardScript_runJump(
+        script,
+        step,
+        transmitted,
+        steps->count,
+        &(step_index));
+    }
+  }
+
+  return test_bool;
+}
+
+/**************************************************************/
+
+BOOL
+SCardScript_writeVariables(
+  _In_ const SCardScript *script,
+  _Inout_ JsonWriter *writer)
+{
+  size_t i;
+
+  if (!JsonWriter_beginObject(writer))
+  {
+    return FALSE;
+  }
+
+  for (i = 0; i < script->count; i++)
+  {
+    if (!JsonWriter_key(writer, (LPCSTR) script->variables[i].name.text) ||
+      !JsonWriter_string(writer, &(script->variables[i].value)))
+    {
+      return FALSE;
+    }
+  }
+
+  return JsonWriter_end(writer);
+}
+
+/**************************************************************/
@@ -0,0 +1,593 @@
+/**
+ * @file "native/src/smart_cards/sc_watcher.c"
+ * Communication with Smart Card Readers (physical or virtual peripherals).
+ */
+
+#include "smart_cards/smart_cards.h"
+
+/**************************************************************/
+
+/**
+ * @brief Appends a new Reader State to the queue of events.
+ * The caller must hold the `watcher->mutex`.
+ *
+ * @param[in,out] watcher Reference to a VALID `SCardWatcher` object.
+ * @param[in] generation Version of the watched reader list.
+ * @param[in] readerIndex Zero-based index of the reader in that list.
+ * @param[in] readerState Reference to a read-only Reader State,
+ * that contains the new state and the "Answer To Reset".
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+static BOOL
+SCardWatcher_queueEvent(
+  _Inout_ SCardWatcher *watcher,
+  _In_ const size_t generation,
+  _In_ const size_t readerIndex,
+  _In_ const SCARD_READERSTATE *readerState)
+{
+  size_t new_capacity;
+  SCardWatcherEvent *event;
+
+  if (watcher->eventsCount >= watcher->eventsCapacity)
+  {
+    new_capacity = Misc_nextPowerOfTwo(1 + watcher->eventsCount);
+
+    event = realloc(
+      watcher->events,
+      sizeof(SCardWatcherEvent) * new_capacity);
+
+    if (NULL == event) { return FALSE; }
+
+    watcher->events = event;
+    watcher->eventsCapacity = new_capacity;
+  }
+
+  event = &(watcher->events[watcher->eventsCount]);
+
+  event->generation = generation;
+  event->readerIndex = readerIndex;
+  event->eventState = readerState->dwEventState & (~SCARD_STATE_CHANGED);
+  event->atrLength = readerState->cbAtr;
+
+  if (event->atrLength > sizeof(event->atr))
+  {
+    event->atrLength = sizeof(event->atr);
+  }
+
+  memcpy(event->atr, readerState->rgbAtr, event->atrLength);
+
+  watcher->eventsCount += 1;
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief Checks if the Smart Card Service supports
+ * the PnP Notification pseudo-reader.
+ *
+ * @param[in] context A handle that identifies the resource manager context.
+ * @param[out] pnpStateRef Pointer to a location that receives
+ * the current state of the pseudo-reader.
+ * @return `TRUE` if the PnP Notifications are supported, otherwise `FALSE`.
+ */
+static BOOL
+SCardWatcher_detectPnpNotifications(
+  _In_ const SCARDCONTEXT context,
+  _Out_ PCSC_DWORD *pnpStateRef)
+{
+  SCARD_READERSTATE pnp_state;
+  PCSC_LONG pcscResult;
+
+  memset(&(pnp_state), 0x00, sizeof(SCARD_READERSTATE));
+  pnp_state.szReader = WEBCARD_PNP_READER_NAME;
+  pnp_state.dwCurrentState = SCARD_STATE_UNAWARE;
+
+  pnpStateRef[0] = SCARD_STATE_UNAWARE;
+
+  pcscResult = SCardGetStatusChange(
+    context,
+    0,
+    &(pnp_state),
+    1);
+
+  if ((SCARD_S_SUCCESS != pcscResult) && (SCARD_E_TIMEOUT != pcscResult))
+  {
+    return FALSE;
+  }
+
+  if (pnp_state.dwEventState & SCARD_STATE_UNKNOWN)
+  {
+    return FALSE;
+  }
+
+  pnpStateRef[0] = (pnp_state.dwEventState & (~SCARD_STATE_CHANGED));
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief The watcher thread: waits for Reader State changes
+ * until the `watcher->shouldStop` flag is set.
+ *
+ * @param[in] param Reference to a VALID `SCardWatcher` object.
+ */
+static VOID
+SCardWatcher_threadRoutine(
+  _In_opt_ LPVOID param)
+{
+  SCardWatcher *watcher = (SCardWatcher *) param;
+  SCardReaderDB readers;
+  SCARDCONTEXT context;
+  PCSC_LONG pcscResult;
+  PCSC_DWORD pnp_state = SCARD_STATE_UNAWARE;
+  size_t generation = 0;
+  BOOL new_context = TRUE;
+  BOOL pnp_supported = FALSE;
+  BOOL events_queued;
+  int readers_count;
+  int i;
+
+  SCardReaderDB_init(&(readers));
+
+  OSSpecific_lockMutex(&(watcher->mutex));
+
+  while (!watcher->shouldStop)
+  {
+    /* Re-establish the Smart Card Context (service restarted) */
+
+    if (0 == watcher->context)
+    {
+      OSSpecific_unlockMutex(&(watcher->mutex));
+      WebCard_establishContext(&(context));
+      OSSpecific_lockMutex(&(watcher->mutex));
+
+      watcher->context = context;
+
+      if (0 == context)
+      {
+        OSSpecific_waitForCondition(
+          &(watcher->condition),
+          &(watcher->mutex),
+          WEBCARD_INTERVAL__READERS_FETCH);
+      }
+      else
+      {
+        new_context = TRUE;
+      }
+
+      continue;
+    }
+
+    /* Check the PnP support for every new context. Readers could have */
+    /* been plugged in or unplugged while nothing was watching them. */
+
+    if (new_context)
+    {
+      context = watcher->context;
+      OSSpecific_unlockMutex(&(watcher->mutex));
+
+      pnp_supported = SCardWatcher_detectPnpNotifications(
+        context,
+        &(pnp_state));
+
+      OSSpecific_lockMutex(&(watcher->mutex));
+
+      #if defined(_DEBUG)
+      {
+        OSSpecific_writeDebugMessage(
+          "PnP Notifications supported: %d",
+          pnp_supported);
+      }
+      #endif
+
+      watcher->pnpSupported = pnp_supported;
+      watcher->readersChanged = TRUE;
+      OSSpecific_signalEvent(watcher->wakeEvent);
+
+      new_context = FALSE;
+      generation = 0;
+
+      continue;
+    }
+
+    /* Pick up the newest list of readers */
+    /* (the PnP pseudo-reader is always the last one) */
+
+    if (generation != watcher->generation)
+    {
+      SCardReaderDB_destroy(&(readers));
+
+      if ((!SCardReaderDB_copyReaders(&(readers), &(watcher->readers))) ||
+        (pnp_supported &&
+          (!SCardReaderDB_appendReader(&(readers), WEBCARD_PNP_READER_NAME))))
+      {
+        SCardReaderDB_destroy(&(readers));
+        SCardReaderDB_init(&(readers));
+
+        OSSpecific_waitForCondition(
+          &(watcher->condition),
+          &(watcher->mutex),
+          WEBCARD_INTERVAL__READERS_FETCH);
+
+        continue;
+      }
+
+      if (pnp_supported)
+      {
+        readers.states[readers.count - 1].dwCurrentState = pnp_state;
+      }
+
+      generation = watcher->generation;
+      watcher->watchedGeneration = generation;
+
+      continue;
+    }
+
+    /* Nothing to wait on, until the list of readers changes */
+
+    if (0 == readers.count)
+    {
+      OSSpecific_waitForCondition(
+        &(watcher->condition),
+        &(watcher->mutex),
+        OS_SPECIFIC_INFINITE);
+
+      continue;
+    }
+
+    /* Block (without holding the mutex) until any reader changes, */
+    /* or until `SCardCancel()` is called by the main thread */
+
+    context = watcher->context;
+    watcher->waiting = TRUE;
+    OSSpecific_unlockMutex(&(watcher->mutex));
+
+    pcscResult = SCardGetStatusChange(
+      context,
+      INFINITE,
+      readers.states,
+      readers.count);
+
+    OSSpecific_lockMutex(&(watcher->mutex));
+    watcher->waiting = FALSE;
+
+    if (SCARD_S_SUCCESS == pcscResult)
+    {
+      events_queued = FALSE;
+
+      readers_count = pnp_supported ? (readers.count - 1) : readers.count;
+
+      for (i = 0; i < readers.count; i++)
+      {
+        SCARD_READERSTATE *readerState = &(readers.states[i]);
+
+        if (readerState->dwEventState & SCARD_STATE_CHANGED)
+        {
+          if (i >= readers_count)
+          {
+            /* PnP Notification */
+
+            watcher->readersChanged = TRUE;
+            events_queued = TRUE;
+          }
+          else if (generation == watcher->generation)
+          {
+            /* Events for an outdated list would be dropped anyway */
+
+            if (SCardWatcher_queueEvent(watcher, generation, i, readerState))
+            {
+              events_queued = TRUE;
+            }
+          }
+
+          readerState->dwCurrentState =
+            (readerState->dwEventState & (~SCARD_STATE_CHANGED));
+        }
+      }
+
+      if (pnp_supported)
+      {
+        pnp_state = readers.states[readers.count - 1].dwCurrentState;
+      }
+
+      if (events_queued)
+      {
+        OSSpecific_signalEvent(watcher->wakeEvent);
+      }
+    }
+    else if ((SCARD_E_CANCELLED != pcscResult) &&
+      (SCARD_E_TIMEOUT != pcscResult))
+    {
+      #if defined(_DEBUG)
+      {
+        OSSpecific_writeDebugMessage(
+          "{SCardGetStatusChange} failed: 0x%08X (%s)",
+          (uint32_t) pcscResult,
+          WebCard_errorLookup(pcscResult));
+      }
+      #endif
+
+      if ((SCARD_E_SERVICE_STOPPED == pcscResult) ||
+        (SCARD_E_NO_SERVICE == pcscResult) ||
+        (SCARD_E_INVALID_HANDLE == pcscResult))
+      {
+        /* Context is lost: every reader must be reported again */
+
+        SCardReleaseContext(watcher->context);
+        watcher->context = 0;
+      }
+
+      /* Do not retry immediately, unless the list of readers changes */
+
+      if ((!watcher->shouldStop) && (generation == watcher->generation))
+      {
+        OSSpecific_waitForCondition(
+          &(watcher->condition),
+          &(watcher->mutex),
+          WEBCARD_INTERVAL__READERS_FETCH);
+      }
+    }
+  }
+
+  /* Let the main thread know that no more `SCardCancel()` calls are needed */
+
+  watcher->running = FALSE;
+  OSSpecific_wakeCondition(&(watcher->condition));
+
+  OSSpecific_unlockMutex(&(watcher->mutex));
+
+  SCardReaderDB_destroy(&(readers));
+}
+
+/**************************************************************/
+
+BOOL
+SCardWatcher_init(
+  _Out_ SCardWatcher *watcher,
+  _In_ os_specific_event_t *wakeEvent,
+  _In_ const SCardReaderDB *database)
+{
+  watcher->wakeEvent = wakeEvent;
+  watcher->generation = 1;
+  watcher->watchedGeneration = 0;
+  watcher->waiting = FALSE;
+  watcher->pnpSupported = FALSE;
+  watcher->readersChanged = FALSE;
+  watcher->shouldStop = FALSE;
+  watcher->running = TRUE;
+  watcher->eventsCount = 0;
+  watcher->eventsCapacity = 0;
+  watcher->events = NULL;
+
+  if (!SCardReaderDB_copyReaders(&(watcher->readers), database))
+  {
+    SCardReaderDB_destroy(&(watcher->readers));
+    return FALSE;
+  }
+
+  if (!WebCard_establishContext(&(watcher->context)))
+  {
+    SCardReaderDB_destroy(&(watcher->readers));
+    return FALSE;
+  }
+
+  if (!OSSpecific_initMutex(&(watcher->mutex)))
+  {
+    SCardReleaseContext(watcher->context);
+    SCardReaderDB_destroy(&(watcher->readers));
+    return FALSE;
+  }
+
+  if (!OSSpecific_initCondition(&(watcher->condition)))
+  {
+    OSSpecific_destroyMutex(&(watcher->mutex));
+    SCardReleaseContext(watcher->context);
+    SCardReaderDB_destroy(&(watcher->readers));
+    return FALSE;
+  }
+
+  if (!OSSpecific_createThread(
+    &(watcher->thread),
+    SCardWatcher_threadRoutine,
+    (LPVOID) watcher))
+  {
+    OSSpecific_destroyCondition(&(watcher->condition));
+    OSSpecific_destroyMutex(&(watcher->mutex));
+    SCardReleaseContext(watcher->context);
+    SCardReaderDB_destroy(&(watcher->readers));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+VOID
+SCardWatcher_destroy(
+  _Inout_ SCardWatcher *watcher)
+{
+  OSSpecific_lockMutex(&(watcher->mutex));
+
+  watcher->shouldStop = TRUE;
+  OSSpecific_wakeCondition(&(watcher->condition));
+
+  /* A cancellation is lost if the watcher thread */
+  /* was not yet waiting, so keep repeating it */
+
+  while (watcher->running)
+  {
+    if (0 != watcher->context)
+    {
+      SCardCancel(watcher->context);
+    }
+
+    OSSpecific_waitForCondition(
+      &(watcher->condition),
+      &(watcher->mutex),
+      WEBCARD_INTERVAL__WATCHER_RETRY);
+  }
+
+  OSSpecific_unlockMutex(&(watcher->mutex));
+
+  OSSpecific_joinThread(watcher->thread);
+
+  OSSpecific_destroyCondition(&(watcher->condition));
+  OSSpecific_destroyMutex(&(watcher->mutex));
+
+  if (0 != watcher->context)
+  {
+    SCardReleaseContext(watcher->context);
+  }
+
+  SCardReaderDB_destroy(&(watcher->readers));
+
+  if (NULL != watcher->events)
+  {
+    free(watcher->events);
+  }
+}
+
+/**************************************************************/
+
+BOOL
+SCardWatcher_setReaders(
+  _Inout_ SCardWatcher *watcher,
+  _In_ const SCardReaderDB *database)
+{
+  SCardReaderDB readers;
+
+  if (!SCardReaderDB_copyReaders(&(readers), database))
+  {
+    SCardReaderDB_destroy(&(readers));
+    return FALSE;
+  }
+
+  OSSpecific_lockMutex(&(watcher->mutex));
+
+  SCardReaderDB_destroy(&(watcher->readers));
+  watcher->readers = readers;
+  watcher->generation += 1;
+
+  OSSpecific_wakeCondition(&(watcher->condition));
+
+  if (0 != watcher->context)
+  {
+    SCardCancel(watcher->context);
+  }
+
+  OSSpecific_unlockMutex(&(watcher->mutex));
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+SCardWatcher_synchronize(
+  _Inout_ SCardWatcher *watcher)
+{
+  BOOL test_bool;
+
+  OSSpecific_lockMutex(&(watcher->mutex));
+
+  /* Only a blocked thread needs to be interrupted, */
+  /* otherwise it will pick up the new list by itself */
+
+  test_bool = (!watcher->waiting) ||
+    (watcher->generation == watcher->watchedGeneration);
+
+  if (!test_bool)
+  {
+    SCardCancel(watcher->context);
+  }
+
+  OSSpecific_unlockMutex(&(watcher->mutex));
+
+  return test_bool;
+}
+
+/**************************************************************/
+
+BOOL
+SCardWatcher_hasPnpNotifications(
+  _Inout_ SCardWatcher *watcher)
+{
+  BOOL test_bool;
+
+  OSSpecific_lockMutex(&(watcher->mutex));
+  test_bool = watcher->pnpSupported;
+  OSSpecific_unlockMutex(&(watcher->mutex));
+
+  return test_bool;
+}
+
+/**************************************************************/
+
+BOOL
+SCardWatcher_takeReadersChange(
+  _Inout_ SCardWatcher *watcher)
+{
+  BOOL test_bool;
+
+  OSSpecific_lockMutex(&(watcher->mutex));
+  test_bool = watcher->readersChanged;
+  watcher->readersChanged = FALSE;
+  OSSpecific_unlockMutex(&(watcher->mutex));
+
+  return test_bool;
+}
+
+/**************************************************************/
+
+SCardWatcherEvent *
+SCardWatcher_takeEvents(
+  _Inout_ SCardWatcher *watcher,
+  _Out_ size_t *countRef)
+{
+  SCardWatcherEvent *events;
+  size_t count;
+  size_t generation;
+  size_t i;
+
+  OSSpecific_lockMutex(&(watcher->mutex));
+
+  events = watcher->events;
+  count = watcher->eventsCount;
+  generation = watcher->generation;
+
+  watcher->events = NULL;
+  watcher->eventsCount = 0;
+  watcher->eventsCapacity = 0;
+
+  OSSpecific_unlockMutex(&(watcher->mutex));
+
+  /* Keep only the events that match current Database */
+
+  countRef[0] = 0;
+
+  for (i = 0; i < count; i++)
+  {
+    if (generation == events[i].generation)
+    {
+      events[countRef[0]] = events[i];
+      countRef[0] += 1;
+    }
+  }
+
+  if (0 == countRef[0])
+  {
+    /* All the events were outdated (or none was queued) */
+
+    free(events);
+    return NULL;
+  }
+
+  return events;
+}
+
+/**************************************************************/
@@ -233,6 +233,7 @@ WebCard_init(
     fetch_result = SCardReaderDB_fetch(
       resultDatabase,
       NULL,
+      NULL,
       resultContext[0],
       TRUE);
 
@@ -265,49 +266,175 @@ WebCard_init(
 
 /**************************************************************/
 
+/**
+ * @brief Timer callback, which requests fetching the list of readers.
+ *
+ * @param[in,out] param Pointer to the `BOOL` flag checked by the main loop.
+ */
+static VOID
+WebCard_requestFetch(
+  _In_opt_ LPVOID param)
+{
+  ((BOOL *) param)[0] = TRUE;
+}
+
+/**************************************************************/
+
 VOID
 WebCard_run(void)
 {
   SCARDCONTEXT context;
   SCardReaderDB database;
+  SCardWatcher watcher;
+  SCardWorkerResults results;
+  os_specific_event_t wake_event;
+  os_specific_stream_t stdin_stream;
   int byte_stream_status;
   int fetch_result;
+  int wait_result;
 
+  JsonInputBuffer input;
+  JsonArena json_arena;
   JsonByteStream json_stream;
-  JsonObject json_request;
-  JsonObject json_response;
-  JsonArray json_reader_names;
+  WebCardRequest request;
+  JsonArray json_added_names;
+  JsonArray json_removed_names;
+  JsonOutputQueue output;
+
+  TimerHeap timers;
+  size_t refresh_timer = 0;
+  uint32_t timeout;
+
+  BOOL should_fetch = FALSE;
+  BOOL pnp_supported;
+  BOOL has_wake_event = FALSE;
+  BOOL has_results = FALSE;
+  BOOL has_watcher = FALSE;
+  BOOL active = WebCard_init(&(database), &(context));
 
-  clock_t cpu_time_start = clock();
-  clock_t cpu_time_end;
-  double cpu_time_elapsed;
+  /* Get Standard Input stream identifier */
 
-  BOOL should_fetch;
-  BOOL active = WebCard_init(&(database), &(context));
+  #if defined(_WIN32)
+  {
+    stdin_stream = GetStdHandle(STD_INPUT_HANDLE);
+
+    if (INVALID_HANDLE_VALUE == stdin_stream)
+    {
+      active = FALSE;
+    }
+  }
+  #elif defined(__linux__) || defined(__APPLE__)
+  {
+    stdin_stream = STDIN_FILENO;
+  }
+  #endif
+
+  /* Requests are read in chunks (incomplete ones wait for the rest), */
+  /* responses and Reader Events are queued, */
+  /* and then sent together once per iteration */
+
+  JsonInputBuffer_init(&(input));
+  JsonOutputQueue_init(&(output));
+
+  /* Every JSON Request is built in one arena, */
+  /* which is then reclaimed at once */
+
+  JsonArena_init(&(json_arena));
+
+  /* Start watching the Smart Card Readers on a separate thread */
+  /* (after catching up with their current states) */
+
+  if (active)
+  {
+    active = OSSpecific_initEvent(&(wake_event));
+    has_wake_event = active;
+  }
+
+  /* Reader Workers hand their JSON Responses over to the main loop */
+
+  if (active)
+  {
+    active = SCardWorkerResults_init(&(results), &(wake_event));
+    has_results = active;
+  }
+
+  if (active)
+  {
+    WebCard_handleStatusChange(&(database), context, &(output));
+
+    active = SCardWatcher_init(&(watcher), &(wake_event), &(database));
+    has_watcher = active;
+  }
+
+  TimerHeap_init(&(timers));
 
   while (active)
   {
-    cpu_time_end = clock();
-    cpu_time_elapsed =
-      ((double)(cpu_time_end - cpu_time_start)) / FIXED_CLOCKS_PER_SEC;
+    /* Without PnP Notifications, the list of readers */
+    /* must be fetched periodically (every 1.0 second) */
 
-    /* Do the fetching every 1.0 second(s) */
+    pnp_supported = SCardWatcher_hasPnpNotifications(&(watcher));
 
-    if (cpu_time_elapsed >= 1.0)
+    if ((!pnp_supported) && (0 == refresh_timer))
+    {
+      refresh_timer = TimerHeap_schedule(
+        &(timers),
+        WEBCARD_INTERVAL__READERS_FETCH,
+        WEBCARD_INTERVAL__READERS_FETCH,
+        WebCard_requestFetch,
+        (LPVOID) &(should_fetch));
+    }
+    else if (pnp_supported && (0 != refresh_timer))
     {
-      cpu_time_start = cpu_time_end;
+      TimerHeap_cancel(&(timers), refresh_timer);
+      refresh_timer = 0;
+    }
+
+    /* Sleep until a request arrives on Standard Input, */
+    /* until the Reader Watcher reports some changes, */
+    /* or until the earliest timer expires */
+
+    timeout = TimerHeap_getTimeout(&(timers), OSSpecific_getMonotonicTime());
 
+    if ((timeout > WEBCARD_INTERVAL__WATCHER_RETRY) &&
+      (!SCardWatcher_synchronize(&(watcher))))
+    {
+      timeout = WEBCARD_INTERVAL__WATCHER_RETRY;
+    }
+
+    wait_result = OSSpecific_waitForStream(
+      stdin_stream,
+      &(wake_event),
+      timeout);
+
+    if (OS_SPECIFIC_WAIT__FAILED == wait_result)
+    {
+      active = FALSE;
+    }
+
+    /* Fetch when the Reader Watcher noticed a PnP Notification, */
+    /* or when the periodic refresh timer has expired */
+
+    if (SCardWatcher_takeReadersChange(&(watcher)))
+    {
+      should_fetch = TRUE;
+    }
+
+    TimerHeap_runExpired(&(timers), OSSpecific_getMonotonicTime());
+
+    if (active && should_fetch)
+    {
       /* 1) Fetch list of Smart Card Readers */
       /* (detecting plugging and unplugging) */
 
-      should_fetch = TRUE;
       while (should_fetch)
       {
         should_fetch = FALSE;
 
         fetch_result = SCardReaderDB_fetch(
           &(database),
-          &(json_reader_names),
+          &(json_added_names),
+          &(json_removed_names),
           context,
           FALSE);
 
@@ -331,20 +458,43 @@ WebCard_run(void)
           }
           else
           {
-            WebCard_sendReaderEvent(
-              NULL,
-              0,
-              (WEBCARD_FETCH_READERS__MORE_READERS == fetch_result) ?
-                WEBCARD_READER_EVENT__READERS_MORE :
+            /* A reader replaced by another one is reported */
+            /* with both events */
+
+            if (0 != json_removed_names.count)
+            {
+              WebCard_sendReaderEvent(
+                NULL,
+                0,
                 WEBCARD_READER_EVENT__READERS_LESS,
-              &(json_response),
-              &(json_reader_names));
+                &(json_removed_names),
+                &(output));
+            }
+
+            if (0 != json_added_names.count)
+            {
+              WebCard_sendReaderEvent(
+                NULL,
+                0,
+                WEBCARD_READER_EVENT__READERS_MORE,
+                &(json_added_names),
+                &(output));
+            }
+
+            /* Readers were reloaded: catch up with their states, */
+            /* and let the Reader Watcher follow the new list */
+
+            WebCard_handleStatusChange(&(database), context, &(output));
 
-            JsonObject_destroy(&(json_response));
+            if (!SCardWatcher_setReaders(&(watcher), &(database)))
+            {
+              active = FALSE;
+            }
           }
         }
 
-        JsonArray_destroy(&(json_reader_names));
+        JsonArray_destroy(&(json_added_names));
+        JsonArray_destroy(&(json_removed_names));
       }
     }
 
@@ -353,35 +503,97 @@ WebCard_run(void)
 
     if (active)
     {
-      /* 2) Update Smart Card Reader Status list */
+      /* 2) Apply Reader States reported by the Reader Watcher */
       /* (detecting existence of smart cards) */
 
-      WebCard_handleStatusChange(&(database), context);
+      WebCard_handleWatcherEvents(&(database), &(watcher), &(output));
 
       /* 3) Parse commands from Standard Input */
+      /* (every complete message that has arrived so far) */
 
-      byte_stream_status = JsonByteStream_loadFromStandardInput(&(json_stream));
-
-      if (JSON_STREAM_STATUS__VALID == byte_stream_status)
+      if (OS_SPECIFIC_WAIT__STREAM == wait_result)
       {
-        WebCard_handleRequest(
-          &(json_stream),
-          &(json_request),
-          &(json_response),
-          &(database),
-          context);
+        if (JSON_STREAM_STATUS__NO_MORE ==
+          JsonInputBuffer_readFromStream(&(input), stdin_stream))
+        {
+          /* Stream closed: answer the messages that were */
+          /* already received, and then stop */
+          active = FALSE;
+        }
 
-        JsonObject_destroy(&(json_request));
-        JsonObject_destroy(&(json_response));
-      }
-      else if (JSON_STREAM_STATUS__NO_MORE == byte_stream_status)
-      {
-        active = FALSE;
+        do
+        {
+          byte_stream_status = JsonInputBuffer_nextMessage(
+            &(input),
+            &(json_stream));
+
+          if (JSON_STREAM_STATUS__VALID == byte_stream_status)
+          {
+            JsonArena_attach(&(json_arena));
+
+            WebCard_handleRequest(
+              &(json_stream),
+              &(request),
+              &(database),
+              &(results),
+              &(output));
+
+            WebCardRequest_destroy(&(request));
+
+            JsonArena_attach(NULL);
+            JsonArena_reset(&(json_arena));
+          }
+          else if (JSON_STREAM_STATUS__NO_MORE == byte_stream_status)
+          {
+            active = FALSE;
+          }
+        }
+        while ((JSON_STREAM_STATUS__VALID == byte_stream_status) ||
+          (JSON_STREAM_STATUS__INVALID == byte_stream_status));
+
+        JsonInputBuffer_trim(&(input), WEBCARD_BUFFER__MAX_RETAINED_SIZE);
       }
     }
+
+    /* 4) Send everything that was queued during this iteration */
+    /* (including the requests completed by the Reader Workers) */
+
+    if (has_results)
+    {
+      SCardWorkerResults_moveTo(&(results), &(output));
+      SCardWorkerResults_collectRetired(&(results), FALSE);
+    }
+
+    JsonOutputQueue_flushToStandardOutput(&(output));
+
+    JsonOutputQueue_trim(&(output), WEBCARD_BUFFER__MAX_RETAINED_SIZE);
   }
 
+  JsonOutputQueue_destroy(&(output));
+  JsonArena_destroy(&(json_arena));
+  JsonInputBuffer_destroy(&(input));
+
+  TimerHeap_destroy(&(timers));
+
+  if (has_watcher)
+  {
+    SCardWatcher_destroy(&(watcher));
+  }
+
+  /* Reader Workers are stopped together with the Database */
+
   WebCard_close(&(database), context);
+
+  if (has_results)
+  {
+    SCardWorkerResults_collectRetired(&(results), TRUE);
+    SCardWorkerResults_destroy(&(results));
+  }
+
+  if (has_wake_event)
+  {
+    OSSpecific_destroyEvent(&(wake_event));
+  }
 }
 
 /**************************************************************/
@@ -404,117 +616,136 @@ WebCard_close(
 VOID
 WebCard_handleRequest(
   _Inout_ JsonByteStream *jsonStream,
-  _Out_ JsonObject *jsonRequest,
-  _Out_ JsonObject *jsonResponse,
-  _In_ const SCardReaderDB *database,
-  _In_ const SCARDCONTEXT context)
+  _Out_ WebCardRequest *request,
+  _Inout_ SCardReaderDB *database,
+  _Inout_ SCardWorkerResults *results,
+  _Inout_ JsonOutputQueue *output)
 {
   BOOL test_bool;
-  JsonValue json_value;
+  JsonWriter json_writer;
+  JsonWriterMark json_mark;
   UTF8String utf8_string;
-  size_t command;
+  size_t reader_index;
+  SCardWorker *worker;
+  SCardWorkerJob *job = NULL;
 
-  /* Initialize JSON response object */
+  /* Decode the WebCard Request in a single pass */
   /* (it will be destroyed by caller) */
 
-  JsonObject_init(jsonResponse);
-
-  /* Initialize and load JSON request object */
-  /* Destroy `jsonStream` after parsing the JSON object */
-
-  test_bool = JsonObject_parse(
-    &(jsonRequest),
-    FALSE,
+  test_bool = WebCardRequest_parse(
+    request,
     jsonStream);
 
-  JsonByteStream_destroy(jsonStream);
-
-  if (!test_bool)
+  #if defined(_DEBUG)
   {
-    #if defined(_DEBUG)
+    if (!test_bool)
+    {
       OSSpecific_writeDebugMessage(
         "{JSON Request} parsing error!");
-    #endif
-
-    return;
+    }
+    else if (0 != request->invalidKeys)
+    {
+      OSSpecific_writeDebugMessage(
+        "{JSON Request} unexpected value types (keys: 0x%04X)!",
+        request->invalidKeys);
+    }
   }
+  #endif
 
-  /* Try to find the "i" key (unique message identifier) */
-
-  test_bool = JsonObject_getValue(
-    jsonRequest,
-    &(json_value),
-    "i");
+  /* A malformed request, or a known key with a value of unexpected type, */
+  /* is answered as incomplete (if the "i" key was read before the error), */
+  /* so that a JavaScript Promise won't hang */
 
-  if (!test_bool || (JSON_VALUE_TYPE__STRING != json_value.type))
+  if ((!test_bool) || (0 != request->invalidKeys))
   {
+    if (WebCard_beginResponse(&(json_writer), output, request))
+    {
+      WebCard_markIncomplete(&(json_writer));
+      JsonWriter_finish(&(json_writer));
+    }
+
     return;
   }
 
-  /* Try to append the "i" key to JSON response */
-
-  test_bool = JsonObject_appendKeyValue(
-    jsonResponse,
-    "i",
-    &(json_value));
+  /* Make sure that the "c" key (request command) was found */
 
-  if (!test_bool) { return; }
-
-  /* Try to find the "c" key (request command) */
+  if (0 == (WEBCARD_REQUEST_KEY__COMMAND & request->keys))
+  {
+    return;
+  }
 
-  test_bool = JsonObject_getValue(
-    jsonRequest,
-    &(json_value),
-    "c");
+  /* Start writing the JSON Response straight into the output queue, */
+  /* with the "i" key (unique message identifier) */
 
-  if (!test_bool || (JSON_VALUE_TYPE__NUMBER != json_value.type))
+  if (!WebCard_beginResponse(&(json_writer), output, request))
   {
     return;
   }
 
-  /* Handle requested command */
+  JsonWriter_mark(&(json_writer), &(json_mark));
 
-  command = (size_t) (((FLOAT *) json_value.value)[0]);
+  /* Handle requested command */
 
-  switch (command)
+  switch (request->command)
   {
     case WEBCARD_COMMAND__LIST_READERS:
     {
-      test_bool = WebCard_pushReadersListToJsonResponse(
-        jsonResponse,
-        database);
+      test_bool = WebCard_pushReadersListToJsonWriter(
+        database,
+        &(json_writer));
 
       break;
     }
 
     case WEBCARD_COMMAND__CONNECT:
+    case WEBCARD_COMMAND__DISCONNECT:
+    case WEBCARD_COMMAND__TRANSCEIVE:
+    case WEBCARD_COMMAND__TRANSCEIVE_BATCH:
+    case WEBCARD_COMMAND__RUN_SCRIPT:
     {
-      test_bool = WebCard_tryConnectingToReader(
-        jsonRequest,
-        jsonResponse,
+      /* Pass the request to the Reader Worker, which will respond */
+      /* later (in order with other requests for the same reader) */
+
+      test_bool = WebCard_getReaderIndex(
+        request,
         database,
-        context);
+        &(reader_index));
 
-      break;
-    }
+      if (!test_bool) { break; }
 
-    case WEBCARD_COMMAND__DISCONNECT:
-    {
-      test_bool = WebCard_tryDisconnectingFromReader(
-        jsonRequest,
-        database);
+      worker = SCardReaderDB_getWorker(database, reader_index, results);
 
-      /* "Empty" response (JSON object containing the "i" key only) */
-      /* will be required to resolve a "JavaScript Promise" */
-      break;
+      if (NULL == worker)
+      {
+        test_bool = FALSE;
+        break;
+      }
+
+      job = SCardWorkerJob_create(
+        request->command,
+        request,
+        &(database->states[reader_index]));
+
+      if (NULL == job)
+      {
+        test_bool = FALSE;
+        break;
+      }
+
+      SCardWorker_pushJob(worker, job);
+
+      JsonWriter_discard(&(json_writer));
+
+      return;
     }
 
-    case WEBCARD_COMMAND__TRANSCEIVE:
+    case WEBCARD_COMMAND__CANCEL:
     {
-      test_bool = WebCard_transmitAndReceive(
-        jsonRequest,
-        jsonResponse,
-        database);
+      test_bool = WebCard_cancelRequest(
+        request,
+        &(json_writer),
+        database,
+        &(job));
 
       break;
     }
@@ -523,13 +754,8 @@ WebCard_handleRequest(
     {
       UTF8String_makeTemporary(&(utf8_string), WEBCARD_VERSION);
 
-      json_value.type = JSON_VALUE_TYPE__STRING;
-      json_value.value = &(utf8_string);
-
-      test_bool = JsonObject_appendKeyValue(
-        jsonResponse,
-        "verNat",
-        &(json_value));
+      test_bool = JsonWriter_key(&(json_writer), "verNat") &&
+        JsonWriter_string(&(json_writer), &(utf8_string));
 
       break;
     }
@@ -545,212 +771,305 @@ WebCard_handleRequest(
 
   if (!test_bool)
   {
-    /* Append an optional key-value "incomplete=true" */
-
-    json_value.type = JSON_VALUE_TYPE__TRUE;
-    json_value.value = NULL;
-
-    JsonObject_appendKeyValue(jsonResponse, "incomplete", &(json_value));
+    JsonWriter_rollback(&(json_writer), &(json_mark));
+    WebCard_markIncomplete(&(json_writer));
   }
 
-  /* Stringify JSON response and send it through the STDOUT stream */
+  /* Complete the JSON response in the STDOUT queue */
 
-  UTF8String_init(&(utf8_string));
+  JsonWriter_finish(&(json_writer));
 
-  test_bool = JsonObject_toString(jsonResponse, &(utf8_string));
+  /* A request cancelled before it has started is answered right away */
 
-  if (test_bool)
+  if (NULL != job)
   {
-    UTF8String_writeToStandardOutput(&(utf8_string));
-  }
+    if (WebCard_beginResponse(&(json_writer), output, &(job->request)))
+    {
+      WebCard_markIncomplete(&(json_writer));
+      WebCard_markCancelled(&(json_writer));
+      JsonWriter_finish(&(json_writer));
+    }
 
-  UTF8String_destroy(&(utf8_string));
+    SCardWorkerJob_free(job);
+  }
 }
 
 /**************************************************************/
 
 BOOL
-WebCard_pushReaderNameToJsonString(
-  _In_ const SCARD_READERSTATE *readerState,
-  _Out_ UTF8String *resultReaderName)
+WebCard_beginResponse(
+  _Out_ JsonWriter *writer,
+  _Inout_ JsonOutputQueue *output,
+  _In_ const WebCardRequest *request)
 {
   BOOL test_bool;
 
-  #ifdef _UNICODE
-    UTF16String utf16_reader_name;
-  #endif
-
-  UTF8String_init(resultReaderName);
-
-  #ifdef _UNICODE
+  if (!JsonWriter_begin(writer, output))
   {
-    UTF16String_init(&(utf16_reader_name));
+    return FALSE;
+  }
 
-    test_bool = UTF16String_pushText(
-      &(utf16_reader_name),
-      readerState->szReader,
-      0);
+  /* Try to write the "i" key (unique message identifier) */
+  /* to JSON response */
 
-    if (test_bool)
-    {
-      test_bool = UTF16String_toUTF8(
-        &(utf16_reader_name),
-        resultReaderName);
-    }
+  test_bool = (0 != (WEBCARD_REQUEST_KEY__ID & request->keys)) &&
+    JsonWriter_key(writer, "i") &&
+    JsonWriter_string(writer, &(request->id));
 
-    UTF16String_destroy(&(utf16_reader_name));
-  }
-  #else
+  if (!test_bool)
   {
-    test_bool = UTF8String_pushText(
-      resultReaderName,
-      readerState->szReader,
-      0);
+    JsonWriter_discard(writer);
   }
-  #endif
 
   return test_bool;
 }
 
 /**************************************************************/
 
+VOID
+WebCard_markIncomplete(
+  _Inout_ JsonWriter *writer)
+{
+  /* Append an optional key-value "incomplete=true" */
+
+  JsonWriter_key(writer, "incomplete");
+  JsonWriter_boolean(writer, TRUE);
+}
+
+/**************************************************************/
+
+VOID
+WebCard_markCancelled(
+  _Inout_ JsonWriter *writer)
+{
+  /* Append an optional key-value "cancelled=true" */
+
+  JsonWriter_key(writer, "cancelled");
+  JsonWriter_boolean(writer, TRUE);
+}
+
+/**************************************************************/
+
 BOOL
-WebCard_pushReaderNameToJsonArray(
-  _In_ const SCARD_READERSTATE *readerState,
-  _Inout_ JsonArray *jsonArray)
+WebCard_cancelRequest(
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardReaderDB *database,
+  _Out_ SCardWorkerJob **cancelledJobRef)
 {
-  BOOL test_bool;
-  JsonValue json_value;
-  UTF8String utf8_reader_name;
+  int cancel_result = WEBCARD_CANCEL__NOT_FOUND;
+  int i;
 
-  test_bool = WebCard_pushReaderNameToJsonString(
-    readerState,
-    &(utf8_reader_name));
+  cancelledJobRef[0] = NULL;
 
-  if (!test_bool)
+  /* Make sure that the "t" key (identifier of the target request) */
+  /* was found */
+
+  if (0 == (WEBCARD_REQUEST_KEY__TARGET & request->keys))
   {
-    UTF8String_destroy(&(utf8_reader_name));
+    #if defined(_DEBUG)
+    {
+      OSSpecific_writeDebugMessage(
+        "{WebCard::cancelRequest} failed: " \
+        "missing \"t\" key!"
+      );
+    }
+    #endif
+
     return FALSE;
   }
 
-  /* Put "Reader Name" at the end of given array */
+  /* Look for the request in every Reader Worker */
+  /* (a request that has not started yet is returned to the caller) */
 
-  json_value.type = JSON_VALUE_TYPE__STRING;
-  json_value.value = &(utf8_reader_name);
+  for (i = 0; i < database->count; i++)
+  {
+    if (NULL == database->workers[i]) { continue; }
 
-  test_bool = JsonArray_append(jsonArray, &(json_value));
+    cancel_result = SCardWorker_cancelJob(
+      database->workers[i],
+      &(request->target),
+      cancelledJobRef);
 
-  UTF8String_destroy(&(utf8_reader_name));
+    if (WEBCARD_CANCEL__NOT_FOUND != cancel_result)
+    {
+      break;
+    }
+  }
 
-  return test_bool;
+  /* Add key "d" (was the request found?) */
+
+  return JsonWriter_key(writer, "d") &&
+    JsonWriter_boolean(writer, (WEBCARD_CANCEL__NOT_FOUND != cancel_result));
 }
 
 /**************************************************************/
 
-BOOL
-WebCard_pushReaderNameToJsonObject(
-  _In_ const SCARD_READERSTATE *readerState,
-  _Inout_ JsonObject *jsonObject,
-  _In_ LPCSTR key)
+VOID
+WebCard_runJob(
+  _Inout_ SCardWorker *worker,
+  _Inout_ SCardWorkerJob *job,
+  _Inout_ JsonWriter *writer)
 {
   BOOL test_bool;
-  JsonValue json_value;
-  UTF8String utf8_reader_name;
+  JsonWriterMark json_mark;
 
-  test_bool = WebCard_pushReaderNameToJsonString(
-    readerState,
-    &(utf8_reader_name));
+  JsonWriter_mark(writer, &(json_mark));
 
-  if (!test_bool)
+  /* Each Reader Worker uses its own Smart Card Context */
+  /* (established by the worker thread) */
+
+  if ((0 == worker->context) && (WEBCARD_COMMAND__NONE != job->command))
   {
-    UTF8String_destroy(&(utf8_reader_name));
-    return FALSE;
+    WebCard_markIncomplete(writer);
+    return;
   }
 
-  /* Add "Reader Name" under a specified key */
+  switch (job->command)
+  {
+    case WEBCARD_COMMAND__CONNECT:
+    {
+      test_bool = WebCard_tryConnectingToReader(
+        &(job->request),
+        writer,
+        worker,
+        &(job->readerState));
 
-  json_value.type = JSON_VALUE_TYPE__STRING;
-  json_value.value = &(utf8_reader_name);
+      break;
+    }
 
-  test_bool = JsonObject_appendKeyValue(
-    jsonObject,
-    key,
-    &(json_value));
+    case WEBCARD_COMMAND__DISCONNECT:
+    {
+      test_bool = WebCard_tryDisconnectingFromReader(worker);
 
-  UTF8String_destroy(&(utf8_reader_name));
+      /* "Empty" response (JSON object containing the "i" key only) */
+      /* will be required to resolve a "JavaScript Promise" */
+      break;
+    }
 
-  return test_bool;
+    case WEBCARD_COMMAND__TRANSCEIVE:
+    {
+      test_bool = WebCard_transmitAndReceive(
+        &(job->request),
+        writer,
+        worker);
+
+      break;
+    }
+
+    case WEBCARD_COMMAND__TRANSCEIVE_BATCH:
+    {
+      test_bool = WebCard_transmitBatch(
+        &(job->request),
+        writer,
+        worker);
+
+      break;
+    }
+
+    case WEBCARD_COMMAND__RUN_SCRIPT:
+    {
+      test_bool = WebCard_runScript(
+        &(job->request),
+        writer,
+        worker);
+
+      break;
+    }
+
+    default:
+    {
+      /* Card removed: invalidate connection (no response) */
+
+      SCardConnection_close(&(worker->connection));
+      return;
+    }
+  }
+
+  /* Partial results are dropped */
+
+  if (!test_bool)
+  {
+    JsonWriter_rollback(writer, &(json_mark));
+    WebCard_markIncomplete(writer);
+  }
 }
 
 /**************************************************************/
 
 BOOL
-WebCard_convertReaderStateToJsonObject(
+WebCard_pushReaderNameToJsonString(
   _In_ const SCARD_READERSTATE *readerState,
-  _Out_ JsonObject *jsonReaderObject)
+  _Out_ UTF8String *resultReaderName)
 {
   BOOL test_bool;
 
-  /* Initialize JSON reader object */
-  /* (it will be destroyed by caller) */
+  #ifdef _UNICODE
+    UTF16String utf16_reader_name;
+  #endif
 
-  JsonObject_init(jsonReaderObject);
+  UTF8String_init(resultReaderName);
 
-  /* Add key "n" (Reader Name) */
+  #ifdef _UNICODE
+  {
+    UTF16String_init(&(utf16_reader_name));
 
-  test_bool = WebCard_pushReaderNameToJsonObject(
-    readerState,
-    jsonReaderObject,
-    "n");
+    test_bool = UTF16String_pushText(
+      &(utf16_reader_name),
+      readerState->szReader,
+      0);
 
-  if (!test_bool) { return FALSE; }
+    if (test_bool)
+    {
+      test_bool = UTF16String_toUTF8(
+        &(utf16_reader_name),
+        resultReaderName);
+    }
 
-  /* Add key "a" (card Answer To Reset) */
+    UTF16String_destroy(&(utf16_reader_name));
+  }
+  #else
+  {
+    test_bool = UTF8String_pushText(
+      resultReaderName,
+      readerState->szReader,
+      0);
+  }
+  #endif
 
-  return WebCard_pushReaderAtrToJsonObject(
-    readerState,
-    jsonReaderObject,
-    "a");
+  return test_bool;
 }
 
 /**************************************************************/
 
 BOOL
-WebCard_pushReaderAtrToJsonObject(
+WebCard_pushReaderNameToJsonArray(
   _In_ const SCARD_READERSTATE *readerState,
-  _Inout_ JsonObject *jsonObject,
-  _In_ LPCSTR key)
+  _Inout_ JsonArray *jsonArray)
 {
   BOOL test_bool;
-  JsonValue json_value;
-  UTF8String utf8_string;
-
-  /* Copy Smart Card "ATR" identifier (bytearray to text) */
-
-  UTF8String_init(&(utf8_string));
+  JsonValue json_value;
+  UTF8String utf8_reader_name;
 
-  test_bool = UTF8String_pushBytesAsHex(
-    &(utf8_string),
-    readerState->cbAtr,
-    readerState->rgbAtr);
+  test_bool = WebCard_pushReaderNameToJsonString(
+    readerState,
+    &(utf8_reader_name));
 
   if (!test_bool)
   {
-    UTF8String_destroy(&(utf8_string));
+    UTF8String_destroy(&(utf8_reader_name));
     return FALSE;
   }
 
-  /* Add "card Answer To Reset" under a specified key */
+  /* Put "Reader Name" at the end of given array */
+  /* (the array takes over the string buffer) */
 
   json_value.type = JSON_VALUE_TYPE__STRING;
-  json_value.value = &(utf8_string);
+  json_value.string = utf8_reader_name;
 
-  test_bool = JsonObject_appendKeyValue(
-    jsonObject,
-    key,
-    &(json_value));
+  test_bool = JsonArray_appendTake(jsonArray, &(json_value));
 
-  UTF8String_destroy(&(utf8_string));
+  JsonValue_destroy(&(json_value));
 
   return test_bool;
 }
@@ -758,109 +1077,95 @@ WebCard_pushReaderAtrToJsonObject(
 /**************************************************************/
 
 BOOL
-WebCard_convertReaderStatesToJsonArray(
-  _In_ const SCardReaderDB *database,
-  _Out_ JsonArray *jsonReadersArray)
+WebCard_pushReaderNameToJsonWriter(
+  _In_ const SCARD_READERSTATE *readerState,
+  _Inout_ JsonWriter *writer,
+  _In_ LPCSTR key)
 {
   BOOL test_bool;
-  JsonValue json_value;
-  JsonObject json_reader_object;
-
-  json_value.type = JSON_VALUE_TYPE__OBJECT;
-  json_value.value = &(json_reader_object);
-
-  /* Initialize JSON reader object */
-  /* (it will be destroyed by caller) */
+  UTF8String utf8_reader_name;
 
-  JsonArray_init(jsonReadersArray);
+  test_bool = WebCard_pushReaderNameToJsonString(
+    readerState,
+    &(utf8_reader_name));
 
-  /* Enumerate Smart Card Readers */
+  /* Write "Reader Name" under a specified key */
 
-  for (size_t i = 0; i < database->count; i++)
+  if (test_bool)
   {
-    test_bool = WebCard_convertReaderStateToJsonObject(
-      &(database->states[i]),
-      &(json_reader_object));
+    test_bool = JsonWriter_key(writer, key) &&
+      JsonWriter_string(writer, &(utf8_reader_name));
+  }
 
-    if (test_bool)
-    {
-      test_bool = JsonArray_append(
-        jsonReadersArray,
-        &(json_value));
-    }
+  UTF8String_destroy(&(utf8_reader_name));
 
-    JsonObject_destroy(&(json_reader_object));
+  return test_bool;
+}
 
-    if (!test_bool)
-    {
-      return FALSE;
-    }
-  }
+/**************************************************************/
 
-  return TRUE;
+BOOL
+WebCard_pushReaderAtrToJsonWriter(
+  _In_ const SCARD_READERSTATE *readerState,
+  _Inout_ JsonWriter *writer,
+  _In_ LPCSTR key)
+{
+  /* Write Smart Card "ATR" identifier (bytearray to text) */
+  /* under a specified key */
+
+  return JsonWriter_key(writer, key) &&
+    JsonWriter_hex(writer, readerState->cbAtr, readerState->rgbAtr);
 }
 
 /**************************************************************/
 
 BOOL
-WebCard_pushReadersListToJsonResponse(
-  _Inout_ JsonObject *jsonResponse,
-  _In_ const SCardReaderDB *database)
+WebCard_pushReadersListToJsonWriter(
+  _In_ const SCardReaderDB *database,
+  _Inout_ JsonWriter *writer)
 {
   BOOL test_bool;
-  JsonArray json_readers_array;
-  JsonValue json_value;
 
-  test_bool = WebCard_convertReaderStatesToJsonArray(
-    database,
-    &(json_readers_array));
+  test_bool = JsonWriter_key(writer, "d") &&
+    JsonWriter_beginArray(writer);
 
-  if (!test_bool)
+  /* Enumerate Smart Card Readers */
+
+  for (size_t i = 0; test_bool && (i < database->count); i++)
   {
-    JsonArray_destroy(&(json_readers_array));
-    return FALSE;
+    /* Reader Name ("n") and card Answer To Reset ("a") */
+
+    test_bool = JsonWriter_beginObject(writer) &&
+      WebCard_pushReaderNameToJsonWriter(
+        &(database->states[i]),
+        writer,
+        "n") &&
+      WebCard_pushReaderAtrToJsonWriter(
+        &(database->states[i]),
+        writer,
+        "a") &&
+      JsonWriter_end(writer);
   }
 
-  json_value.type = JSON_VALUE_TYPE__ARRAY;
-  json_value.value = &(json_readers_array);
-
-  test_bool = JsonObject_appendKeyValue(
-    jsonResponse,
-    "d",
-    &(json_value));
-
-  JsonArray_destroy(&(json_readers_array));
-  return test_bool;
+  return test_bool && JsonWriter_end(writer);
 }
 
 /**************************************************************/
 
 BOOL
-WebCard_tryConnectingToReader(
-  _In_ const JsonObject *jsonRequest,
-  _Inout_ JsonObject *jsonResponse,
+WebCard_getReaderIndex(
+  _In_ const WebCardRequest *request,
   _In_ const SCardReaderDB *database,
-  _In_ const SCARDCONTEXT context)
+  _Out_ size_t *readerIndexRef)
 {
-  BOOL test_bool;
-  size_t reader_index;
-  const SCARD_READERSTATE *readerState;
-  PCSC_DWORD share_mode = SCARD_SHARE_SHARED;
-  JsonValue json_value;
-
-  /* Try to find the "r" key (reader index) */
-
-  test_bool = JsonObject_getValue(
-    jsonRequest,
-    &(json_value),
-    "r");
+  /* Make sure that the "r" key (reader index) was found */
 
-  if (!test_bool || (JSON_VALUE_TYPE__NUMBER != json_value.type))
+  if (0 == (WEBCARD_REQUEST_KEY__READER & request->keys))
   {
     #if defined(_DEBUG)
     {
       OSSpecific_writeDebugMessage(
-        "{WebCard::tryConnectingToReader} failed: " \
+        "{WebCard::getReaderIndex} failed: " \
         "missing \"r\" key!"
       );
     }
@@ -869,14 +1174,14 @@ WebCard_tryConnectingToReader(
     return FALSE;
   }
 
-  reader_index = (size_t) (((FLOAT *) json_value.value)[0]);
+  readerIndexRef[0] = request->reader;
 
-  if (reader_index >= database->count)
+  if (readerIndexRef[0] >= database->count)
   {
     #if defined(_DEBUG)
     {
       OSSpecific_writeDebugMessage(
-        "{WebCard::tryConnectingToReader} failed: " \
+        "{WebCard::getReaderIndex} failed: " \
         "invalid reader index!"
       );
     }
@@ -885,35 +1190,36 @@ WebCard_tryConnectingToReader(
     return FALSE;
   }
 
-  /* Try to find the "p" key (optional share mode param) */
+  return TRUE;
+}
 
-  test_bool = JsonObject_getValue(
-    jsonRequest,
-    &(json_value),
-    "p");
+/**************************************************************/
 
-  if (test_bool && (JSON_VALUE_TYPE__NUMBER == json_value.type))
-  {
-    share_mode = (PCSC_DWORD) (((FLOAT *) json_value.value)[0]);
-  }
+BOOL
+WebCard_tryConnectingToReader(
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardWorker *worker,
+  _In_ const SCARD_READERSTATE *readerState)
+{
+  BOOL test_bool;
 
   /* Try to open a connection to active Smart Card */
-
-  readerState = &(database->states[reader_index]);
+  /* (the "p" key is optional, `SCARD_SHARE_SHARED` by default) */
 
   test_bool = SCardConnection_open(
-    &(database->connections[reader_index]),
-    context,
-    readerState->szReader,
-    share_mode);
+    &(worker->connection),
+    worker->context,
+    worker->readerName,
+    request->shareMode);
 
   if (!test_bool) { return FALSE; }
 
   /* Add key "d" (card Answer To Reset) */
 
-  return WebCard_pushReaderAtrToJsonObject(
+  return WebCard_pushReaderAtrToJsonWriter(
     readerState,
-    jsonResponse,
+    writer,
     "d");
 }
 
@@ -921,27 +1227,39 @@ WebCard_tryConnectingToReader(
 
 BOOL
 WebCard_tryDisconnectingFromReader(
-  _In_ const JsonObject *jsonRequest,
-  _In_ const SCardReaderDB *database)
+  _Inout_ SCardWorker *worker)
+{
+  /* Try to close a connection to active Smart Card */
+
+  return SCardConnection_close(
+    &(worker->connection));
+}
+
+/**************************************************************/
+
+BOOL
+WebCard_transmitAndReceive(
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardWorker *worker)
 {
   BOOL test_bool;
-  size_t reader_index;
-  JsonValue json_value;
+  size_t input_bytes_length;
+  UTF8String *utf8_apdu_response;
+  uint32_t encoding;
+  SCardConnection *connection;
 
-  /* Try to find the "r" key (reader index) */
+  /* Make sure that a connection to the Smart Card is still active */
 
-  test_bool = JsonObject_getValue(
-    jsonRequest,
-    &(json_value),
-    "r");
+  connection = &(worker->connection);
 
-  if (!test_bool || (JSON_VALUE_TYPE__NUMBER != json_value.type))
+  if (0 == connection->handle)
   {
     #if defined(_DEBUG)
     {
       OSSpecific_writeDebugMessage(
-        "{WebCard::tryDisconnectingFromReader} failed: " \
-        "missing \"r\" key!"
+        "{WebCard::transmitAndReceive} failed: " \
+        "no connection!"
       );
     }
     #endif
@@ -949,59 +1267,90 @@ WebCard_tryDisconnectingFromReader(
     return FALSE;
   }
 
-  reader_index = (size_t) (((FLOAT *) json_value.value)[0]);
+  /* Make sure that the "a" key (Application Protocol Data Unit) */
+  /* holds a hex-string (or the "b" key holds a Base64 string) */
 
-  if (reader_index >= database->count)
+  if (JSON_VALUE_TYPE__STRING != request->data.type)
   {
-    #if defined(_DEBUG)
-    {
-      OSSpecific_writeDebugMessage(
-        "{WebCard::tryDisconnectingFromReader} failed: " \
-        "invalid reader index!"
-      );
-    }
-    #endif
-
     return FALSE;
   }
 
-  /* Try to close a connection to active Smart Card */
+  encoding = (WEBCARD_REQUEST_KEY__BASE64_DATA & request->keys) ?
+    SCARD_APDU_ENCODING__BASE64 :
+    SCARD_APDU_ENCODING__HEX;
 
-  return SCardConnection_close(
-    &(database->connections[reader_index]));
+  /* Prepare input and output byte buffers */
+  /* (both are owned by the connection, and reused for every APDU) */
+
+  test_bool = SCardConnection_decodeApdu(
+    connection,
+    &(request->data.string),
+    encoding,
+    &(input_bytes_length)) &&
+    SCardConnection_assertOutput(connection);
+
+  if (!test_bool) { return FALSE; }
+
+  /* Add key "d" (Smart Card APDU response), which is appended */
+  /* directly to the output while transmitting and receiving */
+  /* (the caller drops it on failure) */
+
+  test_bool = JsonWriter_key(writer, "d");
+
+  utf8_apdu_response = test_bool ?
+    JsonWriter_openString(writer) :
+    NULL;
+
+  test_bool = (NULL != utf8_apdu_response) &&
+    SCardConnection_transceiveMultiple(
+      connection,
+      utf8_apdu_response,
+      encoding,
+      request->handling,
+      connection->input,
+      input_bytes_length,
+      connection->output,
+      MAX_APDU_SIZE,
+      NULL);
+
+  if (test_bool)
+  {
+    test_bool = JsonWriter_closeString(writer);
+  }
+
+  return test_bool;
 }
 
 /**************************************************************/
 
 BOOL
-WebCard_transmitAndReceive(
-  _In_ const JsonObject *jsonRequest,
-  _Inout_ JsonObject *jsonResponse,
-  _In_ const SCardReaderDB *database)
+WebCard_transmitBatch(
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardWorker *worker)
 {
   BOOL test_bool;
-  size_t reader_index;
-  LPBYTE input_bytes;
+  PCSC_LONG pcscResult;
   size_t input_bytes_length;
-  LPBYTE output_bytes;
-  JsonValue json_value;
-  UTF8String utf8_hex_apdu_response;
+  const JsonArray *json_apdus;
+  UTF8String *utf8_apdu_response;
+  uint16_t status_word;
+  uint32_t encoding;
+  BOOL stopped;
   SCardConnection *connection;
+  size_t i;
 
-  /* Try to find the "r" key (reader index) */
+  /* Make sure that a connection to the Smart Card is still active */
 
-  test_bool = JsonObject_getValue(
-    jsonRequest,
-    &(json_value),
-    "r");
+  connection = &(worker->connection);
 
-  if (!test_bool || (JSON_VALUE_TYPE__NUMBER != json_value.type))
+  if (0 == connection->handle)
   {
     #if defined(_DEBUG)
     {
       OSSpecific_writeDebugMessage(
-        "{WebCard::transmitAndReceive} failed: " \
-        "missing \"r\" key!"
+        "{WebCard::transmitBatch} failed: " \
+        "no connection!"
       );
     }
     #endif
@@ -1009,32 +1358,129 @@ WebCard_transmitAndReceive(
     return FALSE;
   }
 
-  reader_index = (size_t) (((FLOAT *) json_value.value)[0]);
+  /* Make sure that the "a" (or "b") key holds an array of APDUs */
+  /* (the "s" key, "stop on error" flag, is optional) */
+
+  if (JSON_VALUE_TYPE__ARRAY != request->data.type)
+  {
+    return FALSE;
+  }
+
+  encoding = (WEBCARD_REQUEST_KEY__BASE64_DATA & request->keys) ?
+    SCARD_APDU_ENCODING__BASE64 :
+    SCARD_APDU_ENCODING__HEX;
+
+  json_apdus = &(request->data.array);
+
+  if (!SCardConnection_assertOutput(connection))
+  {
+    return FALSE;
+  }
+
+  /* No other application can use the card until the batch is done */
 
-  if (reader_index >= database->count)
+  pcscResult = SCardBeginTransaction(connection->handle);
+
+  if (SCARD_S_SUCCESS != pcscResult)
   {
     #if defined(_DEBUG)
     {
       OSSpecific_writeDebugMessage(
-        "{WebCard::transmitAndReceive} failed: " \
-        "invalid reader index!"
-      );
+        "{SCardBeginTransaction} failed: 0x%08X (%s)",
+        (uint32_t) pcscResult,
+        WebCard_errorLookup(pcscResult));
     }
     #endif
 
     return FALSE;
   }
 
+  /* Add key "d" (Smart Card APDU responses), */
+  /* filled while transmitting and receiving */
+
+  test_bool = JsonWriter_key(writer, "d") &&
+    JsonWriter_beginArray(writer);
+
+  for (i = 0; test_bool && (i < json_apdus->count); i++)
+  {
+    /* Stop between APDUs if the request was cancelled */
+
+    if (SCardWorker_isCancelled(worker))
+    {
+      break;
+    }
+
+    if (JSON_VALUE_TYPE__STRING != json_apdus->values[i].type)
+    {
+      test_bool = FALSE;
+      break;
+    }
+
+    /* Prepare input byte buffer */
+
+    test_bool = SCardConnection_decodeApdu(
+      connection,
+      &(json_apdus->values[i].string),
+      encoding,
+      &(input_bytes_length));
+
+    if (!test_bool) { break; }
+
+    /* Transmit and receive (straight into the output) */
+
+    utf8_apdu_response = JsonWriter_openString(writer);
+
+    test_bool = (NULL != utf8_apdu_response) &&
+      SCardConnection_transceiveMultiple(
+        connection,
+        utf8_apdu_response,
+        encoding,
+        request->handling,
+        connection->input,
+        input_bytes_length,
+        connection->output,
+        MAX_APDU_SIZE,
+        &(status_word));
+
+    if (!test_bool) { break; }
+
+    /* Check the Status Word (last two bytes of the response) */
+
+    stopped = request->stopOnError && (0x9000 != status_word);
+
+    test_bool = JsonWriter_closeString(writer);
+
+    if (stopped) { break; }
+  }
+
+  SCardEndTransaction(connection->handle, SCARD_LEAVE_CARD);
+
+  return test_bool && JsonWriter_end(writer);
+}
+
+/**************************************************************/
+
+BOOL
+WebCard_runScript(
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardWorker *worker)
+{
+  BOOL test_bool;
+  PCSC_LONG pcscResult;
+  SCardScript script;
+  SCardConnection *connection;
+
   /* Make sure that a connection to the Smart Card is still active */
 
-  connection = &(database->connections[reader_index]);
+  connection = &(worker->connection);
 
   if (0 == connection->handle)
   {
     #if defined(_DEBUG)
     {
       OSSpecific_writeDebugMessage(
-        "{WebCard::transmitAndReceive} failed: " \
+        "{WebCard::runScript} failed: " \
         "no connection!"
       );
     }
@@ -1043,67 +1489,52 @@ WebCard_transmitAndReceive(
     return FALSE;
   }
 
-  /* Try to find the "a" key (Application Protocol Data Unit) */
+  /* Make sure that the "a" key holds an array of script steps */
+  /* (scripts expand variables into hex-strings, so "b" is not allowed) */
 
-  test_bool = JsonObject_getValue(
-    jsonRequest,
-    &(json_value),
-    "a");
-
-  if (!test_bool || (JSON_VALUE_TYPE__STRING != json_value.type))
+  if ((JSON_VALUE_TYPE__ARRAY != request->data.type) ||
+    (0 != (WEBCARD_REQUEST_KEY__BASE64_DATA & request->keys)))
   {
     return FALSE;
   }
 
-  /* Prepare input and output byte buffers */
+  /* No other application can use the card until the script is done */
 
-  test_bool = UTF8String_hexToByteArray(
-    json_value.value,
-    &(input_bytes_length),
-    &(input_bytes));
+  pcscResult = SCardBeginTransaction(connection->handle);
 
-  if (!test_bool)
+  if (SCARD_S_SUCCESS != pcscResult)
   {
-    if (NULL != input_bytes)
+    #if defined(_DEBUG)
     {
-      free(input_bytes);
+      OSSpecific_writeDebugMessage(
+        "{SCardBeginTransaction} failed: 0x%08X (%s)",
+        (uint32_t) pcscResult,
+        WebCard_errorLookup(pcscResult));
     }
-    return FALSE;
-  }
+    #endif
 
-  output_bytes = malloc(sizeof(BYTE) * MAX_APDU_SIZE);
-  if (NULL == output_bytes)
-  {
-    free(input_bytes);
     return FALSE;
   }
 
-  /* Transmit and receive */
+  SCardScript_init(&(script));
 
-  UTF8String_init(&(utf8_hex_apdu_response));
+  test_bool = SCardScript_run(
+    &(script),
+    &(request->data.array),
+    request->handling,
+    worker);
 
-  test_bool = SCardConnection_transceiveMultiple(
-    connection,
-    &(utf8_hex_apdu_response),
-    input_bytes,
-    input_bytes_length,
-    output_bytes,
-    MAX_APDU_SIZE);
+  SCardEndTransaction(connection->handle, SCARD_LEAVE_CARD);
 
   if (test_bool)
   {
-    /* Add key "d" (Smart Card APDU response) */
-
-    json_value.type = JSON_VALUE_TYPE__STRING;
-    json_value.value = &(utf8_hex_apdu_response);
+    /* Add key "d" (script variables) */
 
-    test_bool = JsonObject_appendKeyValue(
-      jsonResponse,
-      "d",
-      &(json_value));
+    test_bool = JsonWriter_key(writer, "d") &&
+      SCardScript_writeVariables(&(script), writer);
   }
 
-  UTF8String_destroy(&(utf8_hex_apdu_response));
+  SCardScript_destroy(&(script));
 
   return test_bool;
 }
@@ -1115,13 +1546,12 @@ WebCard_sendReaderEvent(
   _In_opt_ const SCARD_READERSTATE *readerState,
   _In_ const size_t readerIndex,
   _In_ const int readerEvent,
-  _Out_ JsonObject *jsonResponse,
-  _In_opt_ const JsonArray *jsonEventDetails)
+  _In_opt_ const JsonArray *jsonEventDetails,
+  _Inout_ JsonOutputQueue *output)
 {
   BOOL test_bool;
-  FLOAT test_float;
+  JsonWriter json_writer;
   JsonValue json_value;
-  UTF8String utf8_string;
 
   #if defined(_DEBUG)
   {
@@ -1132,80 +1562,113 @@ WebCard_sendReaderEvent(
   }
   #endif
 
-  /* Initialize JSON response object */
-  /* (it will be destroyed by caller) */
-
-  JsonObject_init(jsonResponse);
+  /* Write the JSON response straight into the STDOUT queue */
 
-  json_value.type = JSON_VALUE_TYPE__NUMBER;
-  json_value.value = &(test_float);
+  if (!JsonWriter_begin(&(json_writer), output)) { return; }
 
   /* Add key "e" (reader event) */
 
-  test_float = (FLOAT) readerEvent;
-
-  test_bool = JsonObject_appendKeyValue(
-    jsonResponse,
-    "e",
-    &(json_value));
+  test_bool = JsonWriter_key(&(json_writer), "e") &&
+    JsonWriter_integer(&(json_writer), readerEvent);
 
-  if (!test_bool) { return; }
-
-  if (NULL != readerState)
+  if (test_bool && (NULL != readerState))
   {
     /* Add key "r" (reader index for reader events) */
 
-    test_float = (FLOAT) readerIndex;
-
-    test_bool = JsonObject_appendKeyValue(
-      jsonResponse,
-      "r",
-      &(json_value));
-
-    if (!test_bool) { return; }
+    test_bool = JsonWriter_key(&(json_writer), "r") &&
+      JsonWriter_integer(&(json_writer), (int64_t) readerIndex);
 
     /* Add key "d" (card Answer To Reset) on CARD INSERT event */
 
-    if (WEBCARD_READER_EVENT__CARD_INSERTION == readerEvent)
+    if (test_bool && (WEBCARD_READER_EVENT__CARD_INSERTION == readerEvent))
     {
-      test_bool = WebCard_pushReaderAtrToJsonObject(
+      test_bool = WebCard_pushReaderAtrToJsonWriter(
         readerState,
-        jsonResponse,
+        &(json_writer),
         "d");
-
-      if (!test_bool) { return; }
     }
   }
-  else
+  else if (test_bool && (NULL != jsonEventDetails))
   {
-    if (NULL != jsonEventDetails)
-    {
-      /* Add key "n" (optional reader names) */
+    /* Add key "n" (optional reader names) */
 
-      json_value.type = JSON_VALUE_TYPE__ARRAY;
-      json_value.value = (void *) jsonEventDetails;
+    json_value.type = JSON_VALUE_TYPE__ARRAY;
+    json_value.array = jsonEventDetails[0];
 
-      test_bool = JsonObject_appendKeyValue(
-        jsonResponse,
-        "n",
-        &(json_value));
+    test_bool = JsonWriter_key(&(json_writer), "n") &&
+      JsonWriter_value(&(json_writer), &(json_value));
+  }
 
-      if (!test_bool) { return; }
-    }
+  /* An incomplete Reader Event is dropped */
+
+  if (!test_bool)
+  {
+    JsonWriter_discard(&(json_writer));
+    return;
   }
 
-  /* Stringify JSON response and send it through the STDOUT stream */
+  JsonWriter_finish(&(json_writer));
+}
 
-  UTF8String_init(&(utf8_string));
+/**************************************************************/
 
-  test_bool = JsonObject_toString(jsonResponse, &(utf8_string));
+VOID
+WebCard_handleReaderStateChange(
+  _Inout_ SCardReaderDB *database,
+  _In_ const size_t readerIndex,
+  _Inout_ JsonOutputQueue *output)
+{
+  SCARD_READERSTATE *readerState = &(database->states[readerIndex]);
+  SCardWorker *worker = database->workers[readerIndex];
+  SCardWorkerJob *job;
 
-  if (test_bool)
+  if ((NULL != worker) && (worker->ignoreCounter > 0))
+  {
+    worker->ignoreCounter -= 1;
+  }
+  else
   {
-    UTF8String_writeToStandardOutput(&(utf8_string));
+    int reader_event = WEBCARD_READER_EVENT__NONE;
+
+    if ((readerState->dwCurrentState & SCARD_STATE_EMPTY) &&
+      (readerState->dwEventState & SCARD_STATE_PRESENT))
+    {
+      reader_event = WEBCARD_READER_EVENT__CARD_INSERTION;
+    }
+    else if ((readerState->dwCurrentState & SCARD_STATE_PRESENT) &&
+      (readerState->dwEventState & SCARD_STATE_EMPTY))
+    {
+      reader_event = WEBCARD_READER_EVENT__CARD_REMOVAL;
+
+      /* Invalidate connection (after the requests that were */
+      /* already passed to the Reader Worker) */
+
+      if (NULL != worker)
+      {
+        job = SCardWorkerJob_create(
+          WEBCARD_COMMAND__NONE,
+          NULL,
+          readerState);
+
+        if (NULL != job)
+        {
+          SCardWorker_pushJob(worker, job);
+        }
+      }
+    }
+
+    if (WEBCARD_READER_EVENT__NONE != reader_event)
+    {
+      WebCard_sendReaderEvent(
+        readerState,
+        readerIndex,
+        reader_event,
+        NULL,
+        output);
+    }
   }
 
-  UTF8String_destroy(&(utf8_string));
+  readerState->dwCurrentState = (readerState->dwEventState & (~SCARD_STATE_CHANGED));
 }
 
 /**************************************************************/
@@ -1213,10 +1676,9 @@ WebCard_sendReaderEvent(
 VOID
 WebCard_handleStatusChange(
   _Inout_ SCardReaderDB *database,
-  _In_ const SCARDCONTEXT context)
+  _In_ const SCARDCONTEXT context,
+  _Inout_ JsonOutputQueue *output)
 {
-  JsonObject json_response;
-
   PCSC_LONG pcscResult = SCardGetStatusChange(
     context,
     0,
@@ -1229,49 +1691,47 @@ WebCard_handleStatusChange(
 
   for (size_t i = 0; i < database->count; i++)
   {
-    SCARD_READERSTATE *readerState = &(database->states[i]);
-    SCardConnection *connection = &(database->connections[i]);
-
-    if (readerState->dwEventState & SCARD_STATE_CHANGED)
+    if (database->states[i].dwEventState & SCARD_STATE_CHANGED)
     {
-      if (connection->ignoreCounter > 0)
-      {
-        connection->ignoreCounter -= 1;
-      }
-      else
-      {
-        int reader_event = WEBCARD_READER_EVENT__NONE;
+      WebCard_handleReaderStateChange(database, i, output);
+    }
+  }
+}
 
-        if ((readerState->dwCurrentState & SCARD_STATE_EMPTY) &&
-          (readerState->dwEventState & SCARD_STATE_PRESENT))
-        {
-          reader_event = WEBCARD_READER_EVENT__CARD_INSERTION;
-        }
-        else if ((readerState->dwCurrentState & SCARD_STATE_PRESENT) &&
-          (readerState->dwEventState & SCARD_STATE_EMPTY))
-        {
-          reader_event = WEBCARD_READER_EVENT__CARD_REMOVAL;
+/**************************************************************/
 
-          /* Invalidate connection */
-          connection->handle = 0;
-        }
+VOID
+WebCard_handleWatcherEvents(
+  _Inout_ SCardReaderDB *database,
+  _Inout_ SCardWatcher *watcher,
+  _Inout_ JsonOutputQueue *output)
+{
+  SCardWatcherEvent *events;
+  SCARD_READERSTATE *readerState;
+  size_t count;
 
-        if (WEBCARD_READER_EVENT__NONE != reader_event)
-        {
-          WebCard_sendReaderEvent(
-            readerState,
-            i,
-            reader_event,
-            &(json_response),
-            NULL);
-
-          JsonObject_destroy(&(json_response));
-        }
-      }
+  events = SCardWatcher_takeEvents(watcher, &(count));
 
-      readerState->dwCurrentState = (readerState->dwEventState & (~SCARD_STATE_CHANGED));
-    }
+  if (NULL == events) { return; }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    if (events[i].readerIndex >= database->count) { continue; }
+
+    readerState = &(database->states[events[i].readerIndex]);
+
+    readerState->dwEventState = events[i].eventState;
+    readerState->cbAtr = events[i].atrLength;
+
+    memcpy(readerState->rgbAtr, events[i].atr, events[i].atrLength);
+
+    WebCard_handleReaderStateChange(
+      database,
+      events[i].readerIndex,
+      output);
   }
+
+  free(events);
 }
 
 /**************************************************************/
@@ -0,0 +1,590 @@
+/**
+ * @file "native/src/smart_cards/sc_worker.c"
+ * Communication with Smart Card Readers (physical or virtual peripherals).
+ */
+
+#include "smart_cards/smart_cards.h"
+
+/**************************************************************/
+
+BOOL
+SCardWorkerResults_init(
+  _Out_ SCardWorkerResults *results,
+  _In_ os_specific_event_t *wakeEvent)
+{
+  if (!OSSpecific_initMutex(&(results->mutex)))
+  {
+    return FALSE;
+  }
+
+  JsonOutputQueue_init(&(results->queue));
+  results->retired = NULL;
+  results->wakeEvent = wakeEvent;
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+VOID
+SCardWorkerResults_destroy(
+  _Inout_ SCardWorkerResults *results)
+{
+  JsonOutputQueue_destroy(&(results->queue));
+  OSSpecific_destroyMutex(&(results->mutex));
+}
+
+/**************************************************************/
+
+VOID
+SCardWorkerResults_push(
+  _Inout_ SCardWorkerResults *results,
+  _Inout_ JsonOutputQueue *source)
+{
+  OSSpecific_lockMutex(&(results->mutex));
+
+  JsonOutputQueue_pushQueue(&(results->queue), source);
+
+  OSSpecific_unlockMutex(&(results->mutex));
+
+  OSSpecific_signalEvent(results->wakeEvent);
+}
+
+/**************************************************************/
+
+BOOL
+SCardWorkerResults_moveTo(
+  _Inout_ SCardWorkerResults *results,
+  _Inout_ JsonOutputQueue *output)
+{
+  BOOL test_bool;
+
+  OSSpecific_lockMutex(&(results->mutex));
+
+  test_bool = JsonOutputQueue_pushQueue(output, &(results->queue));
+
+  JsonOutputQueue_trim(&(results->queue), WEBCARD_BUFFER__MAX_RETAINED_SIZE);
+
+  OSSpecific_unlockMutex(&(results->mutex));
+
+  return test_bool;
+}
+
+/**************************************************************/
+
+VOID
+SCardWorkerResults_collectRetired(
+  _Inout_ SCardWorkerResults *results,
+  _In_ const BOOL wait)
+{
+  SCardWorker *finished = NULL;
+  SCardWorker **link;
+  SCardWorker *worker;
+
+  /* Unlink the workers that can be joined right away */
+
+  OSSpecific_lockMutex(&(results->mutex));
+
+  link = &(results->retired);
+
+  while (NULL != link[0])
+  {
+    worker = link[0];
+
+    if (wait || worker->finished)
+    {
+      link[0] = worker->nextRetired;
+
+      worker->nextRetired = finished;
+      finished = worker;
+    }
+    else
+    {
+      link = &(worker->nextRetired);
+    }
+  }
+
+  OSSpecific_unlockMutex(&(results->mutex));
+
+  /* Joining is done without the lock: */
+  /* a running worker still pushes its responses */
+
+  while (NULL != finished)
+  {
+    worker = finished;
+    finished = worker->nextRetired;
+
+    SCardWorker_destroy(worker);
+    free(worker);
+  }
+}
+
+/**************************************************************/
+
+SCardWorkerJob *
+SCardWorkerJob_create(
+  _In_ const size_t command,
+  _In_opt_ WebCardRequest *request,
+  _In_ const SCARD_READERSTATE *readerState)
+{
+  BOOL test_bool = TRUE;
+  JsonArena *arena;
+
+  SCardWorkerJob *job = malloc(sizeof(SCardWorkerJob));
+  if (NULL == job) { return NULL; }
+
+  job->next = NULL;
+  job->command = command;
+
+  WebCardRequest_init(&(job->request));
+
+  /* The WebCard Request can live in the main thread's `JsonArena`, */
+  /* and it can borrow strings from the input buffer, */
+  /* which are both reused: keep an independent copy on the heap */
+
+  arena = JsonArena_attach(NULL);
+
+  if (NULL != request)
+  {
+    test_bool = WebCardRequest_copy(&(job->request), request);
+  }
+
+  if (!test_bool)
+  {
+    WebCardRequest_destroy(&(job->request));
+    free(job);
+  }
+
+  JsonArena_attach(arena);
+
+  if (!test_bool) { return NULL; }
+
+  /* The request is left empty for its destructor */
+
+  if (NULL != request)
+  {
+    WebCardRequest_destroy(request);
+  }
+
+  job->readerState = readerState[0];
+  job->readerState.szReader = NULL;
+
+  return job;
+}
+
+/**************************************************************/
+
+VOID
+SCardWorkerJob_free(
+  _Inout_ SCardWorkerJob *job)
+{
+  WebCardRequest_destroy(&(job->request));
+  free(job);
+}
+
+/**************************************************************/
+
+/**
+ * @brief Checks if the job was created for given request.
+ *
+ * @param[in] job Reference to a VALID and CONSTANT `SCardWorkerJob` object.
+ * @param[in] requestId Identifier of the request ("i" key).
+ * @return `TRUE` if the identifiers match, otherwise `FALSE`.
+ */
+static BOOL
+SCardWorkerJob_hasRequestId(
+  _In_ const SCardWorkerJob *job,
+  _In_ const UTF8String *requestId)
+{
+  const UTF8String *id = &(job->request.id);
+
+  /* Compare lengths first: `requestId` can be a view without */
+  /* a NULL-terminator (borrowed from the JSON message) */
+
+  return (0 != (WEBCARD_REQUEST_KEY__ID & job->request.keys)) &&
+    (requestId->length == id->length) &&
+    (0 == memcmp(
+      id->text,
+      requestId->text,
+      requestId->length));
+}
+
+/**************************************************************/
+
+/**
+ * @brief The worker thread: executes the queued jobs one after another,
+ * until the `worker->shouldStop` flag is set.
+ *
+ * @param[in] param Reference to a VALID `SCardWorker` object.
+ */
+static VOID
+SCardWorker_threadRoutine(
+  _In_opt_ LPVOID param)
+{
+  SCardWorker *worker = (SCardWorker *) param;
+  SCardWorkerResults *results = worker->results;
+  SCardWorkerJob *job;
+  SCARDCONTEXT context;
+  JsonWriter json_writer;
+  JsonWriterMark json_mark;
+  BOOL responding;
+  BOOL stopping;
+  BOOL cancelled;
+  BOOL stopped;
+
+  OSSpecific_lockMutex(&(worker->mutex));
+
+  while (TRUE)
+  {
+    while ((NULL == worker->firstJob) && (!worker->shouldStop))
+    {
+      OSSpecific_waitForCondition(
+        &(worker->condition),
+        &(worker->mutex),
+        OS_SPECIFIC_INFINITE);
+    }
+
+    /* Take the first job from the queue */
+
+    job = worker->firstJob;
+
+    if (NULL == job)
+    {
+      /* Stopping, and no more jobs to answer */
+      break;
+    }
+
+    worker->firstJob = job->next;
+
+    if (NULL == worker->firstJob)
+    {
+      worker->lastJob = NULL;
+    }
+
+    stopping = worker->shouldStop;
+
+    worker->runningJob = job;
+    worker->runningCancelled = FALSE;
+    worker->runningStopped = FALSE;
+
+    OSSpecific_unlockMutex(&(worker->mutex));
+
+    /* Each Reader Worker uses its own Smart Card Context */
+
+    if ((!stopping) && (0 == worker->context))
+    {
+      WebCard_establishContext(&(context));
+
+      worker->context = context;
+    }
+
+    /* The JSON Response (with the "i" key) is written straight into */
+    /* the worker's own queue (a job that only closes the connection */
+    /* has no JSON Request, and it is not answered) */
+
+    responding = WebCard_beginResponse(
+      &(json_writer),
+      &(worker->output),
+      &(job->request));
+
+    JsonWriter_mark(&(json_writer), &(json_mark));
+
+    /* Jobs left behind by a removed reader are rejected */
+
+    if (stopping)
+    {
+      WebCard_markIncomplete(&(json_writer));
+    }
+    else
+    {
+      WebCard_runJob(worker, job, &(json_writer));
+    }
+
+    OSSpecific_lockMutex(&(worker->mutex));
+
+    cancelled = worker->runningCancelled;
+    stopped = worker->runningStopped;
+    worker->runningJob = NULL;
+
+    OSSpecific_unlockMutex(&(worker->mutex));
+
+    if (stopped)
+    {
+      /* A batch or a script has stopped between two Smart Card */
+      /* operations: drop partial results, keep the "i" key only */
+
+      JsonWriter_rollback(&(json_writer), &(json_mark));
+      WebCard_markIncomplete(&(json_writer));
+      WebCard_markCancelled(&(json_writer));
+    }
+    else if (cancelled)
+    {
+      /* Connect, disconnect, and transmit cannot be interrupted: */
+      /* the job has already taken effect, so its real result is kept */
+
+      WebCard_markCancelled(&(json_writer));
+    }
+
+    if (responding && JsonWriter_finish(&(json_writer)))
+    {
+      SCardWorkerResults_push(worker->results, &(worker->output));
+    }
+
+    SCardWorkerJob_free(job);
+
+    /* Buffers enlarged by a large APDU are not kept for the next jobs */
+
+    SCardConnection_trimBuffers(&(worker->connection));
+
+    JsonOutputQueue_trim(&(worker->output), WEBCARD_BUFFER__MAX_RETAINED_SIZE);
+
+    OSSpecific_lockMutex(&(worker->mutex));
+  }
+
+  OSSpecific_unlockMutex(&(worker->mutex));
+
+  /* Release the resources owned by the worker thread */
+
+  SCardConnection_close(&(worker->connection));
+  SCardConnection_destroy(&(worker->connection));
+
+  if (0 != worker->context)
+  {
+    SCardReleaseContext(worker->context);
+    worker->context = 0;
+  }
+
+  /* A retired worker can be released by the main thread from now on */
+
+  OSSpecific_lockMutex(&(results->mutex));
+  worker->finished = TRUE;
+  OSSpecific_unlockMutex(&(results->mutex));
+
+  OSSpecific_signalEvent(results->wakeEvent);
+}
+
+/**************************************************************/
+
+BOOL
+SCardWorker_init(
+  _Out_ SCardWorker *worker,
+  _In_ LPCTSTR readerName,
+  _In_ SCardWorkerResults *results)
+{
+  size_t byteSize;
+
+  /* Clone Smart Card Reader name */
+
+  byteSize = sizeof(TCHAR) * (1 + _tcslen(readerName));
+  worker->readerName = malloc(byteSize);
+  if (NULL == worker->readerName) { return FALSE; }
+
+  memcpy(worker->readerName, readerName, byteSize);
+
+  worker->context = 0;
+  SCardConnection_init(&(worker->connection));
+  worker->firstJob = NULL;
+  worker->lastJob = NULL;
+  worker->runningJob = NULL;
+  worker->runningCancelled = FALSE;
+  worker->runningStopped = FALSE;
+  worker->shouldStop = FALSE;
+  worker->results = results;
+  worker->ignoreCounter = 0;
+  worker->nextRetired = NULL;
+  worker->finished = FALSE;
+
+  JsonOutputQueue_init(&(worker->output));
+
+  if (!OSSpecific_initMutex(&(worker->mutex)))
+  {
+    free(worker->readerName);
+    return FALSE;
+  }
+
+  if (!OSSpecific_initCondition(&(worker->condition)))
+  {
+    OSSpecific_destroyMutex(&(worker->mutex));
+    free(worker->readerName);
+    return FALSE;
+  }
+
+  if (!OSSpecific_createThread(
+    &(worker->thread),
+    SCardWorker_threadRoutine,
+    (LPVOID) worker))
+  {
+    OSSpecific_destroyCondition(&(worker->condition));
+    OSSpecific_destroyMutex(&(worker->mutex));
+    free(worker->readerName);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+VOID
+SCardWorker_destroy(
+  _Inout_ SCardWorker *worker)
+{
+  OSSpecific_lockMutex(&(worker->mutex));
+
+  worker->shouldStop = TRUE;
+  OSSpecific_wakeCondition(&(worker->condition));
+
+  OSSpecific_unlockMutex(&(worker->mutex));
+
+  /* The job being executed (if any) is completed first */
+
+  OSSpecific_joinThread(worker->thread);
+
+  OSSpecific_destroyCondition(&(worker->condition));
+  OSSpecific_destroyMutex(&(worker->mutex));
+
+  JsonOutputQueue_destroy(&(worker->output));
+  free(worker->readerName);
+}
+
+/**************************************************************/
+
+VOID
+SCardWorker_retire(
+  _Inout_ SCardWorker *worker)
+{
+  SCardWorkerResults *results = worker->results;
+
+  /* The worker is released once its thread reports the end */
+
+  OSSpecific_lockMutex(&(results->mutex));
+
+  worker->nextRetired = results->retired;
+  results->retired = worker;
+
+  OSSpecific_unlockMutex(&(results->mutex));
+
+  OSSpecific_lockMutex(&(worker->mutex));
+
+  worker->shouldStop = TRUE;
+  OSSpecific_wakeCondition(&(worker->condition));
+
+  OSSpecific_unlockMutex(&(worker->mutex));
+}
+
+/**************************************************************/
+
+VOID
+SCardWorker_pushJob(
+  _Inout_ SCardWorker *worker,
+  _In_ SCardWorkerJob *job)
+{
+  job->next = NULL;
+
+  OSSpecific_lockMutex(&(worker->mutex));
+
+  if (NULL == worker->lastJob)
+  {
+    worker->firstJob = job;
+  }
+  else
+  {
+    worker->lastJob->next = job;
+  }
+
+  worker->lastJob = job;
+
+  OSSpecific_wakeCondition(&(worker->condition));
+
+  OSSpecific_unlockMutex(&(worker->mutex));
+}
+
+/**************************************************************/
+
+int
+SCardWorker_cancelJob(
+  _Inout_ SCardWorker *worker,
+  _In_ const UTF8String *requestId,
+  _Out_ SCardWorkerJob **removedJobRef)
+{
+  int result = WEBCARD_CANCEL__NOT_FOUND;
+  SCardWorkerJob *job;
+  SCardWorkerJob *previous = NULL;
+
+  removedJobRef[0] = NULL;
+
+  OSSpecific_lockMutex(&(worker->mutex));
+
+  /* Is the request still waiting in the queue? */
+
+  for (job = worker->firstJob; NULL != job; job = job->next)
+  {
+    if (SCardWorkerJob_hasRequestId(job, requestId))
+    {
+      /* Unlink the job */
+
+      if (NULL == previous)
+      {
+        worker->firstJob = job->next;
+      }
+      else
+      {
+        previous->next = job->next;
+      }
+
+      if (worker->lastJob == job)
+      {
+        worker->lastJob = previous;
+      }
+
+      job->next = NULL;
+      removedJobRef[0] = job;
+      result = WEBCARD_CANCEL__QUEUED;
+      break;
+    }
+
+    previous = job;
+  }
+
+  /* Is the request being executed right now? */
+
+  job = worker->runningJob;
+
+  if ((WEBCARD_CANCEL__NOT_FOUND == result) && (NULL != job) &&
+    SCardWorkerJob_hasRequestId(job, requestId))
+  {
+    /* Nothing is interrupted: `SCardCancel` only affects */
+    /* `SCardGetStatusChange`, which workers do not call */
+
+    worker->runningCancelled = TRUE;
+    result = WEBCARD_CANCEL__RUNNING;
+  }
+
+  OSSpecific_unlockMutex(&(worker->mutex));
+
+  return result;
+}
+
+/**************************************************************/
+
+BOOL
+SCardWorker_isCancelled(
+  _Inout_ SCardWorker *worker)
+{
+  BOOL test_bool;
+
+  OSSpecific_lockMutex(&(worker->mutex));
+
+  test_bool = worker->runningCancelled;
+
+  if (test_bool)
+  {
+    worker->runningStopped = TRUE;
+  }
+
+  OSSpecific_unlockMutex(&(worker->mutex));
+
+  return test_bool;
+}
+
+/**************************************************************/
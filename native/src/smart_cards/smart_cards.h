@@ -10,6 +10,7 @@
 #include "misc/misc.h"
 #include "utf/utf.h"
 #include "json/json.h"
+#include "timers/timers.h"
 
 #if defined(_WIN32)
   #include <winscard.h>
@@ -39,6 +40,36 @@
 
 #define MAX_APDU_SIZE  0x7FFF
 
+/** Largest short APDU: header, Lc, 255 bytes of data, and Le. */
+#define MAX_SHORT_APDU_SIZE  (5 + 255 + 1)
+
+/**
+ * Buffers for APDUs and responses (in `SCardConnection`, `SCardWorker`
+ * and the output queues) are kept between requests, unless they have grown
+ * larger than this limit (in bytes), so that a single large APDU
+ * does not hold the memory.
+ */
+#define WEBCARD_BUFFER__MAX_RETAINED_SIZE  0x10000
+
+/**
+ * Main loop intervals (in milliseconds).
+ */
+
+  /** How often is the list of Smart Card Readers fetched
+   * (only when the PnP Notifications are not supported). */
+  #define WEBCARD_INTERVAL__READERS_FETCH  1000
+
+  /** How often is `SCardCancel` repeated, until the Reader Watcher
+   * picks up the updated list of readers (a cancellation that arrives
+   * before the Watcher starts waiting is lost). */
+  #define WEBCARD_INTERVAL__WATCHER_RETRY    10
+
+/**
+ * Name of the pseudo-reader, which changes its state whenever
+ * a Smart Card Reader is plugged in or unplugged.
+ */
+#define WEBCARD_PNP_READER_NAME  _T("\\\\?PnP?\\Notification")
+
 /**
  * Possible "Reader Event" values.
  */
@@ -58,8 +89,63 @@
   #define WEBCARD_COMMAND__CONNECT        2
   #define WEBCARD_COMMAND__DISCONNECT     3
   #define WEBCARD_COMMAND__TRANSCEIVE     4
+  #define WEBCARD_COMMAND__CANCEL         5
+  #define WEBCARD_COMMAND__TRANSCEIVE_BATCH  6
+  #define WEBCARD_COMMAND__RUN_SCRIPT        7
   #define WEBCARD_COMMAND__GET_VERSION   10
 
+/**
+ * Keys decoded from a WebCard Request (`WebCardRequest` bitmask).
+ */
+
+  #define WEBCARD_REQUEST_KEY__ID             0x01  /* "i" */
+  #define WEBCARD_REQUEST_KEY__COMMAND        0x02  /* "c" */
+  #define WEBCARD_REQUEST_KEY__READER         0x04  /* "r" */
+  #define WEBCARD_REQUEST_KEY__SHARE_MODE     0x08  /* "p" */
+  #define WEBCARD_REQUEST_KEY__DATA           0x10  /* "a" */
+  #define WEBCARD_REQUEST_KEY__STOP_ON_ERROR  0x20  /* "s" */
+  #define WEBCARD_REQUEST_KEY__TARGET         0x40  /* "t" */
+  #define WEBCARD_REQUEST_KEY__BASE64_DATA    0x80  /* "b" */
+  #define WEBCARD_REQUEST_KEY__HANDLING      0x100  /* "h" */
+
+  /* "a" (hex-strings) and "b" (Base64) are two encodings of one value */
+  #define WEBCARD_REQUEST_KEY__ANY_DATA  \
+    (WEBCARD_REQUEST_KEY__DATA | WEBCARD_REQUEST_KEY__BASE64_DATA)
+
+/**
+ * Encodings of APDUs (commands and responses) exchanged with the browser.
+ */
+
+  #define SCARD_APDU_ENCODING__HEX     0
+  #define SCARD_APDU_ENCODING__BASE64  1
+
+/**
+ * Optional handling of APDUs by the Native App ("h" key, bitmask),
+ * other than following "61xx" with GET RESPONSE (always enabled).
+ */
+
+  /** "6Cxx" (wrong Le): the same APDU is sent again, with `Le = xx`. */
+  #define SCARD_APDU_HANDLING__REISSUE_WRONG_LE  0x01
+
+  /** An extended APDU with more than 255 bytes of data is sent
+   * as short APDUs, linked with the command chaining bit of CLA. */
+  #define SCARD_APDU_HANDLING__COMMAND_CHAINING  0x02
+
+/**
+ * Possible return values for `SCardWorker_cancelJob` function.
+ */
+
+  #define WEBCARD_CANCEL__NOT_FOUND  0
+  #define WEBCARD_CANCEL__QUEUED     1
+  #define WEBCARD_CANCEL__RUNNING    2
+
+/**
+ * Limits of a single APDU Script (command 7).
+ */
+
+  #define SCARD_SCRIPT__MAX_STEPS      4096
+  #define SCARD_SCRIPT__MAX_VARIABLES    32
+
 /**
  * Possible return values for `SCardReaderDB_fetch` function.
  */
@@ -69,6 +155,7 @@
   #define WEBCARD_FETCH_READERS__IGNORE           2
   #define WEBCARD_FETCH_READERS__MORE_READERS     3
   #define WEBCARD_FETCH_READERS__LESS_READERS     4
+  #define WEBCARD_FETCH_READERS__OTHER_READERS    5
 
 
 /**************************************************************/
@@ -93,6 +180,21 @@ struct SCardConnection
 
   /** How many incoming Reader State Changes should be ignored. */
   DWORD ignoreCounter;
+
+  /** Decoded APDU to be transmitted (dynamic allocation, reused
+   * for every APDU, `NULL` until the first one). */
+  LPBYTE input;
+
+  /** Size of the `input` buffer, in bytes. */
+  size_t inputCapacity;
+
+  /** Received APDU responses (dynamic allocation of `MAX_APDU_SIZE`
+   * bytes, reused for every APDU, `NULL` until the first one). */
+  LPBYTE output;
+
+  /** Hex-strings built while running APDU Scripts (reused for every
+   * APDU of every script). */
+  UTF8String hex;
 };
 
 /**
@@ -105,6 +207,58 @@ extern VOID
 SCardConnection_init(
   _Out_ SCardConnection *connection);
 
+/**
+ * @brief `SCardConnection` destructor. Releases the buffers
+ * (the connection should be closed first).
+ *
+ * @param[in,out] connection Reference to a VALID `SCardConnection` object.
+ */
+extern VOID
+SCardConnection_destroy(
+  _Inout_ SCardConnection *connection);
+
+/**
+ * @brief Allocates the `output` buffer of the connection
+ * (`MAX_APDU_SIZE` bytes), unless it has been allocated before.
+ *
+ * @param[in,out] connection Reference to a VALID `SCardConnection` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+SCardConnection_assertOutput(
+  _Inout_ SCardConnection *connection);
+
+/**
+ * @brief Releases the buffers of the connection that have grown larger
+ * than `WEBCARD_BUFFER__MAX_RETAINED_SIZE` (called after every job).
+ *
+ * @param[in,out] connection Reference to a VALID `SCardConnection` object.
+ */
+extern VOID
+SCardConnection_trimBuffers(
+  _Inout_ SCardConnection *connection);
+
+/**
+ * @brief Decodes an APDU string (hex-string or Base64) into the `input`
+ * buffer of the connection (the buffer is enlarged when needed).
+ *
+ * @param[in,out] connection Reference to a VALID `SCardConnection` object.
+ * @param[in] apdu Reference to a VALID and CONSTANT `UTF8String` object
+ * with the encoded APDU.
+ * @param[in] encoding One of the `SCARD_APDU_ENCODING__*` values.
+ * @param[out] inputLengthRef Pointer to a variable that will hold
+ * the number of decoded bytes (stored in `connection->input`).
+ * @return `TRUE` on success, `FALSE` on memory allocation failure,
+ * when the given string is not valid in the selected encoding,
+ * OR when the decoded APDU would be longer than `MAX_APDU_SIZE`.
+ */
+extern BOOL
+SCardConnection_decodeApdu(
+  _Inout_ SCardConnection *connection,
+  _In_ const UTF8String *apdu,
+  _In_ const uint32_t encoding,
+  _Out_ size_t *inputLengthRef);
+
 /**
  * @brief Opens connection to a Smart Card Reader.
  *
@@ -163,23 +317,600 @@ SCardConnection_transceiveSingle(
  *
  * @param[in] connection Reference to a VALID and CONSTANT
  * `SCardConnection` object.
- * @param[in,out] hexStringResult Refernce to a VALID `UTF8String` object.
- * Reponse in form of hex-string will be appended at the end of this param.
+ * @param[in,out] stringResult Refernce to a VALID `UTF8String` object.
+ * Reponse in form of hex-string (or Base64) will be appended at the end
+ * of this param.
+ * @param[in] encoding One of the `SCARD_APDU_ENCODING__*` values.
+ * @param[in] handling Combination of `SCARD_APDU_HANDLING__*` flags.
  * @param[in] input Data to be written to the card.
  * @param[in] inputLength The length of `input` buffer, in bytes.
  * @param[out] output Buffer that can be used to collect reponse data.
  * @param[in] outputLength The length of `output` buffer, in bytes.
+ * @param[out] statusWordRef Optional pointer to a variable that will hold
+ * the last Status Word (for example `0x9000`), or zero if the last response
+ * was shorter than two bytes.
  * @return `TRUE` on success (one APDU sent and multiple APDUs received),
  * `FALSE` if any Smart Card error has occurred.
  */
 extern BOOL
 SCardConnection_transceiveMultiple(
   _In_ const SCardConnection *connection,
-  _Inout_ UTF8String *hexStringResult,
+  _Inout_ UTF8String *stringResult,
+  _In_ const uint32_t encoding,
+  _In_ const uint32_t handling,
   _In_ const BYTE *input,
   _In_ const PCSC_DWORD inputLength,
   _Out_ LPBYTE output,
-  _In_ const PCSC_DWORD outputLength);
+  _In_ const PCSC_DWORD outputLength,
+  _Out_opt_ uint16_t *statusWordRef);
+
+
+/**************************************************************/
+/* WEBCARD REQUEST                                            */
+/**************************************************************/
+
+/**
+ * `WebCardRequest` type definition.
+ */
+typedef struct WebCardRequest WebCardRequest;
+
+/**
+ * WebCard Request (input command), decoded from a JSON Object
+ * with a fixed set of single-letter keys.
+ */
+struct WebCardRequest
+{
+  /** Keys found in the JSON Request, with values of expected types
+   * (combination of `WEBCARD_REQUEST_KEY__*` flags). */
+  uint32_t keys;
+
+  /** Known keys found with values of unexpected types
+   * (such a request is answered as incomplete). */
+  uint32_t invalidKeys;
+
+  /** "i": unique message identifier (repeated in the JSON Response). */
+  UTF8String id;
+
+  /** "c": one of the `WEBCARD_COMMAND__*` values. */
+  size_t command;
+
+  /** "r": index of the Smart Card Reader. */
+  size_t reader;
+
+  /** "p": optional Share Mode for `WEBCARD_COMMAND__CONNECT`. */
+  PCSC_DWORD shareMode;
+
+  /** "s": optional "stop on error" flag
+   * for `WEBCARD_COMMAND__TRANSCEIVE_BATCH`. */
+  BOOL stopOnError;
+
+  /** "t": identifier of the request to cancel (`WEBCARD_COMMAND__CANCEL`). */
+  UTF8String target;
+
+  /** "h": optional handling of APDUs (`SCARD_APDU_HANDLING__*` flags)
+   * for transceive, batch, and script commands. */
+  uint32_t handling;
+
+  /** "a": APDU hex-string (JSON String), array of APDU hex-strings,
+   * or array of script steps (JSON Array).
+   * "b": APDU (or array of APDUs) in Base64, used instead of "a". */
+  JsonValue data;
+};
+
+/**
+ * @brief `WebCardRequest` constructor.
+ *
+ * @param[out] request Reference to an UNINITIALIZED `WebCardRequest` object.
+ */
+extern VOID
+WebCardRequest_init(
+  _Out_ WebCardRequest *request);
+
+/**
+ * @brief `WebCardRequest` destructor.
+ *
+ * @param[in,out] request Reference to a VALID `WebCardRequest` object.
+ */
+extern VOID
+WebCardRequest_destroy(
+  _Inout_ WebCardRequest *request);
+
+/**
+ * @brief Creates a deep-copy (independent memory allocation)
+ * of the `WebCardRequest` object.
+ *
+ * @param[out] destination Reference to an UNINITIALIZED
+ * `WebCardRequest` object (copy destination).
+ * @param[in] source Reference to a VALID and CONSTANT `WebCardRequest` object
+ * (copy source).
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ *
+ * @note After this call, `destination` will hold a VALID (at least initialized)
+ * `WebCardRequest` object. If the function returned `FALSE`,
+ * `destination` shall be destroyed.
+ */
+extern BOOL
+WebCardRequest_copy(
+  _Out_ WebCardRequest *destination,
+  _In_ const WebCardRequest *source);
+
+/**
+ * @brief Decodes a WebCard Request straight from its UTF-8
+ * (stringified JSON) representation, in a single pass.
+ *
+ * Values of the known keys are stored in typed fields (strings stay views
+ * into the stream when possible, only the "a" or "b" key can hold a nested
+ * JSON Array). Unknown keys and repeated keys are skipped without being
+ * loaded (see `JsonValue_skip`). Known keys with values of unexpected types
+ * are recorded in `invalidKeys`.
+ * @param[out] request Reference to an UNINITIALIZED `WebCardRequest` object.
+ * @param[in,out] stream Reference to a VALID `JsonByteStream` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure OR
+ * on any parsing error (not a JSON Object).
+ *
+ * @note After this call, `request` will hold a VALID (at least initialized)
+ * `WebCardRequest` object, which must be destroyed by the caller.
+ */
+extern BOOL
+WebCardRequest_parse(
+  _Out_ WebCardRequest *request,
+  _Inout_ JsonByteStream *stream);
+
+
+/**************************************************************/
+/* SMART CARD READER WORKER                                   */
+/**************************************************************/
+
+/**
+ * `SCardWorkerResults` type definition.
+ */
+typedef struct SCardWorkerResults SCardWorkerResults;
+
+/**
+ * `SCardWorker` type definition.
+ */
+typedef struct SCardWorker SCardWorker;
+
+/**
+ * JSON Responses prepared by the Reader Workers, waiting to be sent
+ * to the Standard Output by the main thread
+ * (shared by all the Reader Workers).
+ */
+struct SCardWorkerResults
+{
+  /** Guards the `queue`, the `retired` list,
+   * and the `finished` flags of the retired workers. */
+  os_specific_mutex_t mutex;
+
+  /** Stringified JSON Responses. */
+  JsonOutputQueue queue;
+
+  /** Reader Workers of removed readers, which are still answering
+   * their jobs (see `SCardWorker_retire`). */
+  SCardWorker *retired;
+
+  /** Event signaled whenever a new JSON Response is queued. */
+  os_specific_event_t *wakeEvent;
+};
+
+/**
+ * @brief `SCardWorkerResults` constructor.
+ *
+ * @param[out] results Reference to an UNINITIALIZED
+ * `SCardWorkerResults` object.
+ * @param[in] wakeEvent Event that wakes up the main loop.
+ * It must outlive the `results` object.
+ * @return `TRUE` on success, `FALSE` on system errors.
+ */
+extern BOOL
+SCardWorkerResults_init(
+  _Out_ SCardWorkerResults *results,
+  _In_ os_specific_event_t *wakeEvent);
+
+/**
+ * @brief `SCardWorkerResults` destructor.
+ *
+ * @param[in,out] results Reference to a VALID `SCardWorkerResults` object.
+ * @note No Reader Worker can be using `results` during this call.
+ */
+extern VOID
+SCardWorkerResults_destroy(
+  _Inout_ SCardWorkerResults *results);
+
+/**
+ * @brief Moves the JSON Responses written by a Reader Worker
+ * (from any thread) and wakes up the main loop.
+ *
+ * @param[in,out] results Reference to a VALID `SCardWorkerResults` object.
+ * @param[in,out] source Reference to a VALID `JsonOutputQueue` object,
+ * which is emptied on success.
+ */
+extern VOID
+SCardWorkerResults_push(
+  _Inout_ SCardWorkerResults *results,
+  _Inout_ JsonOutputQueue *source);
+
+/**
+ * @brief Moves all the queued JSON Responses
+ * to the main thread's output queue.
+ *
+ * @param[in,out] results Reference to a VALID `SCardWorkerResults` object.
+ * @param[in,out] output Reference to a VALID `JsonOutputQueue` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * (the responses are kept in `results` for the next attempt).
+ */
+extern BOOL
+SCardWorkerResults_moveTo(
+  _Inout_ SCardWorkerResults *results,
+  _Inout_ JsonOutputQueue *output);
+
+/**
+ * @brief Releases the retired Reader Workers, whose threads have ended.
+ *
+ * @param[in,out] results Reference to a VALID `SCardWorkerResults` object.
+ * @param[in] wait Should the workers that are still running be waited for
+ * (before `results` is destroyed)?
+ */
+extern VOID
+SCardWorkerResults_collectRetired(
+  _Inout_ SCardWorkerResults *results,
+  _In_ const BOOL wait);
+
+/**
+ * `SCardWorkerJob` type definition.
+ */
+typedef struct SCardWorkerJob SCardWorkerJob;
+
+/**
+ * One WebCard Request, waiting in the queue of a Reader Worker.
+ */
+struct SCardWorkerJob
+{
+  /** Next job in the queue (`NULL` for the last job). */
+  SCardWorkerJob *next;
+
+  /** One of the `WEBCARD_COMMAND__*` values
+   * (`WEBCARD_COMMAND__NONE` closes the connection without responding). */
+  size_t command;
+
+  /** WebCard Request (an independent copy, owned by the job). */
+  WebCardRequest request;
+
+  /** Reader State at the time the request was received
+   * (the `szReader` field is not valid). */
+  SCARD_READERSTATE readerState;
+};
+
+/**
+ * @brief Allocates a new job, taking over the WebCard Request.
+ *
+ * @param[in] command One of the `WEBCARD_COMMAND__*` values.
+ * @param[in,out] request Reference to a VALID `WebCardRequest` object
+ * (optional). It is deep-copied, because it can be built in a `JsonArena`
+ * and its strings can borrow memory from the input buffer.
+ * On success, it is left empty (initialized).
+ * @param[in] readerState Reference to a read-only Reader State.
+ * @return Dynamically allocated job, or `NULL` on memory allocation failure.
+ */
+extern SCardWorkerJob *
+SCardWorkerJob_create(
+  _In_ const size_t command,
+  _In_opt_ WebCardRequest *request,
+  _In_ const SCARD_READERSTATE *readerState);
+
+/**
+ * @brief Releases a job (and its WebCard Request).
+ *
+ * @param[in,out] job Dynamically allocated job.
+ */
+extern VOID
+SCardWorkerJob_free(
+  _Inout_ SCardWorkerJob *job);
+
+/**
+ * Reader Worker: a thread that executes the requests sent to one
+ * Smart Card Reader, one after another, so that a slow card
+ * does not stall the main loop nor the other readers.
+ * It uses its own Smart Card Context and its own connection.
+ */
+struct SCardWorker
+{
+  /** Name of the Smart Card Reader (dynamic allocation). */
+  LPTSTR readerName;
+
+  /** Smart Card Context, established and used by the worker thread only
+   * (`0` if it is not established yet). */
+  SCARDCONTEXT context;
+
+  /** Connection to the Smart Card (used by the worker thread only). */
+  SCardConnection connection;
+
+  /** The worker thread. */
+  os_specific_thread_t thread;
+
+  /** Guards `firstJob`, `lastJob`, `runningJob`, `runningCancelled`,
+   * `runningStopped` and `shouldStop`. */
+  os_specific_mutex_t mutex;
+
+  /** Wakes up the worker thread (new job, shutdown). */
+  os_specific_condition_t condition;
+
+  /** Queue of the waiting jobs (first in, first out). */
+  SCardWorkerJob *firstJob;
+
+  /** The most recently queued job. */
+  SCardWorkerJob *lastJob;
+
+  /** The job being executed (`NULL` when the worker is idle). */
+  SCardWorkerJob *runningJob;
+
+  /** Was the `runningJob` cancelled? */
+  BOOL runningCancelled;
+
+  /** Has the `runningJob` stopped early, because of the cancellation
+   * (see `SCardWorker_isCancelled`)? */
+  BOOL runningStopped;
+
+  /** Should the worker thread end (after answering the waiting jobs)? */
+  BOOL shouldStop;
+
+  /** Where the JSON Responses are queued. */
+  SCardWorkerResults *results;
+
+  /** JSON Responses written by the worker thread, before they are
+   * moved to `results` (the buffer is reused for every job). */
+  JsonOutputQueue output;
+
+  /** How many incoming Reader State Changes should be ignored
+   * (used by the main thread only). */
+  DWORD ignoreCounter;
+
+  /** Next worker on the `results->retired` list. */
+  SCardWorker *nextRetired;
+
+  /** Has the worker thread ended? (guarded by `results->mutex`) */
+  BOOL finished;
+};
+
+/**
+ * @brief `SCardWorker` constructor. Starts the worker thread.
+ *
+ * @param[out] worker Reference to an UNINITIALIZED `SCardWorker` object,
+ * which must not be moved in memory until it is destroyed.
+ * @param[in] readerName Name of the Smart Card Reader.
+ * @param[in] results Reference to a VALID `SCardWorkerResults` object,
+ * which must outlive the `worker` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation or system errors
+ * (`worker` is left uninitialized).
+ */
+extern BOOL
+SCardWorker_init(
+  _Out_ SCardWorker *worker,
+  _In_ LPCTSTR readerName,
+  _In_ SCardWorkerResults *results);
+
+/**
+ * @brief `SCardWorker` destructor. Waits for the current job
+ * to complete, and answers the waiting jobs as incomplete.
+ *
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object.
+ */
+extern VOID
+SCardWorker_destroy(
+  _Inout_ SCardWorker *worker);
+
+/**
+ * @brief Stops a worker without waiting for it. The worker thread
+ * completes the current job and answers the waiting jobs as incomplete,
+ * then the worker is released by `SCardWorkerResults_collectRetired`.
+ *
+ * @param[in,out] worker Reference to a VALID and dynamically allocated
+ * `SCardWorker` object (now owned by its `SCardWorkerResults`).
+ */
+extern VOID
+SCardWorker_retire(
+  _Inout_ SCardWorker *worker);
+
+/**
+ * @brief Appends a job at the end of the worker's queue.
+ *
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object.
+ * @param[in] job Dynamically allocated job (now owned by the worker).
+ */
+extern VOID
+SCardWorker_pushJob(
+  _Inout_ SCardWorker *worker,
+  _In_ SCardWorkerJob *job);
+
+/**
+ * @brief Cancels a job, selected by the request identifier ("i" key).
+ *
+ * A waiting job is removed from the queue and returned to the caller.
+ * A job being executed is only flagged: Smart Card operations cannot be
+ * interrupted, so batches and scripts stop before their next operation
+ * (answered as cancelled), while other jobs are answered with their
+ * real results and the "cancelled=true" key-value.
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object.
+ * @param[in] requestId Identifier of the request to cancel.
+ * @param[out] removedJobRef Pointer to a location that receives
+ * the removed job (when `WEBCARD_CANCEL__QUEUED` is returned),
+ * which must be answered and released by the caller.
+ * @return `WEBCARD_CANCEL__QUEUED`, `WEBCARD_CANCEL__RUNNING`,
+ * or `WEBCARD_CANCEL__NOT_FOUND` if the worker has no such job.
+ */
+extern int
+SCardWorker_cancelJob(
+  _Inout_ SCardWorker *worker,
+  _In_ const UTF8String *requestId,
+  _Out_ SCardWorkerJob **removedJobRef);
+
+/**
+ * @brief Checks if the job being executed was cancelled
+ * (called on the worker thread, between Smart Card operations).
+ * When `TRUE` is returned, the job must stop: its partial results
+ * are then dropped.
+ *
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object.
+ * @return `TRUE` if `SCardWorker_cancelJob` has flagged the running job.
+ */
+extern BOOL
+SCardWorker_isCancelled(
+  _Inout_ SCardWorker *worker);
+
+
+/**************************************************************/
+/* SMART CARD SCRIPT                                          */
+/**************************************************************/
+
+/**
+ * `SCardScriptVariable` type definition.
+ */
+typedef struct SCardScriptVariable SCardScriptVariable;
+
+/**
+ * Named variable of an APDU Script.
+ */
+struct SCardScriptVariable
+{
+  /** Case-sensitive variable name. */
+  UTF8String name;
+
+  /** Variable value, stored as a hex-string. */
+  UTF8String value;
+};
+
+/**
+ * `SCardScript` type definition.
+ */
+typedef struct SCardScript SCardScript;
+
+/**
+ * State of an APDU Script, interpreted next to the Smart Card Reader.
+ *
+ * A script is a JSON Array of steps (JSON Objects). Each step can:
+ * set some variables ("s" key), transmit an APDU ("a" key, where
+ * `{name}` inserts a variable), store the response data ("v" key,
+ * `+name` appends), advance an offset variable by the length
+ * of the response data ("o" key), and jump to another step depending
+ * on the Status Word ("j" key, where `X` matches any hex digit).
+ * The last Status Word is always kept in the "sw" variable.
+ */
+struct SCardScript
+{
+  /** Number of defined variables. */
+  size_t count;
+
+  /** Defined variables. */
+  SCardScriptVariable variables[SCARD_SCRIPT__MAX_VARIABLES];
+};
+
+/**
+ * @brief `SCardScript` constructor.
+ *
+ * @param[out] script Reference to an UNINITIALIZED `SCardScript` object.
+ */
+extern VOID
+SCardScript_init(
+  _Out_ SCardScript *script);
+
+/**
+ * @brief `SCardScript` destructor.
+ *
+ * @param[in,out] script Reference to a VALID `SCardScript` object.
+ *
+ * @note After this call, `script` should not be used (unless re-initialized).
+ */
+extern VOID
+SCardScript_destroy(
+  _Inout_ SCardScript *script);
+
+/**
+ * @brief Sets (or appends to) the value of a script variable.
+ *
+ * @param[in,out] script Reference to a VALID `SCardScript` object.
+ * @param[in] name Variable name. Must end with a NULL-terminator!
+ * @param[in] value Hex-string to be stored.
+ * @param[in] valueLength Length of the hex-string.
+ * @param[in] append `TRUE` to append to the current value,
+ * `FALSE` to replace it.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * OR when too many variables were defined.
+ */
+extern BOOL
+SCardScript_setVariable(
+  _Inout_ SCardScript *script,
+  _In_z_ LPCSTR name,
+  _In_ LPCSTR value,
+  _In_ size_t valueLength,
+  _In_ const BOOL append);
+
+/**
+ * @brief Replaces every `{name}` in a hex-string template
+ * with the value of the given variable.
+ *
+ * @param[in] script Reference to a VALID and CONSTANT `SCardScript` object.
+ * @param[in] pattern Reference to a VALID and CONSTANT `UTF8String` object.
+ * @param[in,out] output Reference to a VALID `UTF8String` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure
+ * OR on an unknown variable name.
+ */
+extern BOOL
+SCardScript_expand(
+  _In_ const SCardScript *script,
+  _In_ const UTF8String *pattern,
+  _Inout_ UTF8String *output);
+
+/**
+ * @brief Adds a number to a variable, treated as a big-endian unsigned
+ * integer (the number of hex digits does not change).
+ *
+ * @param[in,out] script Reference to a VALID `SCardScript` object.
+ * @param[in] name Variable name. Must end with a NULL-terminator!
+ * @param[in] amount Number to be added.
+ * @return `TRUE` on success, `FALSE` on an unknown variable name
+ * OR when the result does not fit in the variable.
+ */
+extern BOOL
+SCardScript_advanceVariable(
+  _Inout_ SCardScript *script,
+  _In_z_ LPCSTR name,
+  _In_ size_t amount);
+
+/**
+ * @brief Runs the script steps on a connected Smart Card
+ * (called on the worker thread, inside a Smart Card transaction).
+ *
+ * The script ends after the last step, on a jump outside
+ * of the steps array, or on a Status Word other than `9000`
+ * that was not matched by the "j" key of the step.
+ * @param[in,out] script Reference to a VALID `SCardScript` object.
+ * @param[in] steps Reference to a VALID and CONSTANT `JsonArray` object.
+ * @param[in] handling Combination of `SCARD_APDU_HANDLING__*` flags,
+ * applied to every APDU.
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object.
+ * @return `TRUE` on success, `FALSE` on invalid steps OR on memory allocation
+ * error OR on any internal Smart Card error OR when the script did not
+ * finish within `SCARD_SCRIPT__MAX_STEPS` steps.
+ */
+extern BOOL
+SCardScript_run(
+  _Inout_ SCardScript *script,
+  _In_ const JsonArray *steps,
+  _In_ const uint32_t handling,
+  _Inout_ SCardWorker *worker);
+
+/**
+ * @brief Writes all the script variables as a JSON Object
+ * (variable names become the keys).
+ *
+ * @param[in] script Reference to a VALID and CONSTANT `SCardScript` object.
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+SCardScript_writeVariables(
+  _In_ const SCardScript *script,
+  _Inout_ JsonWriter *writer);
 
 
 /**************************************************************/
@@ -206,10 +937,11 @@ struct SCardReaderDB
   SCARD_READERSTATE *states;
 
   /**
-   * Array of `SCardConnection` structures, needed for
+   * Array of pointers to `SCardWorker` objects (started on demand,
+   * `NULL` until the first request), needed for
    * establishing connections and for data transmission.
    */
-  SCardConnection *connections;
+  SCardWorker **workers;
 };
 
 /**
@@ -250,6 +982,53 @@ SCardReaderDB_load(
   _Out_ SCardReaderDB *database,
   LPCTSTR readerNames);
 
+/**
+ * @brief Appends one Smart Card Reader (with a cloned name,
+ * unaware state and no Reader Worker) to the Database.
+ *
+ * @param[in,out] database Reference to a VALID `SCardReaderDB` object.
+ * @param[in] readerName Name of the Smart Card Reader.
+ * @return `TRUE` on success, `FALSE` on memory allocation errors.
+ */
+extern BOOL
+SCardReaderDB_appendReader(
+  _Inout_ SCardReaderDB *database,
+  _In_ LPCTSTR readerName);
+
+/**
+ * @brief Prepares a Smart Card Reader Database with the same reader names
+ * as some other Database (reader states and connections are NOT copied).
+ *
+ * @param[out] database Reference to an UNINITIALIZED `SCardReaderDB` object.
+ * @param[in] source Reference to a VALID and CONSTANT `SCardReaderDB` object.
+ * @return `TRUE` on successful copy, `FALSE` on memory allocation errors.
+ *
+ * @note After this call, `database` will hold a VALID (at least initialized)
+ * `SCardReaderDB` object. If the function returned `FALSE`,
+ * `database` shall be destroyed.
+ */
+extern BOOL
+SCardReaderDB_copyReaders(
+  _Out_ SCardReaderDB *database,
+  _In_ const SCardReaderDB *source);
+
+/**
+ * @brief Returns the Reader Worker of selected Smart Card Reader,
+ * starting it on the first call.
+ *
+ * @param[in,out] database Reference to a VALID `SCardReaderDB` object.
+ * @param[in] readerIndex Zero-based index of the Smart Card Reader.
+ * @param[in] results Reference to a VALID `SCardWorkerResults` object,
+ * which must outlive the `database` object.
+ * @return Reference to a VALID `SCardWorker` object,
+ * or `NULL` on memory allocation or system errors.
+ */
+extern SCardWorker *
+SCardReaderDB_getWorker(
+  _Inout_ SCardReaderDB *database,
+  _In_ const size_t readerIndex,
+  _In_ SCardWorkerResults *results);
+
 /**
  * @brief Checks if given Smart Card Reader exists in a given Database.
  *
@@ -264,34 +1043,227 @@ SCardReaderDB_hasReaderNamed(
 
 /**
  * @brief Fetches the list of currently connected Smart Card Readers
- * and replaces given Database if the number is different.
+ * and replaces given Database if the set of readers is different.
  *
  * @param[in] database Reference to a VALID `SCardReaderDB` object.
- * @param[out] jsonReaderNames An UNITIALIZED `JsonArray` object,
- * to which the names of changed (plugged in or out) readers will be appended.
+ * @param[out] jsonAddedNames An UNITIALIZED `JsonArray` object (or `NULL`),
+ * to which the names of just-added (plugged in) readers will be appended.
+ * @param[out] jsonRemovedNames An UNITIALIZED `JsonArray` object (or `NULL`),
+ * to which the names of now-missing (plugged out) readers will be appended.
  * @param[in] context A handle that identifies the resource manager context.
  * @param[in] firstFetch Should the initial contents of `database` be ignored?
  * @return `WEBCARD_FETCH_READERS__IGNORE` if no changes were detected;
- * `WEBCARD_FETCH_READERS__LESS_READERS` if some reades were disconnected
- * (and `jsonReaderNames` will hold the names of now-missing readers);
- * `WEBCARD_FETCH_READERS__MORE_READERS` if some readers were connected
- * (and `jsonReaderNames` will hold the names of just-added readers);
+ * `WEBCARD_FETCH_READERS__LESS_READERS` if there are fewer readers;
+ * `WEBCARD_FETCH_READERS__MORE_READERS` if there are more readers;
+ * `WEBCARD_FETCH_READERS__OTHER_READERS` if the number of readers
+ * is the same, but some readers were replaced by others;
  * `WEBCARD_FETCH_READERS__SERVICE_STOPPED` if last reader was disconnected,
  * the Smart Card Service has stopped and must be re-established;
  * `WEBCARD_FETCH_READERS__FAIL` on any error (and the Database doesn't change).
  *
- * @note After this call, `jsonReaderNames` will hold a VALID
- * (at least initialized) `JsonArray` object.
- * It must be released by the caller.
+ * @note After this call, `jsonAddedNames` and `jsonRemovedNames` will hold
+ * VALID (at least initialized) `JsonArray` objects.
+ * They must be released by the caller.
  */
 extern int
 SCardReaderDB_fetch(
   _Inout_ SCardReaderDB *database,
-  _Out_ JsonArray *jsonReaderNames,
+  _Out_opt_ JsonArray *jsonAddedNames,
+  _Out_opt_ JsonArray *jsonRemovedNames,
   _In_ const SCARDCONTEXT context,
   _In_ const BOOL firstFetch);
 
 
+/**************************************************************/
+/* SMART CARD READER WATCHER                                  */
+/**************************************************************/
+
+/**
+ * `SCardWatcherEvent` type definition.
+ */
+typedef struct SCardWatcherEvent SCardWatcherEvent;
+
+/**
+ * New state of one Smart Card Reader, reported by the Reader Watcher.
+ */
+struct SCardWatcherEvent
+{
+  /** Version of the reader list that was watched (`SCardWatcher::generation`). */
+  size_t generation;
+
+  /** Zero-based index of the reader in that list. */
+  size_t readerIndex;
+
+  /** Reader state flags (`dwEventState` without `SCARD_STATE_CHANGED`). */
+  PCSC_DWORD eventState;
+
+  /** The length of `atr` data, in bytes. */
+  PCSC_DWORD atrLength;
+
+  /** Answer To Reset of the inserted card (same size as in `SCARD_READERSTATE`). */
+  BYTE atr[sizeof(((SCARD_READERSTATE *) NULL)->rgbAtr)];
+};
+
+/**
+ * `SCardWatcher` type definition.
+ */
+typedef struct SCardWatcher SCardWatcher;
+
+/**
+ * Reader Watcher: a thread that blocks in `SCardGetStatusChange()`
+ * (without a timeout) and queues every change of the Reader States.
+ * It also watches the PnP Notification pseudo-reader (if supported),
+ * to find out when the list of readers should be fetched again.
+ */
+struct SCardWatcher
+{
+  /** Smart Card Context used by the watcher thread (can be `0`
+   * while the Smart Card Service is being re-established). */
+  SCARDCONTEXT context;
+
+  /** The watcher thread. */
+  os_specific_thread_t thread;
+
+  /** Guards all the fields of this structure. */
+  os_specific_mutex_t mutex;
+
+  /** Wakes up the watcher thread (new reader list, shutdown),
+   * and the main thread (watcher thread has ended). */
+  os_specific_condition_t condition;
+
+  /** Event signaled whenever new `SCardWatcherEvent` items are queued. */
+  os_specific_event_t *wakeEvent;
+
+  /** Newest reader list, not yet picked up by the watcher thread. */
+  SCardReaderDB readers;
+
+  /** Version of the reader list, incremented on every update. */
+  size_t generation;
+
+  /** Version of the reader list that the watcher thread is waiting on. */
+  size_t watchedGeneration;
+
+  /** Is the watcher thread blocked in `SCardGetStatusChange()`? */
+  BOOL waiting;
+
+  /** Does the Smart Card Service report PnP Notifications? */
+  BOOL pnpSupported;
+
+  /** Was any reader plugged in or unplugged, since the last check? */
+  BOOL readersChanged;
+
+  /** Should the watcher thread return? */
+  BOOL shouldStop;
+
+  /** Is the watcher thread still running? */
+  BOOL running;
+
+  /** Number of queued events. */
+  size_t eventsCount;
+
+  /** Number of allocated events. */
+  size_t eventsCapacity;
+
+  /** Queue of events, waiting to be taken by the main thread. */
+  SCardWatcherEvent *events;
+};
+
+/**
+ * @brief `SCardWatcher` constructor. Starts the watcher thread.
+ *
+ * @param[out] watcher Reference to an UNINITIALIZED `SCardWatcher` object.
+ * @param[in] wakeEvent Reference to a VALID event object, that will be
+ * signaled when some events are ready to be taken. It must outlive
+ * the `watcher` object.
+ * @param[in] database Reference to a VALID and CONSTANT `SCardReaderDB` object
+ * with the initial list of readers to watch.
+ * @return `TRUE` when the watcher thread is running, `FALSE` if any
+ * Smart Card error or system error has occurred.
+ *
+ * @note If the function returned `FALSE`, `watcher` shall NOT be destroyed.
+ */
+extern BOOL
+SCardWatcher_init(
+  _Out_ SCardWatcher *watcher,
+  _In_ os_specific_event_t *wakeEvent,
+  _In_ const SCardReaderDB *database);
+
+/**
+ * @brief `SCardWatcher` destructor. Stops the watcher thread.
+ *
+ * @param[in,out] watcher Reference to a VALID `SCardWatcher` object.
+ *
+ * @note After this call, `watcher` should not be used (unless re-initialized).
+ */
+extern VOID
+SCardWatcher_destroy(
+  _Inout_ SCardWatcher *watcher);
+
+/**
+ * @brief Replaces the list of readers to watch (after the Database
+ * was reloaded), and interrupts the blocking wait with `SCardCancel()`.
+ *
+ * @param[in,out] watcher Reference to a VALID `SCardWatcher` object.
+ * @param[in] database Reference to a VALID and CONSTANT `SCardReaderDB` object.
+ * @return `TRUE` on success, `FALSE` on memory allocation errors.
+ */
+extern BOOL
+SCardWatcher_setReaders(
+  _Inout_ SCardWatcher *watcher,
+  _In_ const SCardReaderDB *database);
+
+/**
+ * @brief Checks if the watcher thread has picked up the newest list
+ * of readers. If not, the wait is cancelled once more.
+ *
+ * @param[in,out] watcher Reference to a VALID `SCardWatcher` object.
+ * @return `TRUE` if the watcher thread is up to date, `FALSE` if this
+ * function should be called again after `WEBCARD_INTERVAL__WATCHER_RETRY`.
+ */
+extern BOOL
+SCardWatcher_synchronize(
+  _Inout_ SCardWatcher *watcher);
+
+/**
+ * @brief Checks if the watcher thread is able to detect plugging
+ * and unplugging of Smart Card Readers.
+ *
+ * @param[in,out] watcher Reference to a VALID `SCardWatcher` object.
+ * @return `TRUE` if the PnP Notifications are supported, `FALSE` if the list
+ * of readers should be fetched periodically (`WEBCARD_INTERVAL__READERS_FETCH`).
+ */
+extern BOOL
+SCardWatcher_hasPnpNotifications(
+  _Inout_ SCardWatcher *watcher);
+
+/**
+ * @brief Checks (and clears) the "readers changed" flag.
+ *
+ * @param[in,out] watcher Reference to a VALID `SCardWatcher` object.
+ * @return `TRUE` if the list of readers should be fetched again
+ * (some reader was plugged in or unplugged, or the Smart Card Context
+ * was re-established), otherwise `FALSE`.
+ */
+extern BOOL
+SCardWatcher_takeReadersChange(
+  _Inout_ SCardWatcher *watcher);
+
+/**
+ * @brief Takes all the queued events, that refer to the newest
+ * list of readers (outdated events are dropped).
+ *
+ * @param[in,out] watcher Reference to a VALID `SCardWatcher` object.
+ * @param[out] countRef Pointer to a location that receives
+ * the number of returned events.
+ * @return Array of events (to be released by the caller with `free()`),
+ * or `NULL` if there are no events.
+ */
+extern SCardWatcherEvent *
+SCardWatcher_takeEvents(
+  _Inout_ SCardWatcher *watcher,
+  _Out_ size_t *countRef);
+
+
 /**************************************************************/
 /* WEBCARD OPERATIONS                                         */
 /**************************************************************/
@@ -360,28 +1332,109 @@ WebCard_close(
   _In_ const SCARDCONTEXT context);
 
 /**
- * @brief Takes a stream of bytes, tries to create a JSON Object from it,
- * and then chooses appropriate path based on the JSON Request.
+ * @brief Takes a stream of bytes, tries to decode a WebCard Request from it,
+ * and then chooses appropriate path based on the requested command.
  *
  * @param[in,out] jsonStream Reference to a valid (preloaded) stream of bytes,
- * from which the `jsonRequest` is constructed.
- * @param[out] jsonRequest Reference to an UNITIALIZED `JsonObject` variable
- * that will hold the JSON Request (input command).
- * @param[out] jsonResponse Reference to an UNITIALIZED `JsonObject` variable
- * that will hold the JSON Response (output).
- * @param[in] database Reference to a VALID and CONSTANT `SCardReaderDB` object
+ * from which the `request` is decoded.
+ * @param[out] request Reference to an UNITIALIZED `WebCardRequest` variable
+ * that will hold the WebCard Request (input command).
+ * @param[in,out] database Reference to a VALID `SCardReaderDB` object
  * that holds the states of plugged-in Smart Card Readers.
- * @param[in] context A handle that identifies the resource manager context.
- * @note After this call, `jsonRequest` and `jsonResponse` will be initialized
- * and they must be released by the caller.
+ * @param[in,out] results Reference to a VALID `SCardWorkerResults` object.
+ * Requests addressed to a Smart Card Reader are passed to its Reader Worker,
+ * which queues the JSON Response here when the request is completed.
+ * @param[in,out] output Reference to a VALID `JsonOutputQueue` object,
+ * to which the JSON Response is written
+ * (for requests that are completed right away).
+ * @note After this call, `request` will be initialized
+ * and it must be released by the caller.
  */
 extern VOID
 WebCard_handleRequest(
   _Inout_ JsonByteStream *jsonStream,
-  _Out_ JsonObject *jsonRequest,
-  _Out_ JsonObject *jsonResponse,
-  _In_ const SCardReaderDB *database,
-  _In_ const SCARDCONTEXT context);
+  _Out_ WebCardRequest *request,
+  _Inout_ SCardReaderDB *database,
+  _Inout_ SCardWorkerResults *results,
+  _Inout_ JsonOutputQueue *output);
+
+/**
+ * @brief Starts writing a JSON Response, which repeats
+ * the "i" key (unique message identifier) of the WebCard Request.
+ *
+ * @param[out] writer Reference to an UNINITIALIZED `JsonWriter` object.
+ * @param[in,out] output Reference to a VALID `JsonOutputQueue` object.
+ * @param[in] request Reference to a VALID and CONSTANT `WebCardRequest`.
+ * @return `TRUE` on success, `FALSE` if the WebCard Request has no "i" key
+ * OR on memory allocation failure (nothing is written then,
+ * and `writer` ignores all the calls).
+ */
+extern BOOL
+WebCard_beginResponse(
+  _Out_ JsonWriter *writer,
+  _Inout_ JsonOutputQueue *output,
+  _In_ const WebCardRequest *request);
+
+/**
+ * @brief Marks a JSON Response with an optional key-value "incomplete=true",
+ * so that a JavaScript Promise is rejected instead of hanging.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ */
+extern VOID
+WebCard_markIncomplete(
+  _Inout_ JsonWriter *writer);
+
+/**
+ * @brief Marks a JSON Response with an optional key-value "cancelled=true".
+ * A request that did not run (or stopped early) should also be marked
+ * with `WebCard_markIncomplete`, after its partial results are rolled back.
+ *
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
+ */
+extern VOID
+WebCard_markCancelled(
+  _Inout_ JsonWriter *writer);
+
+/**
+ * @brief Executes one of the main WebCard commands, which cancels
+ * a pending request (sent to any Smart Card Reader).
+ *
+ * @param[in] request Reference to a VALID and CONSTANT `WebCardRequest` object
+ * that contains the identifier of the request to cancel ("t" key).
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object
+ * that will write `true` under the "d" (data) key if the request was found
+ * (it is going to be answered as cancelled), otherwise `false`.
+ * @param[in,out] database Reference to a VALID `SCardReaderDB` object
+ * that holds the Reader Workers.
+ * @param[out] cancelledJobRef Pointer to a location that receives
+ * the cancelled job, if it was still waiting in the queue
+ * (otherwise `NULL`). The caller must answer it (after finishing
+ * the current JSON Response) and release it.
+ * @return `TRUE` on success, `FALSE` on invalid parameters
+ * OR on memory allocation error.
+ */
+extern BOOL
+WebCard_cancelRequest(
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardReaderDB *database,
+  _Out_ SCardWorkerJob **cancelledJobRef);
+
+/**
+ * @brief Executes a job on the Reader Worker's thread.
+ *
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object.
+ * @param[in,out] job Reference to a VALID `SCardWorkerJob` object.
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object,
+ * which JSON Response (started with the "i" key) will be completed
+ * (or marked as incomplete).
+ */
+extern VOID
+WebCard_runJob(
+  _Inout_ SCardWorker *worker,
+  _Inout_ SCardWorkerJob *job,
+  _Inout_ JsonWriter *writer);
 
 /**
  * @brief Extracts UTF-8 name from given Smart Card Reader State.
@@ -419,156 +1472,174 @@ WebCard_pushReaderNameToJsonArray(
   _Inout_ JsonArray *jsonArray);
 
 /**
- * @brief Appends selected Reader's name to a given JSON Object under some key.
+ * @brief Writes selected Reader's name under some key.
  *
  * @param[in] readerState Reference to a read-only Reader State,
  * that contains the reader name property (`->szReader`).
- * @param[in,out] jsonObject Reference to a VALID `JsonObject` object,
- * under which the Reader's name will be appended.
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object,
+ * inside a JSON Object.
  * @param[in] key Case-sensitive and read-only UTF-8 text, that describes
  * the key under which Reader's name will be stored.
  * The key must end with a NULL-terminator!
  * @return `TRUE` on success, `FALSE` on memory allocation failure.
  */
 extern BOOL
-WebCard_pushReaderNameToJsonObject(
+WebCard_pushReaderNameToJsonWriter(
   _In_ const SCARD_READERSTATE *readerState,
-  _Inout_ JsonObject *jsonObject,
+  _Inout_ JsonWriter *writer,
   _In_ LPCSTR key);
 
 /**
- * @brief Gathers basic info about selected Smart Card Reader
- * into a JSON Object.
- *
- * Appends selected Reader's name ("n") and Reader's ATR ("a")
- * to a given JSON Object under predefined keys.
- * @param[in] readerState Reference to a read-only Reader State,
- * that contains the reader name property (`->szReader`)
- * and the "Answer To Reset" property (`->rgbAtr`).
- * @param[out] jsonReaderObject Reference to a VALID `JsonObject` object
- * (presumably empty, only initialized), that will hold the basic info
- * that uniquely identifies a Smart Card Reader connected to the OS.
- * @return `TRUE` on success, `FALSE` on memory allocation failure.
- *
- * @note `jsonReaderObject` must be released by the caller.
- */
-extern BOOL
-WebCard_convertReaderStateToJsonObject(
-  _In_ const SCARD_READERSTATE *readerState,
-  _Out_ JsonObject *jsonReaderObject);
-
-/**
- * @brief Appends selected Reader's ATR to a given JSON Object under some key.
+ * @brief Writes selected Reader's ATR under some key.
  *
  * @param[in] readerState Reference to a read-only Reader State,
  * that contains the "Answer To Reset" property (`->rgbAtr`).
- * @param[in,out] jsonObject Reference to a VALID `JsonObject` object,
- * under which the Reader's ATR will be appended.
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object,
+ * inside a JSON Object.
  * @param[in] key Case-sensitive and read-only UTF-8 text, that describes
  * the key under which Reader's ATR will be stored.
  * The key must end with a NULL-terminator!
  * @return `TRUE` on success, `FALSE` on memory allocation failure.
  */
 extern BOOL
-WebCard_pushReaderAtrToJsonObject(
+WebCard_pushReaderAtrToJsonWriter(
   _In_ const SCARD_READERSTATE *readerState,
-  _Inout_ JsonObject *jsonObject,
+  _Inout_ JsonWriter *writer,
   _In_ LPCSTR key);
 
 /**
- * @brief Gathers JSON Objects from each connected Smart Card Reader
- * and generates a JSON Array (list of readers and their states).
+ * @brief Executes one of the main WebCard commands, which gathers
+ * the list of all plugged-in Smart Card Readers.
  *
+ * Writes a JSON Array under the predefined "d" (data) key,
+ * with a JSON Object for each reader (its name "n" and ATR "a").
  * @param[in] database Reference to a VALID and CONSTANT `SCardReaderDB` object
  * that holds the states of plugged-in Smart Card Readers.
- * @param[out] jsonReadersArray Reference to an UNITIALIZED `JsonArray`
- * variable that will hold the reader states (each reader's name and ATR).
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object.
  * @return `TRUE` on success, `FALSE` on memory allocation failure.
- *
- * @note `jsonReadersArray` must be released by the caller.
  */
 extern BOOL
-WebCard_convertReaderStatesToJsonArray(
+WebCard_pushReadersListToJsonWriter(
   _In_ const SCardReaderDB *database,
-  _Out_ JsonArray *jsonReadersArray);
+  _Inout_ JsonWriter *writer);
 
 /**
- * @brief Executes one of the main WebCard commands, which gathers
- * the list of all plugged-in Smart Card Readers.
+ * @brief Checks the Smart Card Reader Index ("r") key of a WebCard Request.
  *
- * @param[in,out] jsonResponse Reference to a VALID `JsonObject` object
- * that will hold the list of Smart Card Reader states,
- * under the predefined "d" (data) key.
+ * @param[in] request Reference to a VALID and CONSTANT `WebCardRequest` object.
  * @param[in] database Reference to a VALID and CONSTANT `SCardReaderDB` object
  * that holds the states of plugged-in Smart Card Readers.
- * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ * @param[out] readerIndexRef Pointer to a location that receives the index.
+ * @return `TRUE` if the key holds a valid reader index, otherwise `FALSE`.
  */
 extern BOOL
-WebCard_pushReadersListToJsonResponse(
-  _Inout_ JsonObject *jsonResponse,
-  _In_ const SCardReaderDB *database);
+WebCard_getReaderIndex(
+  _In_ const WebCardRequest *request,
+  _In_ const SCardReaderDB *database,
+  _Out_ size_t *readerIndexRef);
 
 /**
  * @brief Executes one of the main WebCard commands, which attempts
  * to establish a connection from OS to the selected Smart Card Reader.
  *
- * @param[in] jsonRequest Reference to a VALID and CONSTANT `JsonObject` object
- * that contains the Smart Card Reader Index ("r") key
- * and the optional Share Mode parameter ("p") key.
- * @param[in,out] jsonResponse Reference to a VALID `JsonObject` object
- * that will hold the reader's ATR attribute (if any card is inserted,
+ * @param[in] request Reference to a VALID and CONSTANT `WebCardRequest` object
+ * that contains the optional Share Mode parameter ("p") key.
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object
+ * that will write the reader's ATR attribute (if any card is inserted,
  * otherwise empty text) under the predefined "d" (data) key.
- * @param[in] database Reference to a VALID and CONSTANT `SCardReaderDB` object
- * that holds the states of plugged-in Smart Card Readers.
- * @param[in] context A handle that identifies the resource manager context.
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object
+ * (called on the worker thread).
+ * @param[in] readerState Reference to a read-only Reader State,
+ * that contains the "Answer To Reset" property (`->rgbAtr`).
  * @return `TRUE` when a connection was successfully established,
  * `FALSE` on invalid parameters OR on any internal Smart Card error.
  */
 extern BOOL
 WebCard_tryConnectingToReader(
-  _In_ const JsonObject *jsonRequest,
-  _Inout_ JsonObject *jsonResponse,
-  _In_ const SCardReaderDB *database,
-  _In_ const SCARDCONTEXT context);
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardWorker *worker,
+  _In_ const SCARD_READERSTATE *readerState);
 
 /**
  * @brief Executes one of the main WebCard commands, which attempts
  * to close the connection from OS to the selected Smart Card Reader.
  *
- * @param[in] jsonRequest Reference to a VALID and CONSTANT `JsonObject` object
- * that contains the Smart Card Reader Index ("r") key.
- * @param[in] database Reference to a VALID and CONSTANT `SCardReaderDB` object
- * that holds the states of plugged-in Smart Card Readers.
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object
+ * (called on the worker thread).
  * @return `TRUE` when the connection was closed,
- * `FALSE` on invalid parameters.
+ * `FALSE` on any internal Smart Card error.
  */
 extern BOOL
 WebCard_tryDisconnectingFromReader(
-  _In_ const JsonObject *jsonRequest,
-  _In_ const SCardReaderDB *database);
+  _Inout_ SCardWorker *worker);
 
 /**
  * @brief Executes one of the main WebCard commands, which attempts to transmit
  * and receive APDUs between the OS and the selected Smart Card Reader.
  *
- * @param[in] jsonRequest Reference to a VALID and CONSTANT `JsonObject` object
- * that contains the Smart Card Reader Index ("r") key, and the
- * Application Prodotol Data Unit ("APDU") hex-string under the "a" key.
- * @param[in,out] jsonResponse Reference to a VALID `JsonObject` object
- * that will hold the Smart Card's APDU response under the "d" (data) key.
- * @param[in] database Reference to a VALID and CONSTANT `SCardReaderDB` object
- * that holds the states of plugged-in Smart Card Readers.
+ * @param[in] request Reference to a VALID and CONSTANT `WebCardRequest` object
+ * that contains the Application Prodotol Data Unit ("APDU") hex-string
+ * under the "a" key (or the APDU in Base64 under the "b" key).
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object
+ * that will write the Smart Card's APDU response under the "d" (data) key
+ * (in the same encoding as the APDU).
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object
+ * (called on the worker thread).
  * @return `TRUE` on success, `FALSE` on invalid parameters
  * OR on memory allocation error OR on any internal Smart Card error.
  */
 extern BOOL
 WebCard_transmitAndReceive(
-  _In_ const JsonObject *jsonRequest,
-  _Inout_ JsonObject *jsonResponse,
-  _In_ const SCardReaderDB *database);
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardWorker *worker);
+
+/**
+ * @brief Executes one of the main WebCard commands, which transmits a list
+ * of APDUs, one after another, within a single Smart Card transaction.
+ *
+ * @param[in] request Reference to a VALID and CONSTANT `WebCardRequest` object
+ * that contains an array of APDU hex-strings under the "a" key
+ * (or an array of APDUs in Base64 under the "b" key), and the optional
+ * "stop on the first status word other than 9000" flag under the "s" key.
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object
+ * that will write an array of the Smart Card's APDU responses
+ * under the "d" (data) key (shorter than the input array,
+ * if the batch was stopped).
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object
+ * (called on the worker thread).
+ * @return `TRUE` on success, `FALSE` on invalid parameters
+ * OR on memory allocation error OR on any internal Smart Card error.
+ */
+extern BOOL
+WebCard_transmitBatch(
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardWorker *worker);
 
 /**
- * @brief Sends selected Reader Event to the Standard Output.
+ * @brief Executes one of the main WebCard commands, which runs
+ * an APDU Script within a single Smart Card transaction
+ * (see `SCardScript`).
+ *
+ * @param[in] request Reference to a VALID and CONSTANT `WebCardRequest` object
+ * that contains an array of script steps under the "a" key.
+ * @param[in,out] writer Reference to a VALID `JsonWriter` object
+ * that will write all the script variables under the "d" (data) key.
+ * @param[in,out] worker Reference to a VALID `SCardWorker` object
+ * (called on the worker thread).
+ * @return `TRUE` on success, `FALSE` on invalid parameters
+ * OR on memory allocation error OR on any internal Smart Card error.
+ */
+extern BOOL
+WebCard_runScript(
+  _In_ const WebCardRequest *request,
+  _Inout_ JsonWriter *writer,
+  _Inout_ SCardWorker *worker);
+
+/**
+ * @brief Queues selected Reader Event for the Standard Output.
  *
  * The Reader Event can contain information about:
  * -> new card connected to some given reader (index, ATR);
@@ -586,34 +1657,68 @@ WebCard_transmitAndReceive(
  * "Card Insertion" and "Card Removal". It is ignored if `reader` is `NULL`.
  * @param[in] readerEvent Type of the event fired from WebCard
  * to the Standard Output;
- * @param[out] jsonResponse Reference to an UNITIALIZED `JsonObject` variable
- * that will hold the JSON Response (output).
  * @param[in] jsonEventDetails Reference to a VALID and CONSTANT `JsonArray`
  * object, that holds the names of affected Smard Card Readers. It has
  * no meaning for events other than "More Readers" and "Less Readers".
  * This parameter is optional (can be `NULL`).
- *
- * @note `jsonResponse` must be released by the caller.
+ * @param[in,out] output Reference to a VALID `JsonOutputQueue` object,
+ * to which the JSON Response is written.
  */
 extern VOID
 WebCard_sendReaderEvent(
   _In_opt_ const SCARD_READERSTATE *readerState,
   _In_ const size_t readerIndex,
   _In_ const int readerEvent,
-  _Out_ JsonObject *jsonResponse,
-  _In_opt_ const JsonArray *jsonEventDetails);
+  _In_opt_ const JsonArray *jsonEventDetails,
+  _Inout_ JsonOutputQueue *output);
+
+/**
+ * @brief Compares the current and the new state of selected Reader
+ * (ICC connected/disconnected), queues a Reader Event for Standard Output,
+ * and then accepts the new state as current.
+ *
+ * @param[in,out] database Reference to a VALID `SCardReaderDB` object.
+ * @param[in] readerIndex Zero-based index of the Reader, which has
+ * the `dwEventState` field already updated.
+ * @param[in,out] output Reference to a VALID `JsonOutputQueue` object.
+ */
+extern VOID
+WebCard_handleReaderStateChange(
+  _Inout_ SCardReaderDB *database,
+  _In_ const size_t readerIndex,
+  _Inout_ JsonOutputQueue *output);
 
 /**
  * @brief Checks if any Reader changed status (ICC connected/disconnected),
- * then sends a Reader Event to Standard Output.
+ * then queues a Reader Event for Standard Output.
  *
+ * This does not wait for any changes. It is used to catch up
+ * right after the Database was (re)loaded, while the Reader Watcher
+ * takes care of all the following changes.
  * @param[in,out] database Reference to a VALID `SCardReaderDB` object.
  * @param[in] context A handle that identifies the resource manager context.
+ * @param[in,out] output Reference to a VALID `JsonOutputQueue` object.
  */
 extern VOID
 WebCard_handleStatusChange(
   _Inout_ SCardReaderDB *database,
-  _In_ const SCARDCONTEXT context);
+  _In_ const SCARDCONTEXT context,
+  _Inout_ JsonOutputQueue *output);
+
+/**
+ * @brief Applies Reader States queued by the Reader Watcher,
+ * queueing Reader Events for Standard Output.
+ *
+ * @param[in,out] database Reference to a VALID `SCardReaderDB` object.
+ * @param[in,out] watcher Reference to a VALID `SCardWatcher` object,
+ * which watches the same list of readers as `database` holds.
+ * @param[in,out] output Reference to a VALID `JsonOutputQueue` object.
+ */
+extern VOID
+WebCard_handleWatcherEvents(
+  _Inout_ SCardReaderDB *database,
+  _Inout_ SCardWatcher *watcher,
+  _Inout_ JsonOutputQueue *output);
 
 
 /**************************************************************/
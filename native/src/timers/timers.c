@@ -0,0 +1,249 @@
+/**
+ * @file "native/src/timers/timers.c"
+ * Scheduling of delayed and periodic work, measured with a monotonic clock.
+ */
+
+#include "timers/timers.h"
+
+/**************************************************************/
+
+/**
+ * @brief Moves an entry towards the root, until the heap order is restored.
+ *
+ * @param[in,out] heap Reference to a VALID `TimerHeap` object.
+ * @param[in] index Index of the entry that could be too far from the root.
+ */
+static VOID
+TimerHeap_siftUp(
+  _Inout_ TimerHeap *heap,
+  _In_ size_t index)
+{
+  TimerEntry entry = heap->entries[index];
+  size_t parent;
+
+  while (index > 0)
+  {
+    parent = (index - 1) / 2;
+
+    if (heap->entries[parent].deadline <= entry.deadline) { break; }
+
+    heap->entries[index] = heap->entries[parent];
+    index = parent;
+  }
+
+  heap->entries[index] = entry;
+}
+
+/**************************************************************/
+
+/**
+ * @brief Moves an entry towards the leaves, until the heap order is restored.
+ *
+ * @param[in,out] heap Reference to a VALID `TimerHeap` object.
+ * @param[in] index Index of the entry that could be too close to the root.
+ */
+static VOID
+TimerHeap_siftDown(
+  _Inout_ TimerHeap *heap,
+  _In_ size_t index)
+{
+  TimerEntry entry = heap->entries[index];
+  size_t child;
+
+  while (TRUE)
+  {
+    child = (2 * index) + 1;
+
+    if (child >= heap->count) { break; }
+
+    if (((child + 1) < heap->count) &&
+      (heap->entries[child + 1].deadline < heap->entries[child].deadline))
+    {
+      child += 1;
+    }
+
+    if (entry.deadline <= heap->entries[child].deadline) { break; }
+
+    heap->entries[index] = heap->entries[child];
+    index = child;
+  }
+
+  heap->entries[index] = entry;
+}
+
+/**************************************************************/
+
+/**
+ * @brief Removes an entry from any position of the heap.
+ *
+ * @param[in,out] heap Reference to a VALID `TimerHeap` object.
+ * @param[in] index Index of the removed entry.
+ */
+static VOID
+TimerHeap_removeAt(
+  _Inout_ TimerHeap *heap,
+  _In_ const size_t index)
+{
+  heap->count -= 1;
+
+  if (index == heap->count) { return; }
+
+  /* Fill the gap with the last entry, which can go either way */
+
+  heap->entries[index] = heap->entries[heap->count];
+
+  TimerHeap_siftDown(heap, index);
+  TimerHeap_siftUp(heap, index);
+}
+
+/**************************************************************/
+
+VOID
+TimerHeap_init(
+  _Out_ TimerHeap *heap)
+{
+  heap->count = 0;
+  heap->capacity = 0;
+  heap->entries = NULL;
+  heap->nextId = 1;
+}
+
+/**************************************************************/
+
+VOID
+TimerHeap_destroy(
+  _Inout_ TimerHeap *heap)
+{
+  if (NULL != heap->entries)
+  {
+    free(heap->entries);
+  }
+}
+
+/**************************************************************/
+
+size_t
+TimerHeap_schedule(
+  _Inout_ TimerHeap *heap,
+  _In_ const uint32_t delay,
+  _In_ const uint32_t interval,
+  _In_ timer_callback_t callback,
+  _In_opt_ LPVOID param)
+{
+  size_t new_capacity;
+  TimerEntry *entry;
+
+  if (heap->count >= heap->capacity)
+  {
+    new_capacity = Misc_nextPowerOfTwo(1 + heap->count);
+
+    entry = realloc(
+      heap->entries,
+      sizeof(TimerEntry) * new_capacity);
+
+    if (NULL == entry) { return 0; }
+
+    heap->entries = entry;
+    heap->capacity = new_capacity;
+  }
+
+  entry = &(heap->entries[heap->count]);
+
+  entry->deadline = OSSpecific_getMonotonicTime() + delay;
+  entry->interval = interval;
+  entry->id = heap->nextId;
+  entry->callback = callback;
+  entry->param = param;
+
+  heap->nextId += 1;
+  heap->count += 1;
+
+  TimerHeap_siftUp(heap, heap->count - 1);
+
+  return (heap->nextId - 1);
+}
+
+/**************************************************************/
+
+BOOL
+TimerHeap_cancel(
+  _Inout_ TimerHeap *heap,
+  _In_ const size_t id)
+{
+  size_t i;
+
+  for (i = 0; i < heap->count; i++)
+  {
+    if (id == heap->entries[i].id)
+    {
+      TimerHeap_removeAt(heap, i);
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**************************************************************/
+
+uint32_t
+TimerHeap_getTimeout(
+  _In_ const TimerHeap *heap,
+  _In_ const uint64_t now)
+{
+  uint64_t remaining;
+
+  if (0 == heap->count)
+  {
+    return OS_SPECIFIC_INFINITE;
+  }
+
+  if (heap->entries[0].deadline <= now)
+  {
+    return 0;
+  }
+
+  remaining = heap->entries[0].deadline - now;
+
+  return (remaining < OS_SPECIFIC_INFINITE) ?
+    (uint32_t) remaining :
+    (OS_SPECIFIC_INFINITE - 1);
+}
+
+/**************************************************************/
+
+VOID
+TimerHeap_runExpired(
+  _Inout_ TimerHeap *heap,
+  _In_ const uint64_t now)
+{
+  TimerEntry expired;
+
+  while ((heap->count > 0) && (heap->entries[0].deadline <= now))
+  {
+    /* Update the heap before the callback, */
+    /* which is free to schedule or cancel timers */
+
+    expired = heap->entries[0];
+
+    if (0 != expired.interval)
+    {
+      heap->entries[0].deadline += expired.interval;
+
+      if (heap->entries[0].deadline <= now)
+      {
+        heap->entries[0].deadline = now + expired.interval;
+      }
+
+      TimerHeap_siftDown(heap, 0);
+    }
+    else
+    {
+      TimerHeap_removeAt(heap, 0);
+    }
+
+    expired.callback(expired.param);
+  }
+}
+
+/**************************************************************/
@@ -0,0 +1,165 @@
+/**
+ * @file "native/src/timers/timers.h"
+ * Scheduling of delayed and periodic work, measured with a monotonic clock.
+ */
+
+#ifndef H_WEBCARD__TIMERS
+#define H_WEBCARD__TIMERS
+
+#include "os_specific/os_specific.h"
+#include "misc/misc.h"
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+
+
+/**************************************************************/
+/* TIMER HEAP                                                 */
+/**************************************************************/
+
+/**
+ * Function called when a timer expires.
+ * Receives the `param` passed to `TimerHeap_schedule`.
+ */
+typedef VOID (*timer_callback_t)(_In_opt_ LPVOID param);
+
+/**
+ * `TimerEntry` type definition.
+ */
+typedef struct TimerEntry TimerEntry;
+
+/**
+ * One scheduled timer.
+ */
+struct TimerEntry
+{
+  /** Monotonic time (in milliseconds) when the timer expires. */
+  uint64_t deadline;
+
+  /** Period (in milliseconds) of a repeating timer, `0` for a one-shot timer. */
+  uint32_t interval;
+
+  /** Unique identifier, used for cancelling. */
+  size_t id;
+
+  /** Function called on expiry. */
+  timer_callback_t callback;
+
+  /** Custom parameter passed to `callback`. */
+  LPVOID param;
+};
+
+/**
+ * `TimerHeap` type definition.
+ */
+typedef struct TimerHeap TimerHeap;
+
+/**
+ * Binary min-heap of timers, ordered by their deadlines.
+ * The main loop sleeps until the first deadline, then runs
+ * the expired timers.
+ */
+struct TimerHeap
+{
+  /** Number of scheduled timers. */
+  size_t count;
+
+  /** Number of allocated entries. */
+  size_t capacity;
+
+  /** Heap array (the earliest deadline at index zero). */
+  TimerEntry *entries;
+
+  /** Identifier for the next scheduled timer. */
+  size_t nextId;
+};
+
+/**
+ * @brief `TimerHeap` constructor.
+ *
+ * @param[out] heap Reference to an UNINITIALIZED `TimerHeap` object.
+ */
+extern VOID
+TimerHeap_init(
+  _Out_ TimerHeap *heap);
+
+/**
+ * @brief `TimerHeap` destructor. Pending timers are dropped.
+ *
+ * @param[in,out] heap Reference to a VALID `TimerHeap` object.
+ *
+ * @note After this call, `heap` should not be used (unless re-initialized).
+ */
+extern VOID
+TimerHeap_destroy(
+  _Inout_ TimerHeap *heap);
+
+/**
+ * @brief Schedules a new timer.
+ *
+ * @param[in,out] heap Reference to a VALID `TimerHeap` object.
+ * @param[in] delay Number of milliseconds (from now) until the first expiry.
+ * @param[in] interval Period of a repeating timer (in milliseconds),
+ * or `0` for a one-shot timer.
+ * @param[in] callback Function called on every expiry.
+ * @param[in] param Custom parameter passed to the `callback`.
+ * @return Timer identifier (never zero), or `0` on memory allocation failure.
+ */
+extern size_t
+TimerHeap_schedule(
+  _Inout_ TimerHeap *heap,
+  _In_ const uint32_t delay,
+  _In_ const uint32_t interval,
+  _In_ timer_callback_t callback,
+  _In_opt_ LPVOID param);
+
+/**
+ * @brief Removes a pending timer.
+ *
+ * @param[in,out] heap Reference to a VALID `TimerHeap` object.
+ * @param[in] id Timer identifier returned by `TimerHeap_schedule`.
+ * @return `TRUE` if the timer was removed, `FALSE` if no such timer
+ * is pending (one-shot timer already expired, or invalid identifier).
+ */
+extern BOOL
+TimerHeap_cancel(
+  _Inout_ TimerHeap *heap,
+  _In_ const size_t id);
+
+/**
+ * @brief Calculates how long the main loop may sleep.
+ *
+ * @param[in] heap Reference to a VALID and CONSTANT `TimerHeap` object.
+ * @param[in] now Current monotonic time (`OSSpecific_getMonotonicTime`).
+ * @return Number of milliseconds until the earliest deadline
+ * (`0` if some timer has already expired), or `OS_SPECIFIC_INFINITE`
+ * if there are no timers.
+ */
+extern uint32_t
+TimerHeap_getTimeout(
+  _In_ const TimerHeap *heap,
+  _In_ const uint64_t now);
+
+/**
+ * @brief Calls the callbacks of all expired timers. Repeating timers
+ * are re-scheduled (without catching up on missed periods),
+ * one-shot timers are removed.
+ *
+ * Callbacks may schedule or cancel timers (including their own).
+ * @param[in,out] heap Reference to a VALID `TimerHeap` object.
+ * @param[in] now Current monotonic time (`OSSpecific_getMonotonicTime`).
+ */
+extern VOID
+TimerHeap_runExpired(
+  _Inout_ TimerHeap *heap,
+  _In_ const uint64_t now);
+
+
+/**************************************************************/
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif  /* H_WEBCARD__TIMERS */
@@ -6,6 +6,84 @@
 #include "utf/utf.h"
 #include "misc/misc.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+  #include <immintrin.h>
+#elif defined(__aarch64__)
+  #include <arm_neon.h>
+#endif
+
+/**
+ * Finds the first byte (in a given text) that is not an ASCII character.
+ * Returns the offset of that byte, or `length` when the whole text is ASCII.
+ */
+typedef size_t (*utf8_ascii_scanner_t)(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length);
+
+/**
+ * Writes two uppercase hexadecimal digits for every given byte
+ * (`2 * count` characters, without a NULL-terminator).
+ */
+typedef VOID (*utf8_hex_encoder_t)(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count);
+
+/**
+ * Decodes pairs of hexadecimal digits into bytes (`count` bytes from
+ * `2 * count` characters). Returns the index of the first pair that
+ * is not made of two hexadecimal digits, or `count` on success.
+ */
+typedef size_t (*utf8_hex_decoder_t)(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count);
+
+/**
+ * Writes four Base64 characters for every group of three bytes
+ * (`4 * count` characters, without padding and a NULL-terminator).
+ */
+typedef VOID (*utf8_base64_encoder_t)(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count);
+
+/**
+ * Decodes groups of four Base64 characters into bytes (`3 * count` bytes
+ * from `4 * count` characters, without padding). Returns the index
+ * of the first group with a character outside of the Base64 alphabet,
+ * or `count` on success.
+ */
+typedef size_t (*utf8_base64_decoder_t)(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count);
+
+/**
+ * Hexadecimal digits, indexed by the nibble value.
+ */
+static const BYTE utf8_hex_digits[16] = {
+  '0', '1', '2', '3', '4', '5', '6', '7',
+  '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+/**
+ * Base64 alphabet (RFC 4648), indexed by the 6-bit value.
+ */
+static const BYTE utf8_base64_alphabet[64] = {
+  'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
+  'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+  'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
+  'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
+};
+
+/**
+ * How many bytes `UTF16String_pushBytesAsHex` encodes at once
+ * (on the stack, before widening the digits).
+ */
+#define UTF16_HEX__CHUNK_SIZE  256
+
 /**************************************************************/
 
 VOID
@@ -23,7 +101,9 @@ VOID
 UTF8String_destroy(
   _Inout_ UTF8String *string)
 {
-  if (NULL != string->text)
+  /* Borrowed views (zero capacity) do not own their text */
+
+  if ((NULL != string->text) && (0 != string->capacity))
   {
     free(string->text);
   }
@@ -52,8 +132,22 @@ UTF8String_assertCapacity(
     newCapacity = Misc_nextPowerOfTwo(newCapacity - 1);
 
     const size_t newByteSize = sizeof(BYTE) * newCapacity;
-    LPBYTE newText = realloc(string->text, newByteSize);
-    if (NULL == newText) { return FALSE; }
+    LPBYTE newText;
+
+    if ((0 == string->capacity) && (NULL != string->text))
+    {
+      /* Borrowed view: the text must be copied before any changes */
+
+      newText = malloc(newByteSize);
+      if (NULL == newText) { return FALSE; }
+
+      memcpy(newText, string->text, sizeof(BYTE) * string->length);
+    }
+    else
+    {
+      newText = realloc(string->text, newByteSize);
+      if (NULL == newText) { return FALSE; }
+    }
 
     string->text = newText;
     string->capacity = newCapacity;
@@ -76,7 +170,7 @@ UTF8String_copy(
   }
 
   const size_t capacity = Misc_nextPowerOfTwo(source->length);
-  const size_t minByteSize = sizeof(BYTE) * (1 + source->length);
+  const size_t minByteSize = sizeof(BYTE) * source->length;
   const size_t maxByteSize = sizeof(BYTE) * capacity;
 
   destination->length = source->length;
@@ -85,7 +179,10 @@ UTF8String_copy(
   destination->text = malloc(maxByteSize);
   if (NULL == destination->text) { return FALSE; }
 
+  /* The source can be a view (without a NULL-terminator) */
+
   memcpy(destination->text, source->text, minByteSize);
+  destination->text[destination->length] = '\0';
   return TRUE;
 }
 
@@ -96,121 +193,1616 @@ UTF8String_makeTemporary(
   _Out_ UTF8String *string,
   _In_ LPCSTR text)
 {
-  string->length = strlen(text);
-  string->capacity = Misc_nextPowerOfTwo(string->length);
+  UTF8String_makeView(string, (const BYTE *) text, strlen(text));
+}
+
+/**************************************************************/
+
+VOID
+UTF8String_makeView(
+  _Out_ UTF8String *string,
+  _In_ const BYTE *text,
+  _In_ const size_t length)
+{
+  string->length = length;
+  string->capacity = 0;
   string->text = (LPBYTE) text;
 }
 
 /**************************************************************/
 
-BOOL
-UTF8String_pushByte(
-  _Inout_ UTF8String *string,
-  _In_ const BYTE byte)
+BOOL
+UTF8String_pushByte(
+  _Inout_ UTF8String *string,
+  _In_ const BYTE byte)
+{
+  if (!UTF8String_assertCapacity(string, 1))
+  {
+    return FALSE;
+  }
+
+  string->text[string->length] = byte;
+  string->length += 1;
+  string->text[string->length] = '\0';
+
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for hexadecimal encoding.
+ * Encodes one byte at a time, with a lookup table (generic version).
+ *
+ * @param[out] text Output characters (`2 * count` bytes).
+ * @param[in] bytes Encoded bytes.
+ * @param[in] count Number of bytes to encode.
+ */
+static VOID
+UTF8_encodeHexBytes(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  size_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    text[2 * i]     = utf8_hex_digits[bytes[i] >> 4];
+    text[2 * i + 1] = utf8_hex_digits[bytes[i] & 0x0F];
+  }
+}
+
+/**************************************************************/
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief A private method for hexadecimal encoding.
+ * Encodes 16 bytes at a time (SSSE3 version).
+ *
+ * @param[out] text Output characters (`2 * count` bytes).
+ * @param[in] bytes Encoded bytes.
+ * @param[in] count Number of bytes to encode.
+ */
+__attribute__((target("ssse3")))
+static VOID
+UTF8_encodeHexSsse3(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  const __m128i digits = _mm_loadu_si128((const __m128i *) utf8_hex_digits);
+  const __m128i low_mask = _mm_set1_epi8(0x0F);
+  __m128i chunk, high, low;
+  size_t i;
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    chunk = _mm_loadu_si128((const __m128i *) &(bytes[i]));
+
+    /* Nibbles are replaced with digits by a byte shuffle */
+
+    high = _mm_shuffle_epi8(
+      digits,
+      _mm_and_si128(_mm_srli_epi16(chunk, 4), low_mask));
+
+    low = _mm_shuffle_epi8(
+      digits,
+      _mm_and_si128(chunk, low_mask));
+
+    _mm_storeu_si128(
+      (__m128i *) &(text[2 * i]),
+      _mm_unpacklo_epi8(high, low));
+
+    _mm_storeu_si128(
+      (__m128i *) &(text[2 * i + 16]),
+      _mm_unpackhi_epi8(high, low));
+  }
+
+  UTF8_encodeHexBytes(&(text[2 * i]), &(bytes[i]), (count - i));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for hexadecimal encoding.
+ * Encodes 32 bytes at a time (AVX2 version).
+ *
+ * @param[out] text Output characters (`2 * count` bytes).
+ * @param[in] bytes Encoded bytes.
+ * @param[in] count Number of bytes to encode.
+ */
+__attribute__((target("avx2")))
+static VOID
+UTF8_encodeHexAvx2(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  const __m256i digits = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128((const __m128i *) utf8_hex_digits));
+  const __m256i low_mask = _mm256_set1_epi8(0x0F);
+  __m256i chunk, high, low, first, second;
+  size_t i;
+
+  for (i = 0; (i + 32) <= count; i += 32)
+  {
+    chunk = _mm256_loadu_si256((const __m256i *) &(bytes[i]));
+
+    high = _mm256_shuffle_epi8(
+      digits,
+      _mm256_and_si256(_mm256_srli_epi16(chunk, 4), low_mask));
+
+    low = _mm256_shuffle_epi8(
+      digits,
+      _mm256_and_si256(chunk, low_mask));
+
+    /* Interleaving works within 128-bit lanes, */
+    /* so the lanes are put back in order afterwards */
+
+    first = _mm256_unpacklo_epi8(high, low);
+    second = _mm256_unpackhi_epi8(high, low);
+
+    _mm256_storeu_si256(
+      (__m256i *) &(text[2 * i]),
+      _mm256_permute2x128_si256(first, second, 0x20));
+
+    _mm256_storeu_si256(
+      (__m256i *) &(text[2 * i + 32]),
+      _mm256_permute2x128_si256(first, second, 0x31));
+  }
+
+  UTF8_encodeHexSsse3(&(text[2 * i]), &(bytes[i]), (count - i));
+}
+
+#elif defined(__aarch64__)
+
+/**
+ * @brief A private method for hexadecimal encoding.
+ * Encodes 16 bytes at a time (NEON version).
+ *
+ * @param[out] text Output characters (`2 * count` bytes).
+ * @param[in] bytes Encoded bytes.
+ * @param[in] count Number of bytes to encode.
+ */
+static VOID
+UTF8_encodeHexNeon(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  const uint8x16_t digits = vld1q_u8(utf8_hex_digits);
+  uint8x16_t chunk;
+  uint8x16x2_t pairs;
+  size_t i;
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    chunk = vld1q_u8(&(bytes[i]));
+
+    pairs.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(chunk, 4));
+    pairs.val[1] = vqtbl1q_u8(digits, vandq_u8(chunk, vdupq_n_u8(0x0F)));
+
+    /* Interleaving store */
+
+    vst2q_u8(&(text[2 * i]), pairs);
+  }
+
+  UTF8_encodeHexBytes(&(text[2 * i]), &(bytes[i]), (count - i));
+}
+
+#endif
+
+/**************************************************************/
+
+static VOID
+UTF8_selectHexEncoder(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count);
+
+/**
+ * Encoder used by `UTF8String_pushBytesAsHex` and
+ * `UTF16String_pushBytesAsHex`.
+ * The first call picks the fastest version supported by the processor
+ * (see `utf8_ascii_scanner`).
+ */
+static utf8_hex_encoder_t utf8_hex_encoder = UTF8_selectHexEncoder;
+
+/**
+ * @brief A private method for hexadecimal encoding.
+ * Selects the encoder (on first use), and then encodes the bytes.
+ *
+ * @param[out] text Output characters (`2 * count` bytes).
+ * @param[in] bytes Encoded bytes.
+ * @param[in] count Number of bytes to encode.
+ */
+static VOID
+UTF8_selectHexEncoder(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  utf8_hex_encoder_t encoder = UTF8_encodeHexBytes;
+
+  #if defined(__x86_64__) || defined(__i386__)
+  {
+    const uint32_t features = Misc_getCpuFeatures();
+
+    if (MISC_CPU_FEATURE__AVX2 & features)
+    {
+      encoder = UTF8_encodeHexAvx2;
+    }
+    else if (MISC_CPU_FEATURE__SSSE3 & features)
+    {
+      encoder = UTF8_encodeHexSsse3;
+    }
+  }
+  #elif defined(__aarch64__)
+  {
+    encoder = UTF8_encodeHexNeon;
+  }
+  #endif
+
+  utf8_hex_encoder = encoder;
+
+  encoder(text, bytes, count);
+}
+
+/**************************************************************/
+
+BOOL
+UTF8String_pushBytesAsHex(
+  _Inout_ UTF8String *string,
+  _In_ size_t byteArraySize,
+  _In_ const BYTE *bytes)
+{
+  if (!UTF8String_assertCapacity(string, (2 * byteArraySize)))
+  {
+    return FALSE;
+  }
+
+  utf8_hex_encoder(&(string->text[string->length]), bytes, byteArraySize);
+
+  string->length += 2 * byteArraySize;
+  string->text[string->length] = '\0';
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Converts one hexadecimal digit (either case) into its value.
+ *
+ * @param[in] digit Character to convert.
+ * @return Value from 0 to 15, or `0xFF` if `digit` is not
+ * a hexadecimal digit.
+ */
+static BYTE
+UTF8_decodeHexDigit(
+  _In_ BYTE digit)
+{
+  if ((BYTE) (digit - '0') <= 9)
+  {
+    return (digit - '0');
+  }
+
+  digit |= 0x20;  /* Lowercase */
+
+  if ((BYTE) (digit - 'a') <= 5)
+  {
+    return (digit - 'a' + 0x0A);
+  }
+
+  return 0xFF;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Decodes one byte at a time (generic version).
+ *
+ * @param[out] output Decoded bytes.
+ * @param[in] text Hexadecimal digits (`2 * count` characters).
+ * @param[in] count Number of bytes to decode.
+ * @return Index of the first invalid pair of digits, or `count`.
+ */
+static size_t
+UTF8_decodeHexBytes(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  BYTE high, low;
+  size_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    high = UTF8_decodeHexDigit(text[2 * i]);
+    low = UTF8_decodeHexDigit(text[2 * i + 1]);
+
+    if ((0xFF == high) || (0xFF == low))
+    {
+      break;
+    }
+
+    output[i] = (BYTE) ((high << 4) | low);
+  }
+
+  return i;
+}
+
+/**************************************************************/
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Converts 16 hexadecimal digits into their values (SSSE3 version).
+ *
+ * @param[in] chunk Characters to convert.
+ * @param[out] invalidRef Receives `0xFF` for every character
+ * that is not a hexadecimal digit.
+ * @return Values of the digits (undefined for the invalid characters).
+ */
+__attribute__((target("ssse3")))
+static __m128i
+UTF8_decodeHexDigitsSsse3(
+  _In_ const __m128i chunk,
+  _Out_ __m128i *invalidRef)
+{
+  const __m128i digit = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+  const __m128i letter = _mm_sub_epi8(
+    _mm_or_si128(chunk, _mm_set1_epi8(0x20)),
+    _mm_set1_epi8('a'));
+
+  /* Unsigned "less or equal" (the minimum is the value itself) */
+
+  const __m128i is_digit = _mm_cmpeq_epi8(
+    _mm_min_epu8(digit, _mm_set1_epi8(9)),
+    digit);
+  const __m128i is_letter = _mm_cmpeq_epi8(
+    _mm_min_epu8(letter, _mm_set1_epi8(5)),
+    letter);
+
+  invalidRef[0] = _mm_andnot_si128(
+    _mm_or_si128(is_digit, is_letter),
+    _mm_set1_epi8(-1));
+
+  return _mm_or_si128(
+    _mm_and_si128(is_digit, digit),
+    _mm_andnot_si128(
+      is_digit,
+      _mm_add_epi8(letter, _mm_set1_epi8(0x0A))));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Decodes 16 bytes at a time (SSSE3 version).
+ *
+ * @param[out] output Decoded bytes.
+ * @param[in] text Hexadecimal digits (`2 * count` characters).
+ * @param[in] count Number of bytes to decode.
+ * @return Index of the first invalid pair of digits, or `count`.
+ */
+__attribute__((target("ssse3")))
+static size_t
+UTF8_decodeHexSsse3(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  /* Every pair of values becomes `16 * high + low` */
+
+  const __m128i weights = _mm_set1_epi16(0x0110);
+  __m128i first, second, invalid_first, invalid_second;
+  size_t i;
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    first = UTF8_decodeHexDigitsSsse3(
+      _mm_loadu_si128((const __m128i *) &(text[2 * i])),
+      &(invalid_first));
+
+    second = UTF8_decodeHexDigitsSsse3(
+      _mm_loadu_si128((const __m128i *) &(text[2 * i + 16])),
+      &(invalid_second));
+
+    if (0 != _mm_movemask_epi8(_mm_or_si128(invalid_first, invalid_second)))
+    {
+      break;
+    }
+
+    _mm_storeu_si128(
+      (__m128i *) &(output[i]),
+      _mm_packus_epi16(
+        _mm_maddubs_epi16(first, weights),
+        _mm_maddubs_epi16(second, weights)));
+  }
+
+  /* The remaining bytes (or the invalid chunk) are decoded one by one */
+
+  return i + UTF8_decodeHexBytes(&(output[i]), &(text[2 * i]), (count - i));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Converts 32 hexadecimal digits into their values (AVX2 version).
+ *
+ * @param[in] chunk Characters to convert.
+ * @param[out] invalidRef Receives `0xFF` for every character
+ * that is not a hexadecimal digit.
+ * @return Values of the digits (undefined for the invalid characters).
+ */
+__attribute__((target("avx2")))
+static __m256i
+UTF8_decodeHexDigitsAvx2(
+  _In_ const __m256i chunk,
+  _Out_ __m256i *invalidRef)
+{
+  const __m256i digit = _mm256_sub_epi8(chunk, _mm256_set1_epi8('0'));
+  const __m256i letter = _mm256_sub_epi8(
+    _mm256_or_si256(chunk, _mm256_set1_epi8(0x20)),
+    _mm256_set1_epi8('a'));
+
+  const __m256i is_digit = _mm256_cmpeq_epi8(
+    _mm256_min_epu8(digit, _mm256_set1_epi8(9)),
+    digit);
+  const __m256i is_letter = _mm256_cmpeq_epi8(
+    _mm256_min_epu8(letter, _mm256_set1_epi8(5)),
+    letter);
+
+  invalidRef[0] = _mm256_andnot_si256(
+    _mm256_or_si256(is_digit, is_letter),
+    _mm256_set1_epi8(-1));
+
+  return _mm256_blendv_epi8(
+    _mm256_add_epi8(letter, _mm256_set1_epi8(0x0A)),
+    digit,
+    is_digit);
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Decodes 32 bytes at a time (AVX2 version).
+ *
+ * @param[out] output Decoded bytes.
+ * @param[in] text Hexadecimal digits (`2 * count` characters).
+ * @param[in] count Number of bytes to decode.
+ * @return Index of the first invalid pair of digits, or `count`.
+ */
+__attribute__((target("avx2")))
+static size_t
+UTF8_decodeHexAvx2(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  const __m256i weights = _mm256_set1_epi16(0x0110);
+  __m256i first, second, invalid_first, invalid_second;
+  size_t i;
+
+  for (i = 0; (i + 32) <= count; i += 32)
+  {
+    first = UTF8_decodeHexDigitsAvx2(
+      _mm256_loadu_si256((const __m256i *) &(text[2 * i])),
+      &(invalid_first));
+
+    second = UTF8_decodeHexDigitsAvx2(
+      _mm256_loadu_si256((const __m256i *) &(text[2 * i + 32])),
+      &(invalid_second));
+
+    if (0 != _mm256_movemask_epi8(
+      _mm256_or_si256(invalid_first, invalid_second)))
+    {
+      break;
+    }
+
+    /* Packing works within 128-bit lanes, */
+    /* so the 64-bit quarters are put back in order afterwards */
+
+    _mm256_storeu_si256(
+      (__m256i *) &(output[i]),
+      _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(
+          _mm256_maddubs_epi16(first, weights),
+          _mm256_maddubs_epi16(second, weights)),
+        0xD8));
+  }
+
+  return i + UTF8_decodeHexSsse3(&(output[i]), &(text[2 * i]), (count - i));
+}
+
+#elif defined(__aarch64__)
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Converts 16 hexadecimal digits into their values (NEON version).
+ *
+ * @param[in] chunk Characters to convert.
+ * @param[out] invalidRef Receives `0xFF` for every character
+ * that is not a hexadecimal digit.
+ * @return Values of the digits (undefined for the invalid characters).
+ */
+static uint8x16_t
+UTF8_decodeHexDigitsNeon(
+  _In_ const uint8x16_t chunk,
+  _Out_ uint8x16_t *invalidRef)
+{
+  const uint8x16_t digit = vsubq_u8(chunk, vdupq_n_u8('0'));
+  const uint8x16_t letter = vsubq_u8(
+    vorrq_u8(chunk, vdupq_n_u8(0x20)),
+    vdupq_n_u8('a'));
+
+  const uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+  const uint8x16_t is_letter = vcleq_u8(letter, vdupq_n_u8(5));
+
+  invalidRef[0] = vmvnq_u8(vorrq_u8(is_digit, is_letter));
+
+  return vbslq_u8(
+    is_digit,
+    digit,
+    vaddq_u8(letter, vdupq_n_u8(0x0A)));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Decodes 16 bytes at a time (NEON version).
+ *
+ * @param[out] output Decoded bytes.
+ * @param[in] text Hexadecimal digits (`2 * count` characters).
+ * @param[in] count Number of bytes to decode.
+ * @return Index of the first invalid pair of digits, or `count`.
+ */
+static size_t
+UTF8_decodeHexNeon(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  uint8x16x2_t pairs;
+  uint8x16_t high, low, invalid_high, invalid_low;
+  size_t i;
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    /* De-interleaving load (high digits, low digits) */
+
+    pairs = vld2q_u8(&(text[2 * i]));
+
+    high = UTF8_decodeHexDigitsNeon(pairs.val[0], &(invalid_high));
+    low = UTF8_decodeHexDigitsNeon(pairs.val[1], &(invalid_low));
+
+    if (0 != vmaxvq_u8(vorrq_u8(invalid_high, invalid_low)))
+    {
+      break;
+    }
+
+    vst1q_u8(&(output[i]), vorrq_u8(vshlq_n_u8(high, 4), low));
+  }
+
+  return i + UTF8_decodeHexBytes(&(output[i]), &(text[2 * i]), (count - i));
+}
+
+#endif
+
+/**************************************************************/
+
+static size_t
+UTF8_selectHexDecoder(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count);
+
+/**
+ * Decoder used by `UTF8String_decodeHex`.
+ * The first call picks the fastest version supported by the processor
+ * (see `utf8_ascii_scanner`).
+ */
+static utf8_hex_decoder_t utf8_hex_decoder = UTF8_selectHexDecoder;
+
+/**
+ * @brief A private method for hexadecimal decoding.
+ * Selects the decoder (on first use), and then decodes the bytes.
+ *
+ * @param[out] output Decoded bytes.
+ * @param[in] text Hexadecimal digits (`2 * count` characters).
+ * @param[in] count Number of bytes to decode.
+ * @return Index of the first invalid pair of digits, or `count`.
+ */
+static size_t
+UTF8_selectHexDecoder(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  utf8_hex_decoder_t decoder = UTF8_decodeHexBytes;
+
+  #if defined(__x86_64__) || defined(__i386__)
+  {
+    const uint32_t features = Misc_getCpuFeatures();
+
+    if (MISC_CPU_FEATURE__AVX2 & features)
+    {
+      decoder = UTF8_decodeHexAvx2;
+    }
+    else if (MISC_CPU_FEATURE__SSSE3 & features)
+    {
+      decoder = UTF8_decodeHexSsse3;
+    }
+  }
+  #elif defined(__aarch64__)
+  {
+    decoder = UTF8_decodeHexNeon;
+  }
+  #endif
+
+  utf8_hex_decoder = decoder;
+
+  return decoder(output, text, count);
+}
+
+/**************************************************************/
+
+BOOL
+UTF8String_decodeHex(
+  _In_ const UTF8String *string,
+  _Out_ LPBYTE output,
+  _Out_ size_t *errorOffsetRef)
+{
+  const size_t count = string->length / 2;
+  const size_t valid_count = utf8_hex_decoder(output, string->text, count);
+
+  if (valid_count < count)
+  {
+    /* Point at the invalid digit of the pair */
+
+    errorOffsetRef[0] = 2 * valid_count;
+
+    if (0xFF != UTF8_decodeHexDigit(string->text[errorOffsetRef[0]]))
+    {
+      errorOffsetRef[0] += 1;
+    }
+
+    return FALSE;
+  }
+
+  if (0 != (string->length % 2))
+  {
+    /* A digit without a pair */
+
+    errorOffsetRef[0] = string->length - 1;
+    return FALSE;
+  }
+
+  errorOffsetRef[0] = string->length;
+  return TRUE;
+}
+
+/**************************************************************/
+
+BOOL
+UTF8String_hexToByteArray(
+  _In_ const UTF8String *string,
+  _Out_ size_t *byteArraySizeRef,
+  _Outptr_result_maybenull_ BYTE **const result)
+{
+  size_t error_offset;
+
+  /* `malloc(0)` may return `NULL`, which is not an allocation failure */
+
+  if (0 == string->length)
+  {
+    result[0] = NULL;
+    byteArraySizeRef[0] = 0;
+    return TRUE;
+  }
+
+  result[0] = malloc(sizeof(BYTE) * (string->length / 2));
+  if (NULL == result[0]) { return FALSE; }
+
+  byteArraySizeRef[0] = string->length / 2;
+
+  return UTF8String_decodeHex(string, result[0], &(error_offset));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 encoding.
+ * Encodes one group (3 bytes into 4 characters) at a time,
+ * with a lookup table (generic version).
+ *
+ * @param[out] text Output characters (`4 * count` bytes).
+ * @param[in] bytes Encoded bytes (`3 * count` bytes).
+ * @param[in] count Number of groups to encode.
+ */
+static VOID
+UTF8_encodeBase64Bytes(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  uint32_t group;
+  size_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    group = ((uint32_t) bytes[3 * i] << 16) |
+      ((uint32_t) bytes[3 * i + 1] << 8) |
+      bytes[3 * i + 2];
+
+    text[4 * i]     = utf8_base64_alphabet[0x3F & (group >> 18)];
+    text[4 * i + 1] = utf8_base64_alphabet[0x3F & (group >> 12)];
+    text[4 * i + 2] = utf8_base64_alphabet[0x3F & (group >> 6)];
+    text[4 * i + 3] = utf8_base64_alphabet[0x3F & group];
+  }
+}
+
+/**************************************************************/
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief A private method for Base64 encoding.
+ * Encodes 4 groups (12 bytes) at a time (SSSE3 version).
+ *
+ * @param[out] text Output characters (`4 * count` bytes).
+ * @param[in] bytes Encoded bytes (`3 * count` bytes).
+ * @param[in] count Number of groups to encode.
+ */
+__attribute__((target("ssse3")))
+static VOID
+UTF8_encodeBase64Ssse3(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  /* Offsets added to the 6-bit indices, selected by index range */
+  /* (`A-Z`, `a-z`, `0-9`, `+` and `/`) */
+
+  const __m128i offsets = _mm_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+    '/' - 63, 'A', 0, 0);
+  __m128i chunk, indices, ranges;
+  size_t i;
+
+  /* Every load reads 16 bytes, but only 12 bytes are encoded */
+
+  for (i = 0; (i + 6) <= count; i += 4)
+  {
+    chunk = _mm_shuffle_epi8(
+      _mm_loadu_si128((const __m128i *) &(bytes[3 * i])),
+      _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+    /* Split every 24-bit group into four 6-bit indices */
+
+    indices = _mm_or_si128(
+      _mm_mulhi_epu16(
+        _mm_and_si128(chunk, _mm_set1_epi32(0x0FC0FC00)),
+        _mm_set1_epi32(0x04000040)),
+      _mm_mullo_epi16(
+        _mm_and_si128(chunk, _mm_set1_epi32(0x003F03F0)),
+        _mm_set1_epi32(0x01000010)));
+
+    ranges = _mm_or_si128(
+      _mm_subs_epu8(indices, _mm_set1_epi8(51)),
+      _mm_and_si128(
+        _mm_cmpgt_epi8(_mm_set1_epi8(26), indices),
+        _mm_set1_epi8(13)));
+
+    _mm_storeu_si128(
+      (__m128i *) &(text[4 * i]),
+      _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, ranges)));
+  }
+
+  UTF8_encodeBase64Bytes(&(text[4 * i]), &(bytes[3 * i]), (count - i));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 encoding.
+ * Encodes 8 groups (24 bytes) at a time (AVX2 version).
+ *
+ * @param[out] text Output characters (`4 * count` bytes).
+ * @param[in] bytes Encoded bytes (`3 * count` bytes).
+ * @param[in] count Number of groups to encode.
+ */
+__attribute__((target("avx2")))
+static VOID
+UTF8_encodeBase64Avx2(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  const __m256i offsets = _mm256_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+    '/' - 63, 'A', 0, 0,
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+    '/' - 63, 'A', 0, 0);
+  const __m256i order = _mm256_setr_epi8(
+    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  __m256i chunk, indices, ranges;
+  size_t i;
+
+  /* Every 128-bit lane gets 12 bytes (loaded as 16 bytes) */
+
+  for (i = 0; (i + 10) <= count; i += 8)
+  {
+    chunk = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(
+        _mm_loadu_si128((const __m128i *) &(bytes[3 * i]))),
+      _mm_loadu_si128((const __m128i *) &(bytes[3 * i + 12])),
+      1);
+
+    chunk = _mm256_shuffle_epi8(chunk, order);
+
+    indices = _mm256_or_si256(
+      _mm256_mulhi_epu16(
+        _mm256_and_si256(chunk, _mm256_set1_epi32(0x0FC0FC00)),
+        _mm256_set1_epi32(0x04000040)),
+      _mm256_mullo_epi16(
+        _mm256_and_si256(chunk, _mm256_set1_epi32(0x003F03F0)),
+        _mm256_set1_epi32(0x01000010)));
+
+    ranges = _mm256_or_si256(
+      _mm256_subs_epu8(indices, _mm256_set1_epi8(51)),
+      _mm256_and_si256(
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices),
+        _mm256_set1_epi8(13)));
+
+    _mm256_storeu_si256(
+      (__m256i *) &(text[4 * i]),
+      _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, ranges)));
+  }
+
+  UTF8_encodeBase64Ssse3(&(text[4 * i]), &(bytes[3 * i]), (count - i));
+}
+
+#elif defined(__aarch64__)
+
+/**
+ * @brief A private method for Base64 encoding.
+ * Encodes 16 groups (48 bytes) at a time (NEON version).
+ *
+ * @param[out] text Output characters (`4 * count` bytes).
+ * @param[in] bytes Encoded bytes (`3 * count` bytes).
+ * @param[in] count Number of groups to encode.
+ */
+static VOID
+UTF8_encodeBase64Neon(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  uint8x16x4_t alphabet;
+  uint8x16x3_t groups;
+  uint8x16x4_t indices;
+  size_t i;
+
+  alphabet.val[0] = vld1q_u8(&(utf8_base64_alphabet[0]));
+  alphabet.val[1] = vld1q_u8(&(utf8_base64_alphabet[16]));
+  alphabet.val[2] = vld1q_u8(&(utf8_base64_alphabet[32]));
+  alphabet.val[3] = vld1q_u8(&(utf8_base64_alphabet[48]));
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    /* De-interleaving load (first, second and third bytes) */
+
+    groups = vld3q_u8(&(bytes[3 * i]));
+
+    indices.val[0] = vshrq_n_u8(groups.val[0], 2);
+    indices.val[1] = vorrq_u8(
+      vshlq_n_u8(vandq_u8(groups.val[0], vdupq_n_u8(0x03)), 4),
+      vshrq_n_u8(groups.val[1], 4));
+    indices.val[2] = vorrq_u8(
+      vshlq_n_u8(vandq_u8(groups.val[1], vdupq_n_u8(0x0F)), 2),
+      vshrq_n_u8(groups.val[2], 6));
+    indices.val[3] = vandq_u8(groups.val[2], vdupq_n_u8(0x3F));
+
+    indices.val[0] = vqtbl4q_u8(alphabet, indices.val[0]);
+    indices.val[1] = vqtbl4q_u8(alphabet, indices.val[1]);
+    indices.val[2] = vqtbl4q_u8(alphabet, indices.val[2]);
+    indices.val[3] = vqtbl4q_u8(alphabet, indices.val[3]);
+
+    /* Interleaving store */
+
+    vst4q_u8(&(text[4 * i]), indices);
+  }
+
+  UTF8_encodeBase64Bytes(&(text[4 * i]), &(bytes[3 * i]), (count - i));
+}
+
+#endif
+
+/**************************************************************/
+
+static VOID
+UTF8_selectBase64Encoder(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count);
+
+/**
+ * Encoder used by `UTF8String_pushBytesAsBase64`.
+ * The first call picks the fastest version supported by the processor
+ * (see `utf8_ascii_scanner`).
+ */
+static utf8_base64_encoder_t utf8_base64_encoder = UTF8_selectBase64Encoder;
+
+/**
+ * @brief A private method for Base64 encoding.
+ * Selects the encoder (on first use), and then encodes the bytes.
+ *
+ * @param[out] text Output characters (`4 * count` bytes).
+ * @param[in] bytes Encoded bytes (`3 * count` bytes).
+ * @param[in] count Number of groups to encode.
+ */
+static VOID
+UTF8_selectBase64Encoder(
+  _Out_ LPBYTE text,
+  _In_ const BYTE *bytes,
+  _In_ const size_t count)
+{
+  utf8_base64_encoder_t encoder = UTF8_encodeBase64Bytes;
+
+  #if defined(__x86_64__) || defined(__i386__)
+  {
+    const uint32_t features = Misc_getCpuFeatures();
+
+    if (MISC_CPU_FEATURE__AVX2 & features)
+    {
+      encoder = UTF8_encodeBase64Avx2;
+    }
+    else if (MISC_CPU_FEATURE__SSSE3 & features)
+    {
+      encoder = UTF8_encodeBase64Ssse3;
+    }
+  }
+  #elif defined(__aarch64__)
+  {
+    encoder = UTF8_encodeBase64Neon;
+  }
+  #endif
+
+  utf8_base64_encoder = encoder;
+
+  encoder(text, bytes, count);
+}
+
+/**************************************************************/
+
+BOOL
+UTF8String_pushBytesAsBase64(
+  _Inout_ UTF8String *string,
+  _In_ size_t byteArraySize,
+  _In_ const BYTE *bytes)
+{
+  const size_t count = byteArraySize / 3;
+  const size_t remainder = byteArraySize % 3;
+  BYTE last_group[3] = {0, 0, 0};
+  LPBYTE text;
+
+  if (!UTF8String_assertCapacity(string, (4 * ((byteArraySize + 2) / 3))))
+  {
+    return FALSE;
+  }
+
+  text = &(string->text[string->length]);
+
+  utf8_base64_encoder(text, bytes, count);
+
+  /* The last (incomplete) group is padded with '=' characters */
+
+  if (0 != remainder)
+  {
+    memcpy(last_group, &(bytes[3 * count]), remainder);
+
+    UTF8_encodeBase64Bytes(&(text[4 * count]), last_group, 1);
+
+    text[4 * count + 3] = '=';
+
+    if (1 == remainder)
+    {
+      text[4 * count + 2] = '=';
+    }
+
+    string->length += 4;
+  }
+
+  string->length += 4 * count;
+  string->text[string->length] = '\0';
+  return TRUE;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Converts one Base64 character into its value.
+ *
+ * @param[in] character Character to convert.
+ * @return Value from 0 to 63, or `0xFF` if `character` does not belong
+ * to the Base64 alphabet.
+ */
+static BYTE
+UTF8_decodeBase64Char(
+  _In_ const BYTE character)
+{
+  if ((BYTE) (character - 'A') <= 25)
+  {
+    return (character - 'A');
+  }
+
+  if ((BYTE) (character - 'a') <= 25)
+  {
+    return (character - 'a' + 26);
+  }
+
+  if ((BYTE) (character - '0') <= 9)
+  {
+    return (character - '0' + 52);
+  }
+
+  if ('+' == character) { return 62; }
+  if ('/' == character) { return 63; }
+
+  return 0xFF;
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Decodes one group (4 characters into 3 bytes) at a time
+ * (generic version).
+ *
+ * @param[out] output Decoded bytes (`3 * count` bytes).
+ * @param[in] text Base64 characters (`4 * count` characters).
+ * @param[in] count Number of groups to decode.
+ * @return Index of the first invalid group, or `count`.
+ */
+static size_t
+UTF8_decodeBase64Bytes(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  BYTE values[4];
+  size_t i, j;
+
+  for (i = 0; i < count; i++)
+  {
+    for (j = 0; j < 4; j++)
+    {
+      values[j] = UTF8_decodeBase64Char(text[4 * i + j]);
+
+      if (0xFF == values[j])
+      {
+        return i;
+      }
+    }
+
+    output[3 * i]     = (BYTE) ((values[0] << 2) | (values[1] >> 4));
+    output[3 * i + 1] = (BYTE) ((values[1] << 4) | (values[2] >> 2));
+    output[3 * i + 2] = (BYTE) ((values[2] << 6) | values[3]);
+  }
+
+  return i;
+}
+
+/**************************************************************/
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Converts 16 Base64 characters into their values (SSSE3 version).
+ *
+ * @param[in] chunk Characters to convert.
+ * @param[out] invalidRef Receives `0xFF` for every character
+ * that does not belong to the Base64 alphabet.
+ * @return Values of the characters (zero for the invalid characters).
+ */
+__attribute__((target("ssse3")))
+static __m128i
+UTF8_decodeBase64CharsSsse3(
+  _In_ const __m128i chunk,
+  _Out_ __m128i *invalidRef)
+{
+  const __m128i upper = _mm_sub_epi8(chunk, _mm_set1_epi8('A'));
+  const __m128i lower = _mm_sub_epi8(chunk, _mm_set1_epi8('a'));
+  const __m128i digit = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+
+  /* Unsigned "less or equal" (the minimum is the value itself) */
+
+  const __m128i is_upper = _mm_cmpeq_epi8(
+    _mm_min_epu8(upper, _mm_set1_epi8(25)),
+    upper);
+  const __m128i is_lower = _mm_cmpeq_epi8(
+    _mm_min_epu8(lower, _mm_set1_epi8(25)),
+    lower);
+  const __m128i is_digit = _mm_cmpeq_epi8(
+    _mm_min_epu8(digit, _mm_set1_epi8(9)),
+    digit);
+  const __m128i is_plus = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('+'));
+  const __m128i is_slash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/'));
+
+  invalidRef[0] = _mm_andnot_si128(
+    _mm_or_si128(
+      _mm_or_si128(is_upper, is_lower),
+      _mm_or_si128(is_digit, _mm_or_si128(is_plus, is_slash))),
+    _mm_set1_epi8(-1));
+
+  /* The ranges do not overlap, so the values can be merged */
+
+  return _mm_or_si128(
+    _mm_or_si128(
+      _mm_and_si128(is_upper, upper),
+      _mm_and_si128(is_lower, _mm_add_epi8(lower, _mm_set1_epi8(26)))),
+    _mm_or_si128(
+      _mm_and_si128(is_digit, _mm_add_epi8(digit, _mm_set1_epi8(52))),
+      _mm_or_si128(
+        _mm_and_si128(is_plus, _mm_set1_epi8(62)),
+        _mm_and_si128(is_slash, _mm_set1_epi8(63)))));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Joins 16 values (6 bits each) into 12 bytes, placed at the beginning
+ * of the 128-bit register (SSSE3 version).
+ *
+ * @param[in] values Values of 16 Base64 characters.
+ * @return Decoded bytes.
+ */
+__attribute__((target("ssse3")))
+static __m128i
+UTF8_packBase64Ssse3(
+  _In_ const __m128i values)
+{
+  /* Two values become 12 bits, and then four values become 24 bits */
+
+  const __m128i merged = _mm_madd_epi16(
+    _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)),
+    _mm_set1_epi32(0x00011000));
+
+  /* Big-endian order of the bytes in every group */
+
+  return _mm_shuffle_epi8(
+    merged,
+    _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Stores 12 bytes from the beginning of a 128-bit register.
+ *
+ * @param[out] output Decoded bytes.
+ * @param[in] bytes Register with the decoded bytes.
+ */
+__attribute__((target("ssse3")))
+static VOID
+UTF8_storeBase64Ssse3(
+  _Out_ LPBYTE output,
+  _In_ const __m128i bytes)
+{
+  uint32_t last;
+
+  _mm_storel_epi64((__m128i *) output, bytes);
+
+  last = (uint32_t) _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+  memcpy(&(output[8]), &(last), 4);
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Decodes 4 groups (16 characters) at a time (SSSE3 version).
+ *
+ * @param[out] output Decoded bytes (`3 * count` bytes).
+ * @param[in] text Base64 characters (`4 * count` characters).
+ * @param[in] count Number of groups to decode.
+ * @return Index of the first invalid group, or `count`.
+ */
+__attribute__((target("ssse3")))
+static size_t
+UTF8_decodeBase64Ssse3(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  __m128i values, invalid;
+  size_t i;
+
+  for (i = 0; (i + 4) <= count; i += 4)
+  {
+    values = UTF8_decodeBase64CharsSsse3(
+      _mm_loadu_si128((const __m128i *) &(text[4 * i])),
+      &(invalid));
+
+    if (0 != _mm_movemask_epi8(invalid))
+    {
+      break;
+    }
+
+    UTF8_storeBase64Ssse3(&(output[3 * i]), UTF8_packBase64Ssse3(values));
+  }
+
+  /* The remaining groups (or the invalid chunk) are decoded one by one */
+
+  return i + UTF8_decodeBase64Bytes(
+    &(output[3 * i]),
+    &(text[4 * i]),
+    (count - i));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Decodes 8 groups (32 characters) at a time (AVX2 version).
+ *
+ * @param[out] output Decoded bytes (`3 * count` bytes).
+ * @param[in] text Base64 characters (`4 * count` characters).
+ * @param[in] count Number of groups to decode.
+ * @return Index of the first invalid group, or `count`.
+ */
+__attribute__((target("avx2")))
+static size_t
+UTF8_decodeBase64Avx2(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  __m256i chunk, upper, lower, digit;
+  __m256i is_upper, is_lower, is_digit, is_plus, is_slash;
+  __m256i valid, values, merged;
+  size_t i;
+
+  for (i = 0; (i + 8) <= count; i += 8)
+  {
+    chunk = _mm256_loadu_si256((const __m256i *) &(text[4 * i]));
+
+    upper = _mm256_sub_epi8(chunk, _mm256_set1_epi8('A'));
+    lower = _mm256_sub_epi8(chunk, _mm256_set1_epi8('a'));
+    digit = _mm256_sub_epi8(chunk, _mm256_set1_epi8('0'));
+
+    is_upper = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(upper, _mm256_set1_epi8(25)),
+      upper);
+    is_lower = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(lower, _mm256_set1_epi8(25)),
+      lower);
+    is_digit = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(digit, _mm256_set1_epi8(9)),
+      digit);
+    is_plus = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('+'));
+    is_slash = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('/'));
+
+    valid = _mm256_or_si256(
+      _mm256_or_si256(is_upper, is_lower),
+      _mm256_or_si256(is_digit, _mm256_or_si256(is_plus, is_slash)));
+
+    if (-1 != _mm256_movemask_epi8(valid))
+    {
+      break;
+    }
+
+    values = _mm256_or_si256(
+      _mm256_or_si256(
+        _mm256_and_si256(is_upper, upper),
+        _mm256_and_si256(
+          is_lower,
+          _mm256_add_epi8(lower, _mm256_set1_epi8(26)))),
+      _mm256_or_si256(
+        _mm256_and_si256(
+          is_digit,
+          _mm256_add_epi8(digit, _mm256_set1_epi8(52))),
+        _mm256_or_si256(
+          _mm256_and_si256(is_plus, _mm256_set1_epi8(62)),
+          _mm256_and_si256(is_slash, _mm256_set1_epi8(63)))));
+
+    merged = _mm256_madd_epi16(
+      _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)),
+      _mm256_set1_epi32(0x00011000));
+
+    merged = _mm256_shuffle_epi8(
+      merged,
+      _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    /* Every 128-bit lane holds 12 bytes */
+
+    UTF8_storeBase64Ssse3(
+      &(output[3 * i]),
+      _mm256_castsi256_si128(merged));
+
+    UTF8_storeBase64Ssse3(
+      &(output[3 * i + 12]),
+      _mm256_extracti128_si256(merged, 1));
+  }
+
+  return i + UTF8_decodeBase64Ssse3(
+    &(output[3 * i]),
+    &(text[4 * i]),
+    (count - i));
+}
+
+#elif defined(__aarch64__)
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Converts 16 Base64 characters into their values (NEON version).
+ *
+ * @param[in] chunk Characters to convert.
+ * @param[in,out] invalidRef Receives `0xFF` for every character
+ * that does not belong to the Base64 alphabet (merged with its
+ * previous contents).
+ * @return Values of the characters (zero for the invalid characters).
+ */
+static uint8x16_t
+UTF8_decodeBase64CharsNeon(
+  _In_ const uint8x16_t chunk,
+  _Inout_ uint8x16_t *invalidRef)
+{
+  const uint8x16_t upper = vsubq_u8(chunk, vdupq_n_u8('A'));
+  const uint8x16_t lower = vsubq_u8(chunk, vdupq_n_u8('a'));
+  const uint8x16_t digit = vsubq_u8(chunk, vdupq_n_u8('0'));
+
+  const uint8x16_t is_upper = vcleq_u8(upper, vdupq_n_u8(25));
+  const uint8x16_t is_lower = vcleq_u8(lower, vdupq_n_u8(25));
+  const uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+  const uint8x16_t is_plus = vceqq_u8(chunk, vdupq_n_u8('+'));
+  const uint8x16_t is_slash = vceqq_u8(chunk, vdupq_n_u8('/'));
+
+  invalidRef[0] = vorrq_u8(
+    invalidRef[0],
+    vmvnq_u8(vorrq_u8(
+      vorrq_u8(is_upper, is_lower),
+      vorrq_u8(is_digit, vorrq_u8(is_plus, is_slash)))));
+
+  return vorrq_u8(
+    vorrq_u8(
+      vandq_u8(is_upper, upper),
+      vandq_u8(is_lower, vaddq_u8(lower, vdupq_n_u8(26)))),
+    vorrq_u8(
+      vandq_u8(is_digit, vaddq_u8(digit, vdupq_n_u8(52))),
+      vorrq_u8(
+        vandq_u8(is_plus, vdupq_n_u8(62)),
+        vandq_u8(is_slash, vdupq_n_u8(63)))));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Decodes 16 groups (64 characters) at a time (NEON version).
+ *
+ * @param[out] output Decoded bytes (`3 * count` bytes).
+ * @param[in] text Base64 characters (`4 * count` characters).
+ * @param[in] count Number of groups to decode.
+ * @return Index of the first invalid group, or `count`.
+ */
+static size_t
+UTF8_decodeBase64Neon(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
+{
+  uint8x16x4_t chars;
+  uint8x16x4_t values;
+  uint8x16x3_t bytes;
+  uint8x16_t invalid;
+  size_t i, j;
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    /* De-interleaving load (first, second, third and fourth characters) */
+
+    chars = vld4q_u8(&(text[4 * i]));
+    invalid = vdupq_n_u8(0);
+
+    for (j = 0; j < 4; j++)
+    {
+      values.val[j] = UTF8_decodeBase64CharsNeon(chars.val[j], &(invalid));
+    }
+
+    if (0 != vmaxvq_u8(invalid))
+    {
+      break;
+    }
+
+    bytes.val[0] = vorrq_u8(
+      vshlq_n_u8(values.val[0], 2),
+      vshrq_n_u8(values.val[1], 4));
+    bytes.val[1] = vorrq_u8(
+      vshlq_n_u8(values.val[1], 4),
+      vshrq_n_u8(values.val[2], 2));
+    bytes.val[2] = vorrq_u8(
+      vshlq_n_u8(values.val[2], 6),
+      values.val[3]);
+
+    /* Interleaving store */
+
+    vst3q_u8(&(output[3 * i]), bytes);
+  }
+
+  return i + UTF8_decodeBase64Bytes(
+    &(output[3 * i]),
+    &(text[4 * i]),
+    (count - i));
+}
+
+#endif
+
+/**************************************************************/
+
+static size_t
+UTF8_selectBase64Decoder(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count);
+
+/**
+ * Decoder used by `UTF8String_decodeBase64`.
+ * The first call picks the fastest version supported by the processor
+ * (see `utf8_ascii_scanner`).
+ */
+static utf8_base64_decoder_t utf8_base64_decoder = UTF8_selectBase64Decoder;
+
+/**
+ * @brief A private method for Base64 decoding.
+ * Selects the decoder (on first use), and then decodes the characters.
+ *
+ * @param[out] output Decoded bytes (`3 * count` bytes).
+ * @param[in] text Base64 characters (`4 * count` characters).
+ * @param[in] count Number of groups to decode.
+ * @return Index of the first invalid group, or `count`.
+ */
+static size_t
+UTF8_selectBase64Decoder(
+  _Out_ LPBYTE output,
+  _In_ const BYTE *text,
+  _In_ const size_t count)
 {
-  if (!UTF8String_assertCapacity(string, 1))
+  utf8_base64_decoder_t decoder = UTF8_decodeBase64Bytes;
+
+  #if defined(__x86_64__) || defined(__i386__)
   {
-    return FALSE;
+    const uint32_t features = Misc_getCpuFeatures();
+
+    if (MISC_CPU_FEATURE__AVX2 & features)
+    {
+      decoder = UTF8_decodeBase64Avx2;
+    }
+    else if (MISC_CPU_FEATURE__SSSE3 & features)
+    {
+      decoder = UTF8_decodeBase64Ssse3;
+    }
+  }
+  #elif defined(__aarch64__)
+  {
+    decoder = UTF8_decodeBase64Neon;
   }
+  #endif
 
-  string->text[string->length] = byte;
-  string->length += 1;
-  string->text[string->length] = '\0';
+  utf8_base64_decoder = decoder;
 
-  return TRUE;
+  return decoder(output, text, count);
 }
 
 /**************************************************************/
 
 BOOL
-UTF8String_pushBytesAsHex(
-  _Inout_ UTF8String *string,
-  _In_ size_t byteArraySize,
-  _In_ const BYTE *bytes)
+UTF8String_decodeBase64(
+  _In_ const UTF8String *string,
+  _Out_ LPBYTE output,
+  _Out_ size_t *byteArraySizeRef,
+  _Out_ size_t *errorOffsetRef)
 {
-  if (!UTF8String_assertCapacity(string, (2 * byteArraySize)))
-  {
-    return FALSE;
-  }
+  const BYTE *text = string->text;
+  size_t count = string->length / 4;
+  size_t padding = 0;
+  size_t valid_count;
+  BYTE last_group[3];
+  BYTE last_text[4];
+  size_t i;
 
-  LPBYTE text = string->text;
+  byteArraySizeRef[0] = 0;
 
-  for (size_t i = 0; i < byteArraySize; i++)
-  {
-    BYTE next_byte = bytes[i];
+  /* Up to two '=' characters can pad the last group */
 
-    for (size_t j = 0; j < 2; j++)
+  if ((0 != count) && (0 == (string->length % 4)))
+  {
+    if ('=' == text[string->length - 1])
     {
-      BYTE nibble = next_byte & 0x0F;
-      next_byte >>= 4;
-
-      BYTE hexcode = (nibble < 0x0A) ?
-        ('0' + nibble) :
-        ('A' + nibble - 0x0A);
-      text[string->length + 1 - j] = hexcode;
+      padding = ('=' == text[string->length - 2]) ? 2 : 1;
     }
 
-    string->length += 2;
+    if (0 != padding)
+    {
+      count -= 1;
+    }
   }
 
-  text[string->length] = '\0';
-  return TRUE;
-}
+  /* Complete groups */
 
-/**************************************************************/
+  valid_count = utf8_base64_decoder(output, text, count);
 
-BOOL
-UTF8String_hexToByteArray(
-  _In_ const UTF8String *string,
-  _Out_ size_t *byteArraySizeRef,
-  _Outptr_result_maybenull_ BYTE **const result)
-{
-  const size_t output_size = string->length / 2;
+  if (valid_count < count)
+  {
+    /* Point at the invalid character of the group */
 
-  result[0] = malloc(sizeof(BYTE) * output_size);
-  if (NULL == result[0]) { return FALSE; }
+    errorOffsetRef[0] = 4 * valid_count;
 
-  byteArraySizeRef[0] = output_size;
+    while (0xFF != UTF8_decodeBase64Char(text[errorOffsetRef[0]]))
+    {
+      errorOffsetRef[0] += 1;
+    }
 
-  const BYTE *text = string->text;
+    return FALSE;
+  }
 
-  for (size_t i = 0; i < output_size; i++)
+  byteArraySizeRef[0] = 3 * count;
+
+  /* Padded group */
+
+  if (0 != padding)
   {
-    BYTE next_byte = 0;
+    memcpy(last_text, &(text[4 * count]), 4);
 
-    for (size_t j = 0; j < 2; j++)
+    for (i = (4 - padding); i < 4; i++)
     {
-      BYTE nibble;
-      BYTE codepoint = text[0];
+      last_text[i] = 'A';
+    }
 
-      if (0 != (0xFF00 & codepoint))
-      {
-        return FALSE;
-      }
-      else if ((codepoint >= '0') && (codepoint <= '9'))
-      {
-        nibble = codepoint - '0';
-      }
-      else if ((codepoint >= 'A') && (codepoint <= 'F'))
-      {
-        nibble = codepoint - 'A' + 0x0A;
-      }
-      else if ((codepoint >= 'a') && (codepoint <= 'f'))
-      {
-        nibble = codepoint - 'a' + 0x0A;
-      }
-      else
+    if (0 == UTF8_decodeBase64Bytes(last_group, last_text, 1))
+    {
+      errorOffsetRef[0] = 4 * count;
+
+      while (0xFF != UTF8_decodeBase64Char(last_text[errorOffsetRef[0] % 4]))
       {
-        return FALSE;
+        errorOffsetRef[0] += 1;
       }
 
-      text++;
-      next_byte = (next_byte << 4) | nibble;
+      return FALSE;
     }
 
-    result[0][i] = next_byte;
+    memcpy(&(output[3 * count]), last_group, (3 - padding));
+
+    byteArraySizeRef[0] += 3 - padding;
+  }
+  else if (0 != (string->length % 4))
+  {
+    /* Characters without a complete group */
+
+    errorOffsetRef[0] = 4 * count;
+    return FALSE;
   }
 
+  errorOffsetRef[0] = string->length;
   return TRUE;
 }
 
@@ -268,44 +1860,6 @@ UTF8String_matches(
 
 /**************************************************************/
 
-BOOL
-UTF8String_writeToStandardOutput(
-  _In_ const UTF8String *string)
-{
-  os_specific_stream_t stdout_stream;
-
-  #if defined(_WIN32)
-  {
-    stdout_stream = GetStdHandle(STD_OUTPUT_HANDLE);
-
-    if (INVALID_HANDLE_VALUE == stdout_stream)
-    {
-      return FALSE;
-    }
-  }
-  #elif defined(__linux__) || defined(__APPLE__)
-  {
-    stdout_stream = STDOUT_FILENO;
-  }
-  #endif
-
-  uint32_t outgoing_length = string->length;
-
-  BOOL test_bool = OSSpecific_writeBytesToStream(
-    stdout_stream,
-    &(outgoing_length),
-    sizeof(uint32_t));
-
-  if (!test_bool) { return FALSE; }
-
-  return OSSpecific_writeBytesToStream(
-    stdout_stream,
-    string->text,
-    string->length);
-}
-
-/**************************************************************/
-
 VOID
 UTF16String_init(
   _Out_ UTF16String *string)
@@ -414,6 +1968,10 @@ UTF16String_pushBytesAsHex(
   _In_ size_t byteArraySize,
   _In_ const BYTE *bytes)
 {
+  BYTE hex_chunk[2 * UTF16_HEX__CHUNK_SIZE];
+  size_t count;
+  size_t i;
+
   if (!UTF16String_assertCapacity(string, (2 * byteArraySize)))
   {
     return FALSE;
@@ -421,22 +1979,24 @@ UTF16String_pushBytesAsHex(
 
   LPWSTR text = string->text;
 
-  for (size_t i = 0; i < byteArraySize; i++)
+  /* Encode a chunk with the 8-bit encoder, and then widen the digits */
+
+  while (byteArraySize > 0)
   {
-    BYTE next_byte = bytes[i];
+    count = (byteArraySize < UTF16_HEX__CHUNK_SIZE) ?
+      byteArraySize :
+      UTF16_HEX__CHUNK_SIZE;
 
-    for (size_t j = 0; j < 2; j++)
-    {
-      BYTE nibble = next_byte & 0x0F;
-      next_byte >>= 4;
+    utf8_hex_encoder(hex_chunk, bytes, count);
 
-      WCHAR hexcode = (nibble < 0x0A) ?
-        ('0' + nibble) :
-        ('A' + nibble - 0x0A);
-      text[string->length + 1 - j] = hexcode;
+    for (i = 0; i < (2 * count); i++)
+    {
+      text[string->length + i] = hex_chunk[i];
     }
 
-    string->length += 2;
+    string->length += 2 * count;
+    bytes = &(bytes[count]);
+    byteArraySize -= count;
   }
 
   text[string->length] = '\0';
@@ -614,18 +2174,18 @@ UTF8_validateTransformation(
 
   /* Append the bits from subsequent bytes */
 
-  for (size_t i = 0; i < lengthRef[0]; i++)
+  for (size_t i = 1; i < lengthRef[0]; i++)
   {
     /* bitmask:          11000000 */
     /* subsequent bytes: 10xxxxxx */
 
-    if (0x80 != (0xC0 & bytes[1 + i]))
+    if (0x80 != (0xC0 & bytes[i]))
     {
       return FALSE;
     }
 
     /* bitmask: 00111111 */
-    codepoint = (codepoint << 6) | (bytes[1 + i] & 0x3F);
+    codepoint = (codepoint << 6) | (bytes[i] & 0x3F);
   }
 
   /* Validate the "minimum number of bytes" rule */
@@ -643,6 +2203,14 @@ UTF8_validateTransformation(
     return FALSE;
   }
 
+  /* Surrogate halves and values above U+10FFFF are not characters */
+
+  if (((codepoint >= 0x0000D800) && (codepoint <= 0x0000DFFF)) ||
+    (codepoint > 0x0010FFFF))
+  {
+    return FALSE;
+  }
+
   /* Store the decoded codepoint if needed */
 
   if (NULL != codePointRef)
@@ -655,6 +2223,234 @@ UTF8_validateTransformation(
 
 /**************************************************************/
 
+/**
+ * @brief A private method for UTF-8 validation.
+ * Skips ASCII characters, 8 bytes at a time (generic version).
+ *
+ * @param[in] bytes Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first non-ASCII byte, or `length`.
+ */
+static size_t
+UTF8_skipAsciiBytes(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length)
+{
+  uint64_t chunk;
+  size_t i;
+
+  for (i = 0; (i + 8) <= length; i += 8)
+  {
+    memcpy(&(chunk), &(bytes[i]), 8);
+
+    if (0 != (UINT64_C(0x8080808080808080) & chunk))
+    {
+      break;
+    }
+  }
+
+  while ((i < length) && (0 == (0x80 & bytes[i])))
+  {
+    i++;
+  }
+
+  return i;
+}
+
+/**************************************************************/
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief A private method for UTF-8 validation.
+ * Skips ASCII characters, 16 bytes at a time (SSE2 version).
+ *
+ * @param[in] bytes Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first non-ASCII byte, or `length`.
+ */
+__attribute__((target("sse2")))
+static size_t
+UTF8_skipAsciiSse2(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length)
+{
+  uint32_t mask;
+  size_t i;
+
+  for (i = 0; (i + 16) <= length; i += 16)
+  {
+    /* Top bit of every byte (set only outside of the ASCII range) */
+
+    mask = (uint32_t) _mm_movemask_epi8(
+      _mm_loadu_si128((const __m128i *) &(bytes[i])));
+
+    if (0 != mask)
+    {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + UTF8_skipAsciiBytes(&(bytes[i]), (length - i));
+}
+
+/**************************************************************/
+
+/**
+ * @brief A private method for UTF-8 validation.
+ * Skips ASCII characters, 32 bytes at a time (AVX2 version).
+ *
+ * @param[in] bytes Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first non-ASCII byte, or `length`.
+ */
+__attribute__((target("avx2")))
+static size_t
+UTF8_skipAsciiAvx2(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length)
+{
+  uint32_t mask;
+  size_t i;
+
+  for (i = 0; (i + 32) <= length; i += 32)
+  {
+    mask = (uint32_t) _mm256_movemask_epi8(
+      _mm256_loadu_si256((const __m256i *) &(bytes[i])));
+
+    if (0 != mask)
+    {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return i + UTF8_skipAsciiSse2(&(bytes[i]), (length - i));
+}
+
+#elif defined(__aarch64__)
+
+/**
+ * @brief A private method for UTF-8 validation.
+ * Skips ASCII characters, 16 bytes at a time (NEON version).
+ *
+ * @param[in] bytes Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first non-ASCII byte, or `length`.
+ */
+static size_t
+UTF8_skipAsciiNeon(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length)
+{
+  size_t i;
+
+  for (i = 0; (i + 16) <= length; i += 16)
+  {
+    if (vmaxvq_u8(vld1q_u8(&(bytes[i]))) >= 0x80)
+    {
+      return i + UTF8_skipAsciiBytes(&(bytes[i]), 16);
+    }
+  }
+
+  return i + UTF8_skipAsciiBytes(&(bytes[i]), (length - i));
+}
+
+#endif
+
+/**************************************************************/
+
+static size_t
+UTF8_selectAsciiScanner(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length);
+
+/**
+ * Scanner used by `UTF8_validate`.
+ * The first call picks the fastest version supported by the processor.
+ * Both the main thread and Reader Workers may race to replace it,
+ * but they always store the same function.
+ */
+static utf8_ascii_scanner_t utf8_ascii_scanner = UTF8_selectAsciiScanner;
+
+/**
+ * @brief A private method for UTF-8 validation.
+ * Selects the scanner (on first use), and then scans the text.
+ *
+ * @param[in] bytes Scanned bytes.
+ * @param[in] length Number of bytes to scan.
+ * @return Offset of the first non-ASCII byte, or `length`.
+ */
+static size_t
+UTF8_selectAsciiScanner(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length)
+{
+  utf8_ascii_scanner_t scanner = UTF8_skipAsciiBytes;
+
+  #if defined(__x86_64__) || defined(__i386__)
+  {
+    const uint32_t features = Misc_getCpuFeatures();
+
+    if (MISC_CPU_FEATURE__AVX2 & features)
+    {
+      scanner = UTF8_skipAsciiAvx2;
+    }
+    else if (MISC_CPU_FEATURE__SSE2 & features)
+    {
+      scanner = UTF8_skipAsciiSse2;
+    }
+  }
+  #elif defined(__aarch64__)
+  {
+    scanner = UTF8_skipAsciiNeon;
+  }
+  #endif
+
+  utf8_ascii_scanner = scanner;
+
+  return scanner(bytes, length);
+}
+
+/**************************************************************/
+
+BOOL
+UTF8_validate(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length)
+{
+  size_t i = 0;
+  size_t codepoint_length;
+
+  while (i < length)
+  {
+    /* ASCII runs are skipped in bulk, */
+    /* multibyte codepoints are checked one by one */
+
+    i += utf8_ascii_scanner(&(bytes[i]), (length - i));
+
+    if (i == length)
+    {
+      break;
+    }
+
+    codepoint_length = (length - i);
+
+    if (!UTF8_validateTransformation(
+      &(bytes[i]),
+      &(codepoint_length),
+      NULL))
+    {
+      return FALSE;
+    }
+
+    i += codepoint_length;
+  }
+
+  return TRUE;
+}
+
+/**************************************************************/
+
 BOOL
 UTF16String_toUTF8(
   _In_ const UTF16String *string,
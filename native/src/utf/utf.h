@@ -34,10 +34,14 @@ struct UTF8String
   /**
    * Allocated text capacity in characters (in 8-bit bytes).
    * Should be at least `length + 1` to include the NULL-terminator.
+   * Zero (with a non-NULL `text`) marks a borrowed, read-only view.
    */
   size_t capacity;
 
-  /** Dynamically-allocated text buffer. Will containt a NULL-terminator. */
+  /**
+   * Dynamically-allocated text buffer. Will containt a NULL-terminator
+   * (unless the string is a borrowed view, see `UTF8String_makeView`).
+   */
   LPBYTE text;
 };
 
@@ -97,6 +101,26 @@ UTF8String_makeTemporary(
   _Out_ UTF8String *string,
   _In_ LPCSTR text);
 
+/**
+ * @brief Creates a `UTF8String` object that borrows some existing text
+ * (for example, a part of the JSON message being parsed).
+ *
+ * The view is read-only and is not NULL-terminated. Its destructor does not
+ * release the borrowed text, and appending to the view first makes
+ * an own copy of the text.
+ * @param[out] string Reference to an UNINITIALIZED `UTF8String` object.
+ * @param[in] text Some read-only UTF-8 text, which must outlive the view.
+ * @param[in] length Length of the borrowed text.
+ *
+ * @note Use `UTF8String_copy` to keep the text after the borrowed memory
+ * is released or reused.
+ */
+extern VOID
+UTF8String_makeView(
+  _Out_ UTF8String *string,
+  _In_ const BYTE *text,
+  _In_ const size_t length);
+
 /**
  * @brief Push (append) one 8-bit byte (char) at the end of the string.
  *
@@ -125,6 +149,64 @@ UTF8String_pushBytesAsHex(
   _In_ size_t byteArraySize,
   _In_ const BYTE *bytes);
 
+/**
+ * @brief Decodes a hexadecimal representation (2 ASCII characters
+ * for each byte, either case) into a buffer provided by the caller,
+ * without any memory allocation.
+ *
+ * @param[in] string Reference to a VALID and CONSTANT `UTF8String` object
+ * (it can be a view).
+ * @param[out] output Buffer for at least `string->length / 2` bytes.
+ * @param[out] errorOffsetRef Pointer to a variable that will hold
+ * the offset of the first character that is not a hexadecimal digit
+ * (or of the last digit, if it has no pair), or `string->length`
+ * on success.
+ * @return `TRUE` on success, `FALSE` when the given string is not
+ * composed of pairs of hexadecimal digits only.
+ */
+extern BOOL
+UTF8String_decodeHex(
+  _In_ const UTF8String *string,
+  _Out_ LPBYTE output,
+  _Out_ size_t *errorOffsetRef);
+
+/**
+ * @brief Push byte array in Base64 representation (RFC 4648, 4 ASCII
+ * characters for every 3 elements, padded with '=') at the end of the string.
+ *
+ * @param[in,out] string Reference to a VALID `UTF8String` object.
+ * @param[in] byteArraySize The length of the passed byte array.
+ * @param[in] bytes An arbitrary array of bytes.
+ * @return `TRUE` on success, `FALSE` on memory allocation failure.
+ */
+extern BOOL
+UTF8String_pushBytesAsBase64(
+  _Inout_ UTF8String *string,
+  _In_ size_t byteArraySize,
+  _In_ const BYTE *bytes);
+
+/**
+ * @brief Decodes a Base64 representation (RFC 4648, with padding)
+ * into a buffer provided by the caller, without any memory allocation.
+ *
+ * @param[in] string Reference to a VALID and CONSTANT `UTF8String` object
+ * (it can be a view).
+ * @param[out] output Buffer for at least `3 * (string->length / 4)` bytes.
+ * @param[out] byteArraySizeRef Pointer to a variable that will hold
+ * the number of decoded bytes.
+ * @param[out] errorOffsetRef Pointer to a variable that will hold
+ * the offset of the first character outside of the Base64 alphabet
+ * (or of the incomplete last group), or `string->length` on success.
+ * @return `TRUE` on success, `FALSE` when the given string is not
+ * a valid Base64 representation.
+ */
+extern BOOL
+UTF8String_decodeBase64(
+  _In_ const UTF8String *string,
+  _Out_ LPBYTE output,
+  _Out_ size_t *byteArraySizeRef,
+  _Out_ size_t *errorOffsetRef);
+
 /**
  * @brief Generates byte array from a hexadecimal representation
  * (2 ASCII characters for each byte).
@@ -133,7 +215,8 @@ UTF8String_pushBytesAsHex(
  * @param[out] byteArraySizeRef Pointer to a variable that will hold
  * the size of the generated byte array.
  * @param[out] result Pointer to a location that will receive a dynamically
- * allocated array of bytes. It will be `NULL` on memory allocation failure.
+ * allocated array of bytes. It will be `NULL` on memory allocation failure,
+ * and for an empty string (zero bytes, a successful call).
  * @return `TRUE` on success, `FALSE` on memory allocation failure OR
  * when the given string is not composed of hexadecimal characters only.
  *
@@ -175,18 +258,6 @@ UTF8String_matches(
   _In_ const UTF8String *string,
   _In_z_ LPCSTR testedText);
 
-/**
- * @brief Sends the string to Standard Output stream.
- *
- * This method first stores the string length (32-bit integer),
- * then stores the text buffer contents (without the NULL-terminator).
- * @param[in] string Reference to a VALID and CONSTANT `UTF8String` object.
- * @return `TRUE` on success, `FALSE` if the stream-writing functions failed.
- */
-extern BOOL
-UTF8String_writeToStandardOutput(
-  _In_ const UTF8String *string);
-
 
 /**************************************************************/
 /* UTF-16 STRING                                              */
@@ -354,6 +425,22 @@ UTF8_validateTransformation(
   _Inout_ size_t *lengthRef,
   _Out_opt_ uint32_t *codePointRef);
 
+/**
+ * @brief Validates that given byte stream is a sequence of valid UTF-8
+ * representations of Unicode characters.
+ *
+ * ASCII characters are skipped in bulk (with vector instructions where
+ * the processor supports them), so mostly-ASCII text costs about as much
+ * as reading it once.
+ * @param[in] bytes A stream of bytes (can be `NULL` if `length` is zero).
+ * @param[in] length Number of bytes in the stream.
+ * @return `TRUE` if every character is valid, `FALSE` otherwise.
+ */
+extern BOOL
+UTF8_validate(
+  _In_ const BYTE *bytes,
+  _In_ const size_t length);
+
 /**
  * @brief Converts UTF-16 string to an UTF-8 string.
  *